@@ -1,36 +1,39 @@
-#include <mraa/gpio.h>
 #include <unistd.h> // For sleep()
-#include <stdio.h>  // For printf()
+#include <stdio.h>  // For fprintf()
+#include "pinmap.h"
+#include "log.h"
+
+// LED and button pins come from the [button] section of pins.conf
 
 int main() {
     // Initialize GPIO pins
-    mraa_gpio_context gpio;  // LED pin
-    mraa_gpio_context gpiob; // Button pin
+    if (pinmap_setup("button") != 0) {
+        fprintf(stderr, "Failed to initialize GPIO\n");
+        return 1;
+    }
 
-    gpio = mraa_gpio_init(12);  // GPIO pin for the LED
-    gpiob = mraa_gpio_init(13); // GPIO pin for the button
+    int gpio = pinmap_line("led");     // LED line
+    int gpiob = pinmap_line("button"); // Button line
 
-    if (gpio == NULL || gpiob == NULL) {
+    if (gpio < 0 || gpiob < 0) {
         fprintf(stderr, "Failed to initialize GPIO\n");
         return 1;
     }
 
-    // Set LED pin as output and button pin as input
-    mraa_gpio_dir(gpio, MRAA_GPIO_OUT);
-    mraa_gpio_dir(gpiob, MRAA_GPIO_IN);
+    log_init();
 
     while (1) {
         // Read the button state
-        int button = mraa_gpio_read(gpiob);
+        int button = gpio_pool_read(gpiob);
 
         if (button == 0) {
             // Turn LED on when button is pressed
-            mraa_gpio_write(gpio, 1);
-	    printf("Button Pressed\n");
+            gpio_pool_write(gpio, 1);
+            LOG_INFO("Button Pressed\n");
         } else {
             // Turn LED off when button is released
-            mraa_gpio_write(gpio, 0);
-	    printf("Button not Pressed\n");
+            gpio_pool_write(gpio, 0);
+            LOG_INFO("Button not Pressed\n");
         }
 
         // Add a small delay to debounce the button (optional)
@@ -38,9 +41,7 @@ int main() {
     }
 
     // Cleanup (unreachable in this loop)
-    mraa_gpio_close(gpio);
-    mraa_gpio_close(gpiob);
+    pinmap_close_all();
 
     return 0;
 }
-
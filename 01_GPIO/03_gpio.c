@@ -1,64 +1,58 @@
-#include <mraa/gpio.h>
 #include <unistd.h> // For sleep()
 #include <stdio.h>  // For printf()
+#include "pinmap.h"
 
-int main() {
-    // Initialize GPIO pins for LEDs
-    mraa_gpio_context led1 = mraa_gpio_init(36); // LED 1 pin
-    mraa_gpio_context led2 = mraa_gpio_init(12); // LED 2 pin
-    mraa_gpio_context led3 = mraa_gpio_init(40); // LED 3 pin
-
-    // Initialize GPIO pins for switches
-    mraa_gpio_context switch1 = mraa_gpio_init(13); // Switch 1 pin
-    mraa_gpio_context switch2 = mraa_gpio_init(37); // Switch 2 pin
-    mraa_gpio_context switch3 = mraa_gpio_init(39); // Switch 3 pin
+// Pin numbers come from the [switches] section of pins.conf
 
-    if (led1 == NULL || led2 == NULL || led3 == NULL || 
-        switch1 == NULL || switch2 == NULL || switch3 == NULL) {
+int main() {
+    // Initialize GPIO pins; direction and level are set by the pin map
+    if (pinmap_setup("switches") != 0) {
         fprintf(stderr, "Failed to initialize GPIO\n");
         return 1;
     }
 
-    // Set LED pins as output
-    mraa_gpio_dir(led1, MRAA_GPIO_OUT);
-    mraa_gpio_dir(led2, MRAA_GPIO_OUT);
-    mraa_gpio_dir(led3, MRAA_GPIO_OUT);
+    int led1 = pinmap_line("led.0"); // LED 1
+    int led2 = pinmap_line("led.1"); // LED 2
+    int led3 = pinmap_line("led.2"); // LED 3
+    int switch1 = pinmap_line("sw.0"); // Switch 1
+    int switch2 = pinmap_line("sw.1"); // Switch 2
+    int switch3 = pinmap_line("sw.2"); // Switch 3
 
-    // Set switch pins as input
-    mraa_gpio_dir(switch1, MRAA_GPIO_IN);
-    mraa_gpio_dir(switch2, MRAA_GPIO_IN);
-    mraa_gpio_dir(switch3, MRAA_GPIO_IN);
+    if (led1 < 0 || led2 < 0 || led3 < 0 || switch1 < 0 || switch2 < 0 || switch3 < 0) {
+        fprintf(stderr, "Failed to initialize GPIO\n");
+        return 1;
+    }
 
     while (1) {
         // Read the current state of each switch
-        int state1 = mraa_gpio_read(switch1);
-        int state2 = mraa_gpio_read(switch2);
-        int state3 = mraa_gpio_read(switch3);
+        int state1 = gpio_pool_read(switch1);
+        int state2 = gpio_pool_read(switch2);
+        int state3 = gpio_pool_read(switch3);
 
         // Check if switch 1 is pressed
         if (state1 == 0) {
-            mraa_gpio_write(led1, 1); // Turn on LED 1
+            gpio_pool_write(led1, 1); // Turn on LED 1
             printf("Switch 1 Pressed, LED 1 ON\n");
             usleep(500000);          // Keep LED on for 500ms
-            mraa_gpio_write(led1, 0); // Turn off LED 1
+            gpio_pool_write(led1, 0); // Turn off LED 1
             printf("LED 1 OFF\n");
         }
 
         // Check if switch 2 is pressed
 	else if (state2 == 0) {
-            mraa_gpio_write(led2, 1); // Turn on LED 2
+            gpio_pool_write(led2, 1); // Turn on LED 2
             printf("Switch 2 Pressed, LED 2 ON\n");
             usleep(500000);          // Keep LED on for 500ms
-            mraa_gpio_write(led2, 0); // Turn off LED 2
+            gpio_pool_write(led2, 0); // Turn off LED 2
             printf("LED 2 OFF\n");
         }
 
         // Check if switch 3 is pressed
 	else if (state3 == 0) {
-            mraa_gpio_write(led3, 1); // Turn on LED 3
+            gpio_pool_write(led3, 1); // Turn on LED 3
             printf("Switch 3 Pressed, LED 3 ON\n");
             usleep(500000);          // Keep LED on for 500ms
-            mraa_gpio_write(led3, 0); // Turn off LED 3
+            gpio_pool_write(led3, 0); // Turn off LED 3
             printf("LED 3 OFF\n");
         }
 
@@ -67,12 +61,7 @@ int main() {
     }
 
     // Cleanup (unreachable in this loop)
-    mraa_gpio_close(led1);
-    mraa_gpio_close(led2);
-    mraa_gpio_close(led3);
-    mraa_gpio_close(switch1);
-    mraa_gpio_close(switch2);
-    mraa_gpio_close(switch3);
+    pinmap_close_all();
 
     return 0;
 }
@@ -1,39 +1,39 @@
-#include <mraa/gpio.h>
 #include <unistd.h> // For sleep()
 #include <stdio.h>  // For printf()
+#include "pinmap.h"
 
-int main() {
-    // Initialize GPIO pins
-    mraa_gpio_context led = mraa_gpio_init(36);   // LED pin
-    mraa_gpio_context switch1 = mraa_gpio_init(13); // Switch 1 pin
-    mraa_gpio_context switch2 = mraa_gpio_init(37); // Switch 2 pin
+// Pin numbers come from the [switches] section of pins.conf
 
-    if (led == NULL || switch1 == NULL || switch2 == NULL) {
+int main() {
+    // Initialize GPIO pins; direction and level are set by the pin map
+    if (pinmap_setup("switches") != 0) {
         fprintf(stderr, "Failed to initialize GPIO\n");
         return 1;
     }
 
-    // Set LED pin as output
-    mraa_gpio_dir(led, MRAA_GPIO_OUT);
+    int led = pinmap_line("led.0"); // LED
+    int switch1 = pinmap_line("sw.0"); // Switch 1
+    int switch2 = pinmap_line("sw.1"); // Switch 2
 
-    // Set switch pins as input
-    mraa_gpio_dir(switch1, MRAA_GPIO_IN);
-    mraa_gpio_dir(switch2, MRAA_GPIO_IN);
+    if (led < 0 || switch1 < 0 || switch2 < 0) {
+        fprintf(stderr, "Failed to initialize GPIO\n");
+        return 1;
+    }
 
     while (1) {
         // Read the state of switches
-        int state1 = mraa_gpio_read(switch1);
-        int state2 = mraa_gpio_read(switch2);
+        int state1 = gpio_pool_read(switch1);
+        int state2 = gpio_pool_read(switch2);
 
         if (state1 == 0) {
             // If switch 1 is pressed, turn on the LED
-            mraa_gpio_write(led, 1);
+            gpio_pool_write(led, 1);
             printf("Switch 1 Pressed, LED ON\n");
         }
 
         if (state2 == 0) {
             // If switch 2 is pressed, turn off the LED
-            mraa_gpio_write(led, 0);
+            gpio_pool_write(led, 0);
             printf("Switch 2 Pressed, LED OFF\n");
         }
 
@@ -42,9 +42,7 @@ int main() {
     }
 
     // Cleanup (unreachable in this loop)
-    mraa_gpio_close(led);
-    mraa_gpio_close(switch1);
-    mraa_gpio_close(switch2);
+    pinmap_close_all();
 
     return 0;
 }
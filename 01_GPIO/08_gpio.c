@@ -1,44 +1,54 @@
-#include <mraa/gpio.h>
 #include <unistd.h> // For usleep()
 #include <stdio.h>  // For printf()
+#include "pinmap.h"
+#include "metrics.h"
+
+static METRIC_DEFINE(switch_presses, METRIC_COUNTER, "switch_presses_total", "Switch presses detected")
+static METRIC_DEFINE(led_toggles, METRIC_COUNTER, "led_toggles_total", "LED on/off cycles driven")
+
+// Pin numbers come from the [led] and [switch] sections of pins.conf
 
 int main() {
-    // Initialize GPIO pins
-    mraa_gpio_context led = mraa_gpio_init(61);    // LED pin
-    mraa_gpio_context switch1 = mraa_gpio_init(35); // Switch pin
+    // Export counters on a local socket instead of relying on the console
+    metrics_serve(NULL);
 
-    if (led == NULL || switch1 == NULL) {
+    // Initialize GPIO pins; direction and level are set by the pin map
+    if (pinmap_setup("led,switch") != 0) {
         fprintf(stderr, "Failed to initialize GPIO\n");
         return 1;
     }
 
-    // Set LED pin as output
-    mraa_gpio_dir(led, MRAA_GPIO_OUT);
+    int led = pinmap_line("led"); // LED
+    int switch1 = pinmap_line("switch"); // Switch
 
-    // Set switch pin as input
-    mraa_gpio_dir(switch1, MRAA_GPIO_IN);
+    if (led < 0 || switch1 < 0) {
+        fprintf(stderr, "Failed to initialize GPIO\n");
+        return 1;
+    }
 
     int press_count = 0;      // Counter for the number of switch presses
     int prev_state = 1;       // Store the previous state of the switch (1 = not pressed)
 
     // Start with the LED OFF
-    mraa_gpio_write(led, 0);
+    gpio_pool_write(led, 0);
 
     while (1) {
         // Read the current state of the switch
-        int current_state = mraa_gpio_read(switch1);
+        int current_state = gpio_pool_read(switch1);
 
         if (current_state == 0 && prev_state == 1) {
             // Switch pressed (state changed from not pressed to pressed)
             press_count++;
+            metric_inc(&switch_presses);
             printf("Switch pressed %d time(s)\n", press_count);
 
             // Toggle the LED as many times as the press count
             for (int i = 0; i < press_count; i++) {
-                mraa_gpio_write(led, 1);  // Turn LED ON
+                gpio_pool_write(led, 1);  // Turn LED ON
                 usleep(500000);           // 500ms delay
-                mraa_gpio_write(led, 0);  // Turn LED OFF
+                gpio_pool_write(led, 0);  // Turn LED OFF
                 usleep(500000);           // 500ms delay
+                metric_inc(&led_toggles);
             }
 
             // Add a delay to avoid bouncing issues
@@ -53,8 +63,7 @@ int main() {
     }
 
     // Cleanup (unreachable in this loop)
-    mraa_gpio_close(led);
-    mraa_gpio_close(switch1);
+    pinmap_close_all();
 
     return 0;
 }
@@ -1,39 +1,47 @@
-#include <mraa/gpio.h>
 #include <unistd.h> // For usleep()
 #include <stdio.h>  // For printf()
+#include "pinmap.h"
+#include "metrics.h"
+
+static METRIC_DEFINE(switch_presses, METRIC_COUNTER, "switch_presses_total", "Switch presses detected")
+static METRIC_DEFINE(led_toggles, METRIC_COUNTER, "led_toggles_total", "LED on/off cycles driven")
+
+// Pin numbers come from the [leds] and [switch] sections of pins.conf
 
 int main() {
-    // Initialize GPIO pins
-    mraa_gpio_context led1 = mraa_gpio_init(61);    // LED 1 pin
-    mraa_gpio_context led2 = mraa_gpio_init(62);    // LED 2 pin
-    mraa_gpio_context switch1 = mraa_gpio_init(35); // Switch pin
+    // Export counters on a local socket instead of relying on the console
+    metrics_serve(NULL);
 
-    if (led1 == NULL || led2 == NULL || switch1 == NULL) {
+    // Initialize GPIO pins; direction and level are set by the pin map
+    if (pinmap_setup("leds,switch") != 0) {
         fprintf(stderr, "Failed to initialize GPIO\n");
         return 1;
     }
 
-    // Set LED pins as output
-    mraa_gpio_dir(led1, MRAA_GPIO_OUT);
-    mraa_gpio_dir(led2, MRAA_GPIO_OUT);
+    int led1 = pinmap_line("led.1"); // LED 1
+    int led2 = pinmap_line("led.2"); // LED 2
+    int switch1 = pinmap_line("switch"); // Switch
 
-    // Set switch pin as input
-    mraa_gpio_dir(switch1, MRAA_GPIO_IN);
+    if (led1 < 0 || led2 < 0 || switch1 < 0) {
+        fprintf(stderr, "Failed to initialize GPIO\n");
+        return 1;
+    }
 
     int press_count = 0;      // Counter for the number of switch presses
     int prev_state = 1;       // Store the previous state of the switch (1 = not pressed)
 
     // Start with LEDs OFF
-    mraa_gpio_write(led1, 0);
-    mraa_gpio_write(led2, 0);
+    gpio_pool_write(led1, 0);
+    gpio_pool_write(led2, 0);
 
     while (1) {
         // Read the current state of the switch
-        int current_state = mraa_gpio_read(switch1);
+        int current_state = gpio_pool_read(switch1);
 
         if (current_state == 0 && prev_state == 1) {
             // Switch pressed (state changed from not pressed to pressed)
             press_count++;
+            metric_inc(&switch_presses);
             printf("Switch pressed %d time(s)\n", press_count);
 
             // Toggle LED1 and LED2
@@ -42,18 +50,20 @@ int main() {
 
             // Toggle LED1
             for (int i = 0; i < led1_toggles; i++) {
-                mraa_gpio_write(led1, 1);  // Turn LED1 ON
+                gpio_pool_write(led1, 1);  // Turn LED1 ON
                 usleep(500000);            // 500ms delay
-                mraa_gpio_write(led1, 0);  // Turn LED1 OFF
+                gpio_pool_write(led1, 0);  // Turn LED1 OFF
                 usleep(500000);            // 500ms delay
+                metric_inc(&led_toggles);
             }
 
             // Toggle LED2
             for (int i = 0; i < led2_toggles; i++) {
-                mraa_gpio_write(led2, 1);  // Turn LED2 ON
+                gpio_pool_write(led2, 1);  // Turn LED2 ON
                 usleep(250000);            // 250ms delay
-                mraa_gpio_write(led2, 0);  // Turn LED2 OFF
+                gpio_pool_write(led2, 0);  // Turn LED2 OFF
                 usleep(250000);            // 250ms delay
+                metric_inc(&led_toggles);
             }
 
             // Add a delay to avoid bouncing issues
@@ -68,9 +78,7 @@ int main() {
     }
 
     // Cleanup (unreachable in this loop)
-    mraa_gpio_close(led1);
-    mraa_gpio_close(led2);
-    mraa_gpio_close(switch1);
+    pinmap_close_all();
 
     return 0;
 }
@@ -1,93 +1,77 @@
 #include <stdio.h>
 #include <unistd.h>
-#include <mraa.h>
+#include "pinmap.h"
+#include "timing.h"
 
-// Define row and column GPIO pins
-#define ROW1_PIN  12
-#define ROW2_PIN  13
-#define ROW3_PIN  36
-#define ROW4_PIN  37
+// Row and column pins come from the [keypad] section of pins.conf
 
-#define COL1_PIN  40
-#define COL2_PIN  39
-#define COL3_PIN  43
-
-void init_keypad(mraa_gpio_context *row_pins, mraa_gpio_context *col_pins);
-int scan_keypad(mraa_gpio_context *row_pins, mraa_gpio_context *col_pins);
+void init_keypad(int *row_pins, int *col_pins);
+int scan_keypad(int *row_pins, int *col_pins);
 
 int main() {
-    mraa_gpio_context row_pins[4], col_pins[3];
+    int row_pins[4], col_pins[3];  // Keypad GPIO pool lines
+
+    // Open every row and column pin up front
+    if (pinmap_setup("keypad") != 0) {
+        fprintf(stderr, "Failed to set up pin map\n");
+        return 1;
+    }
 
     // Initialize keypad rows and columns
     init_keypad(row_pins, col_pins);
 
+    // Scan every 100 ms on a fixed grid, however long a scan took
+    timing_period_t tick;
+    timing_period_init(&tick, 100 * TIMING_MS);
     while (1) {
         // Scan the keypad and print the corresponding row if a key is pressed
         int row = scan_keypad(row_pins, col_pins);
         if (row != -1) { // If a valid row is pressed
             printf("Key pressed in Row %d!\n", row);
         }
-        usleep(100000); // Small delay for debounce
+        timing_period_wait(&tick);
     }
 
     // Cleanup
-    for (int i = 0; i < 4; i++) {
-        mraa_gpio_close(row_pins[i]);
-    }
-    for (int i = 0; i < 3; i++) {
-        mraa_gpio_close(col_pins[i]);
-    }
+    pinmap_close_all();
 
     return 0;
 }
 
-void init_keypad(mraa_gpio_context *row_pins, mraa_gpio_context *col_pins) {
-    // Initialize row pins (set as output)
-    int row_pins_config[4] = {ROW1_PIN, ROW2_PIN, ROW3_PIN, ROW4_PIN};
-    for (int i = 0; i < 4; i++) {
-        row_pins[i] = mraa_gpio_init(row_pins_config[i]);
-        if (row_pins[i] == NULL) {
-            fprintf(stderr, "Error initializing GPIO for row %d\n", i);
-            continue;
-        }
-        mraa_gpio_dir(row_pins[i], MRAA_GPIO_OUT);
-        mraa_gpio_write(row_pins[i], 1); // Set all rows to HIGH initially
+void init_keypad(int *row_pins, int *col_pins) {
+    // Look up the rows (outputs) and columns (inputs with pull-ups); direction
+    // and mode are set by the pin map
+    if (pinmap_line_array("row.", 0, row_pins, 4) != 0 ||
+        pinmap_line_array("col.", 0, col_pins, 3) != 0) {
+        fprintf(stderr, "Error looking up keypad pins\n");
+        return;
     }
-
-    // Initialize column pins (set as input with pull-up resistors)
-    int col_pins_config[3] = {COL1_PIN, COL2_PIN, COL3_PIN};
-    for (int i = 0; i < 3; i++) {
-        col_pins[i] = mraa_gpio_init(col_pins_config[i]);
-        if (col_pins[i] == NULL) {
-            fprintf(stderr, "Error initializing GPIO for column %d\n", i);
-            continue;
-        }
-        mraa_gpio_dir(col_pins[i], MRAA_GPIO_IN);
-        mraa_gpio_mode(col_pins[i], MRAA_GPIO_PULLUP); // Enable pull-up resistors
+    for (int i = 0; i < 4; i++) {
+        gpio_pool_write(row_pins[i], 1); // Set all rows to HIGH initially
     }
 }
 
-int scan_keypad(mraa_gpio_context *row_pins, mraa_gpio_context *col_pins) {
+int scan_keypad(int *row_pins, int *col_pins) {
     // Loop through each row
     for (int row = 0; row < 4; row++) {
         // Set all rows to HIGH
         for (int r = 0; r < 4; r++) {
-            mraa_gpio_write(row_pins[r], 1);
+            gpio_pool_write(row_pins[r], 1);
         }
 
         // Set the current row to LOW
-        mraa_gpio_write(row_pins[row], 0);
+        gpio_pool_write(row_pins[row], 0);
 
         // Check columns for a pressed key
         for (int col = 0; col < 3; col++) {
-            if (mraa_gpio_read(col_pins[col]) == 0) { // Check if column is pulled LOW
+            if (gpio_pool_read(col_pins[col]) == 0) { // Check if column is pulled LOW
                 // Debounce delay
-                usleep(50000);
+                delay_ms(50);
 
                 // Check again to confirm key press
-                if (mraa_gpio_read(col_pins[col]) == 0) {
+                if (gpio_pool_read(col_pins[col]) == 0) {
                     // Reset the current row to HIGH before returning
-                    mraa_gpio_write(row_pins[row], 1);
+                    gpio_pool_write(row_pins[row], 1);
                     return row + 1; // Return the row number (1-4)
                 }
             }
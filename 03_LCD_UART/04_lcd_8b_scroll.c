@@ -1,23 +1,14 @@
 #include <stdio.h>
 #include <unistd.h>
 #include <mraa.h>
+#include "pinmap.h"
+#include "rt.h"
 
-// Define GPIO pins for LCD (adjust GPIO pin numbers based on your setup)
-#define LCD_RS_PIN    12   // Register Select pin
-#define LCD_RW_PIN    48   // Read/Write pin (set to ground for write mode)
-#define LCD_EN_PIN    13   // Enable pin
-#define LCD_D0_PIN    36   // Data pin 0
-#define LCD_D1_PIN    37   // Data pin 1
-#define LCD_D2_PIN    40   // Data pin 2
-#define LCD_D3_PIN    39   // Data pin 3
-#define LCD_D4_PIN    43   // Data pin 4
-#define LCD_D5_PIN    53   // Data pin 5
-#define LCD_D6_PIN    52   // Data pin 6
-#define LCD_D7_PIN    51   // Data pin 7
-
-// GPIO contexts
-mraa_gpio_context rs, rw, en;
-mraa_gpio_context d[8];
+// LCD pins (RS, RW, EN, D0-D7) come from the [lcd8] section of pins.conf
+
+// GPIO pool lines
+int rs, rw, en;
+int d[8];
 
 // Function prototypes
 void LCD_Init();
@@ -26,11 +17,12 @@ void LCD_SendData(uint8_t data);
 void LCD_Send(uint8_t value, uint8_t mode);
 void LCD_WriteString(const char* str);
 void LCD_Clear(void);
-void delay_ms(int ms);
-void LCD_ScrollMessage(const char* str, int delay_ms);
+void LCD_ScrollMessage(const char* str, int step_ms);
 
 // Main function
 int main() {
+    rt_setup();    // SCHED_FIFO etc. when RT_PRIO is set, for the strobes
+
     // Initialize MRAA library
     if (mraa_init() != MRAA_SUCCESS) {
         fprintf(stderr, "Failed to initialize MRAA\n");
@@ -39,34 +31,18 @@ int main() {
 
     printf("MRAA initialized successfully\n");
 
-    // Initialize control pins (RS, RW, EN)
-    rs = mraa_gpio_init(LCD_RS_PIN);
-    rw = mraa_gpio_init(LCD_RW_PIN);
-    en = mraa_gpio_init(LCD_EN_PIN);
-
-    if (!rs || !rw || !en) {
-        fprintf(stderr, "Failed to initialize control pins\n");
+    // Open and configure all LCD pins in one go
+    if (pinmap_setup("lcd8") != 0) {
+        fprintf(stderr, "Failed to initialize LCD pins\n");
         return 1;
     }
 
-    // Set control pins to output
-    mraa_gpio_dir(rs, MRAA_GPIO_OUT);
-    mraa_gpio_dir(rw, MRAA_GPIO_OUT);
-    mraa_gpio_dir(en, MRAA_GPIO_OUT);
-
-    printf("Control pins initialized\n");
-
-    // Initialize data pins (D0-D7)
-    int data_pins[8] = {LCD_D0_PIN, LCD_D1_PIN, LCD_D2_PIN, LCD_D3_PIN, 
-                        LCD_D4_PIN, LCD_D5_PIN, LCD_D6_PIN, LCD_D7_PIN};
-
-    for (int i = 0; i < 8; i++) {
-        d[i] = mraa_gpio_init(data_pins[i]);
-        if (!d[i]) {
-            fprintf(stderr, "Failed to initialize data pin D%d (GPIO %d)\n", i, data_pins[i]);
-            return 1;
-        }
-        mraa_gpio_dir(d[i], MRAA_GPIO_OUT);
+    rs = pinmap_line("lcd.rs");
+    rw = pinmap_line("lcd.rw");
+    en = pinmap_line("lcd.en");
+    if (rs < 0 || rw < 0 || en < 0 || pinmap_line_array("lcd.d", 0, d, 8) != 0) {
+        fprintf(stderr, "Failed to look up LCD pins\n");
+        return 1;
     }
 
     printf("Data pins initialized\n");
@@ -121,22 +97,22 @@ void LCD_SendData(uint8_t data) {
 // Helper function to send either command or data
 void LCD_Send(uint8_t value, uint8_t mode) {
     // Set RS pin for command/data mode
-    mraa_gpio_write(rs, mode);
+    gpio_pool_write(rs, mode);
 
     // Set RW pin to low (write mode)
-    mraa_gpio_write(rw, 0);
+    gpio_pool_write(rw, 0);
 
     // Set data pins (D0 to D7)
     for (int i = 0; i < 8; i++) {
-        mraa_gpio_write(d[i], (value >> i) & 0x01);
+        gpio_pool_write(d[i], (value >> i) & 0x01);
     }
 
     // Generate a high-to-low pulse on the EN pin
-    mraa_gpio_write(en, 1);
-    delay_ms(1); // Small delay to ensure the LCD registers the data
-    mraa_gpio_write(en, 0);
+    gpio_pool_write(en, 1);
+    delay_us(1); // EN must stay high for at least 450 ns
+    gpio_pool_write(en, 0);
 
-    delay_ms(1); // Wait for the LCD to process the command/data
+    delay_us(50); // Wait for the LCD to process the command/data
 }
 
 // Function to write a string to the LCD
@@ -153,11 +129,16 @@ void LCD_Clear(void) {
 }
 
 // Function to scroll the message on the LCD
-void LCD_ScrollMessage(const char* str, int delay_ms) {
+static rt_latency_t scroll_latency = RT_LATENCY_INIT("lcd scroll");
+
+void LCD_ScrollMessage(const char* str, int step_ms) {
+    timing_period_t tick;
     int len = 0;
     while (str[len] != '\0') len++; // Find the length of the string
     
-    // Display the string and scroll
+    // Display the string and scroll, one shift per period whatever the
+    // redraw took
+    timing_period_init(&tick, step_ms * TIMING_MS);
     for (int i = 0; i < len + 16; i++) { // Loop through for scrolling
         LCD_Clear(); // Clear the display for each scroll
         if (i < len) {
@@ -165,11 +146,7 @@ void LCD_ScrollMessage(const char* str, int delay_ms) {
         } else {
             LCD_WriteString("                "); // Blank spaces to scroll
         }
-        usleep(delay_ms * 1000); // Wait before next shift
+        rt_period_wait(&tick, &scroll_latency); // Wait before next shift
     }
 }
 
-// Delay function (in milliseconds)
-void delay_ms(int ms) {
-    usleep(ms * 1000); // Delay in milliseconds
-}
@@ -3,6 +3,7 @@
 #include <unistd.h>
 #include <mraa.h>
 #include <mraa/uart.h>
+#include "uart_cfg.h"
 
 #define RFID_UART_PORT "/dev/ttyS3"
 #define RFID_UART_BAUDRATE 9600
@@ -11,20 +12,13 @@ int main() {
     mraa_init();
     char buffer[] = "Hello Mraa!";
     
-    mraa_uart_context uart = mraa_uart_init_raw(RFID_UART_PORT);
+    uart_cfg_t cfg;
+    uart_cfg_init(&cfg, RFID_UART_PORT, RFID_UART_BAUDRATE);
+    mraa_uart_context uart = uart_open(&cfg);
     if (uart == NULL) {
-        printf("Failed to initialize UART.\n");
         return 1;
     }
-
-    if (mraa_uart_set_baudrate(uart, RFID_UART_BAUDRATE) != MRAA_SUCCESS) {
-        printf("Failed to set UART baudrate.\n");
-        mraa_uart_stop(uart);
-        return 1;
-    }
-
-    mraa_uart_set_mode(uart, 8, MRAA_UART_PARITY_NONE, 1);
-    mraa_uart_set_flowcontrol(uart, 0, 0);
+    uart_cfg_print(&cfg, stdout);
 
     while (1) {
     	
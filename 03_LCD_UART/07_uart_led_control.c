@@ -4,89 +4,246 @@
 #include <stdbool.h>
 #include <mraa.h>
 #include <mraa/uart.h>
-
-#define LED_PIN 61
-
-void control_led(mraa_gpio_context led, mraa_uart_context uart);
+#include <mraa/pwm.h>
+#include "pinmap.h"
+#include "lcd.h"
+#include "lcd_async.h"
+#include "log.h"
+#include "metrics.h"
+#include "uart_proto.h"
+#include "uart_cfg.h"
+
+static METRIC_DEFINE(frames_ok, METRIC_COUNTER, "panel_frames_total", "Command frames applied")
+static METRIC_DEFINE(frames_bad, METRIC_COUNTER, "panel_frames_rejected_total", "Command frames rejected")
+static METRIC_DEFINE(crc_errors, METRIC_COUNTER, "panel_crc_errors_total", "Frames dropped for a bad CRC")
+
+// Outputs out.0, out.1, ... come from the [panel] section of pins.conf,
+// PWM channels pwm.0, pwm.1, ... from [pwm]. Besides the binary frames of
+// uart_proto.h, the single letters N (on) and F (off) still switch out.0
+// and are echoed back.
+#define PWM_MAX_CHANNELS 4
+
+#define LCD_I2C_BUS 0
+#define LCD_FPS 20
+
+typedef struct {
+    int lines[PROTO_MAX_OUTPUTS];
+    int count;
+    uint32_t levels;
+    mraa_pwm_context pwm[PWM_MAX_CHANNELS];
+    int pwm_count;
+    lcd_t lcd;
+    lcd_async_t screen;
+    bool has_lcd;
+} panel_t;
+
+static panel_t panel;
+
+void control_panel(panel_t *p, mraa_uart_context uart);
 
 int main() {
     char *portname = "/dev/ttyS3";
     mraa_uart_context uart;
-    mraa_gpio_context led;
+    uart_cfg_t cfg;
+
+    log_init();
+    metrics_serve(NULL);
 
-    // Initialize UART
-    uart = mraa_uart_init_raw(portname);
+    // Initialize UART (UART_DEV, UART_BAUD, ... override the defaults)
+    uart_cfg_init(&cfg, portname, 115200);
+    uart = uart_open(&cfg);
     if (uart == NULL) {
-        fprintf(stderr, "Error initializing UART on %s\n", portname);
         return -1;
     }
+    uart_cfg_print(&cfg, stdout);
 
-    if (mraa_uart_set_baudrate(uart, 115200) != MRAA_SUCCESS) {
-        fprintf(stderr, "Error setting baud rate\n");
+    // Initialize the panel outputs, all off
+    if (pinmap_setup("panel,pwm") != 0) {
+        fprintf(stderr, "Error initializing GPIO for the panel\n");
         mraa_uart_stop(uart);
         return -1;
     }
-
-    if (mraa_uart_set_mode(uart, 8, MRAA_UART_PARITY_NONE, 1) != MRAA_SUCCESS) {
-        fprintf(stderr, "Error setting UART mode\n");
-        mraa_uart_stop(uart);
-        return -1;
+    while (panel.count < PROTO_MAX_OUTPUTS) {
+        char name[16];
+        snprintf(name, sizeof(name), "out.%d", panel.count);
+        const pinmap_entry_t *e = pinmap_find(name);
+        if (e == NULL) {
+            break;
+        }
+        panel.lines[panel.count++] = e->line;
     }
-
-    printf("UART initialized successfully on %s\n", portname);
-
-    // Initialize GPIO for LED
-    led = mraa_gpio_init(LED_PIN);
-    if (led == NULL) {
-        fprintf(stderr, "Error initializing GPIO for LED\n");
+    if (panel.count == 0) {
+        fprintf(stderr, "No out.N pins in the panel section\n");
         mraa_uart_stop(uart);
         return -1;
     }
+    gpio_pool_write_lines(panel.lines, panel.count, 0);
+
+    // PWM channels and the I2C LCD are optional: commands for a missing one
+    // are rejected
+    int pwm_pins[PWM_MAX_CHANNELS];
+    panel.pwm_count = pinmap_pin_array("pwm.", pwm_pins, PWM_MAX_CHANNELS);
+    for (int i = 0; i < panel.pwm_count; i++) {
+        panel.pwm[i] = mraa_pwm_init(pwm_pins[i]);
+        if (panel.pwm[i] != NULL) {
+            mraa_pwm_period_us(panel.pwm[i], 1000);
+            mraa_pwm_write(panel.pwm[i], 0.0f);
+            mraa_pwm_enable(panel.pwm[i], 1);
+        }
+    }
+    if (lcd_open_i2c(&panel.lcd, LCD_I2C_BUS, LCD_I2C_DEFAULT_ADDR) == 0) {
+        lcd_init(&panel.lcd);
+        panel.has_lcd = lcd_async_start(&panel.screen, &panel.lcd, LCD_FPS) == 0;
+    }
+    printf("Panel: %d outputs, %d PWM channel(s), %s\n", panel.count, panel.pwm_count,
+           panel.has_lcd ? "LCD" : "no LCD");
 
-    mraa_gpio_dir(led, MRAA_GPIO_OUT);
-
-    // Start controlling the LED
-    control_led(led, uart);
+    // Start serving commands
+    control_panel(&panel, uart);
 
     // Stop UART and GPIO (this is unreachable in the current design)
     mraa_uart_stop(uart);
-    mraa_gpio_close(led);
+    pinmap_close_all();
 
     return 0;
 }
 
-void control_led(mraa_gpio_context led, mraa_uart_context uart) {
-    char buf[1];
+// Check every command of a frame before any of them is applied
+static proto_status_t check(const panel_t *p, const proto_cmd_t *cmds, int n, int *bad) {
+    uint32_t all = p->count == 32 ? 0xFFFFFFFFu : (1u << p->count) - 1;
+
+    for (int i = 0; i < n; i++) {
+        const proto_cmd_t *c = &cmds[i];
+        bool ok = true;
+
+        *bad = i;
+        switch (c->op) {
+        case PROTO_SET:
+        case PROTO_TOGGLE:
+            ok = (c->mask & ~all) == 0;
+            break;
+        case PROTO_PWM:
+            ok = c->channel < p->pwm_count && p->pwm[c->channel] != NULL;
+            break;
+        case PROTO_LCD:
+            ok = p->has_lcd && c->row < p->lcd.rows && c->col < p->lcd.cols;
+            break;
+        case PROTO_CLEAR:
+            ok = p->has_lcd;
+            break;
+        }
+        if (!ok) {
+            return PROTO_ERR_ARG;
+        }
+    }
+    return PROTO_OK;
+}
+
+// Apply a checked batch: the outputs end up in one grouped GPIO write
+static void apply(panel_t *p, const proto_cmd_t *cmds, int n) {
+    uint32_t levels = p->levels;
+
+    for (int i = 0; i < n; i++) {
+        const proto_cmd_t *c = &cmds[i];
+
+        switch (c->op) {
+        case PROTO_SET:
+            levels = (levels & ~c->mask) | (c->levels & c->mask);
+            break;
+        case PROTO_TOGGLE:
+            levels ^= c->mask;
+            break;
+        case PROTO_PWM:
+            mraa_pwm_write(p->pwm[c->channel], c->permille / 1000.0f);
+            break;
+        case PROTO_LCD:
+            lcd_async_printf(&p->screen, c->row, c->col, "%.*s", c->n, c->text);
+            break;
+        case PROTO_CLEAR:
+            lcd_async_clear(&p->screen);
+            break;
+        }
+    }
+    if (levels != p->levels) {
+        gpio_pool_write_lines(p->lines, p->count, levels);
+        p->levels = levels;
+    }
+}
+
+static void handle_frame(panel_t *p, const proto_rx_t *rx, mraa_uart_context uart) {
+    proto_cmd_t cmds[PROTO_MAX_CMDS];
+    proto_tx_t ack;
+    int bad = 0;
+    int n = proto_parse(rx->payload, rx->payload_len, cmds, PROTO_MAX_CMDS, &bad);
+    proto_status_t status = n < 0 ? (proto_status_t)-n : check(p, cmds, n, &bad);
+
+    if (status == PROTO_OK) {
+        apply(p, cmds, n);
+        metric_inc(&frames_ok);
+        LOG_DEBUG("Frame %d: %d commands, outputs 0x%08X\n", rx->seq, n, p->levels);
+    } else {
+        metric_inc(&frames_bad);
+        LOG_WARN("Frame %d rejected: status %d at command %d\n", rx->seq, status, bad);
+    }
+
+    int len = proto_ack(&ack, rx->seq, status, status == PROTO_OK ? 0 : bad, p->levels);
+    if (mraa_uart_write(uart, (const char *)ack.frame, len) != len) {
+        fprintf(stderr, "Error writing to UART\n");
+    }
+}
+
+// The old one letter commands, for a terminal
+static void handle_letter(panel_t *p, char c, mraa_uart_context uart) {
+    if (c == 'N' || c == 'n') {
+        gpio_pool_write(p->lines[0], 1);
+        p->levels |= 1;
+        LOG_INFO("LED turned ON\n");
+    } else if (c == 'F' || c == 'f') {
+        gpio_pool_write(p->lines[0], 0);
+        p->levels &= ~1u;
+        LOG_INFO("LED turned OFF\n");
+    } else {
+        return;
+    }
+
+    // Echo data back
+    if (mraa_uart_write(uart, &c, 1) != 1) {
+        fprintf(stderr, "Error writing to UART\n");
+    }
+}
+
+void control_panel(panel_t *p, mraa_uart_context uart) {
+    proto_rx_t rx;
+    char buf[256];
+    unsigned long last_bad_crc = 0;
+
+    proto_rx_init(&rx);
+    printf("Waiting for UART data...\n");
 
     while (1) {
-        printf("Waiting for UART data...\n");
+        // Block until something arrives instead of polling
+        if (!mraa_uart_data_available(uart, 1000)) {
+            continue;
+        }
         int rdlen = mraa_uart_read(uart, buf, sizeof(buf));
-        if (rdlen > 0) {
-            buf[rdlen] = '\0'; // Null-terminate the received data
+        if (rdlen < 0) {
+            fprintf(stderr, "Error reading from UART\n");
+            continue;
+        }
 
-            printf("Received: %c\n", buf[0]);
+        for (int i = 0; i < rdlen; i++) {
+            uint8_t byte = buf[i];
 
-            // Echo data back
-            int wrlen = mraa_uart_write(uart, buf, rdlen);
-            if (wrlen != rdlen) {
-                fprintf(stderr, "Error writing to UART\n");
+            if (!proto_rx_busy(&rx) && byte != PROTO_SOF) {
+                handle_letter(p, byte, uart);
             }
-
-            // Control the LED
-            if (buf[0] == 'F' || buf[0] == 'f') {
-                mraa_gpio_write(led, 1);
-                printf("LED turned OFF\n");
-            } else if (buf[0] == 'N' || buf[0] == 'n') {
-                mraa_gpio_write(led, 0);
-                printf("LED turned ON\n");
-            } else {
-                printf("Invalid input: %c\n", buf[0]);
+            for (int got = proto_rx_push(&rx, byte); got; got = proto_rx_next(&rx)) {
+                handle_frame(p, &rx, uart);
             }
-        } else if (rdlen < 0) {
-            fprintf(stderr, "Error reading from UART\n");
         }
-
-        usleep(100000); // Small delay to avoid overloading the CPU
+        if (rx.bad_crc != last_bad_crc) {
+            metric_add(&crc_errors, rx.bad_crc - last_bad_crc);
+            last_bad_crc = rx.bad_crc;
+        }
     }
 }
-
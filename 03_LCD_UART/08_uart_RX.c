@@ -1,48 +1,80 @@
 #include <stdio.h>
+#include <stdlib.h>
 #include <string.h>
+#include <signal.h>
 #include <unistd.h>
 #include <stdbool.h>
 #include <mraa.h>
 #include <mraa/uart.h>
+#include "uart_cfg.h"
+#include "uart_log.h"
+#include "uart_sink.h"
+#include "trace.h"
+#include "metrics.h"
+
+static METRIC_DEFINE(rx_bytes, METRIC_COUNTER, "uart_rx_bytes_total", "Bytes received on the UART")
+static METRIC_DEFINE(rx_errors, METRIC_COUNTER, "uart_rx_errors_total", "Failed UART reads")
+static METRIC_DEFINE(read_size, METRIC_HISTOGRAM, "uart_read_bytes", "Bytes returned per UART read")
+
+// UART_CAPTURE=file records everything received, with timestamps, for
+// uart_replay (see uart_log.h)
+static uart_log_t capture;
+static bool capturing;
+static volatile sig_atomic_t stop;
+
+static void on_signal(int sig) {
+    (void)sig;
+    stop = 1;
+}
 
 void receive_data(mraa_uart_context uart);
+int passthrough(const uart_cfg_t *cfg, const char *path);
 
 int main() {
     char *portname = "/dev/ttyS3";
     mraa_uart_context uart;
+    uart_cfg_t cfg;
 
-    // Initialize UART
-    uart = mraa_uart_init_raw(portname);
-    if (uart == NULL) {
-        fprintf(stderr, "Error initializing UART on %s\n", portname);
-        return -1;
-    }
+    TRACE_INIT();
+    metrics_serve(NULL);
 
-    // Set UART parameters
-    if (mraa_uart_set_baudrate(uart, 115200) != MRAA_SUCCESS) {
-        fprintf(stderr, "Error setting baud rate\n");
-        mraa_uart_stop(uart);
-        return -1;
-    }
+    // Ctrl-C interrupts the read (no SA_RESTART) and ends the loop
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
 
-    if (mraa_uart_set_mode(uart, 8, MRAA_UART_PARITY_NONE, 1) != MRAA_SUCCESS) {
-        fprintf(stderr, "Error setting UART mode\n");
-        mraa_uart_stop(uart);
-        return -1;
+    // Initialize UART (UART_DEV, UART_BAUD, ... override the defaults)
+    uart_cfg_init(&cfg, portname, 115200);
+    const char *sink = getenv("UART_SINK");
+    if (sink != NULL && *sink != '\0') {
+        return passthrough(&cfg, sink);
     }
-
-    if (mraa_uart_set_flowcontrol(uart, false, false) != MRAA_SUCCESS) {
-        fprintf(stderr, "Error setting flow control\n");
-        mraa_uart_stop(uart);
+    uart = uart_open(&cfg);
+    if (uart == NULL) {
         return -1;
     }
+    uart_cfg_print(&cfg, stdout);
 
-    printf("UART initialized successfully on %s\n", portname);
+    const char *path = getenv("UART_CAPTURE");
+    if (path != NULL && *path != '\0') {
+        if (uart_log_create(&capture, path) != 0) {
+            mraa_uart_stop(uart);
+            return -1;
+        }
+        capturing = true;
+        printf("Capturing to %s\n", path);
+    }
 
     // Start receiving data
     receive_data(uart);
 
     // Stop UART
+    if (capture.map != NULL) {
+        printf("Captured %llu reads\n", (unsigned long long)capture.hdr->records);
+        uart_log_close(&capture);
+    }
     mraa_uart_stop(uart);
 
     return 0;
@@ -51,13 +83,58 @@ int main() {
 void receive_data(mraa_uart_context uart) {
     char buf[256];
 
-    while (1) {
+    while (!stop) {
         int rdlen = mraa_uart_read(uart, buf, sizeof(buf));
+        TRACE_INSTANT("uart_rx", rdlen);
+        if (rdlen > 0 && capturing && uart_log_append(&capture, buf, rdlen) != 0) {
+            fprintf(stderr, "Capture full, stopped\n");
+            capturing = false;
+        }
         if (rdlen > 0) {
-            buf[rdlen] = '\0'; // Null-terminate the received data
-            printf("Received: %s\n", buf);
-        } else if (rdlen < 0) {
+            // Written as is: binary data may contain NUL bytes
+            metric_add(&rx_bytes, rdlen);
+            metric_observe(&read_size, rdlen);
+            fputs("Received: ", stdout);
+            fwrite(buf, 1, rdlen, stdout);
+            putchar('\n');
+        } else if (rdlen < 0 && !stop) {
+            metric_inc(&rx_errors);
             fprintf(stderr, "Error reading from UART\n");
         }
     }
 }
+
+// UART_SINK=file: log everything received to the file (and to
+// UART_SINK_SOCKET) without it passing through this program, see uart_sink.h
+int passthrough(const uart_cfg_t *cfg, const char *path) {
+    uart_sink_cfg_t scfg;
+    uart_sink_t sink;
+    int fd = uart_open_fd(cfg);
+
+    if (fd < 0) {
+        return -1;
+    }
+    uart_cfg_print(cfg, stdout);
+    uart_sink_cfg_init(&scfg, path);
+    if (uart_sink_open(&sink, fd, &scfg) != 0) {
+        close(fd);
+        return -1;
+    }
+    printf("Logging to %s%s%s, %s\n", path, scfg.socket_path ? " and " : "",
+           scfg.socket_path ? scfg.socket_path : "", sink.cfg.copy ? "read/write" : "splice");
+
+    while (!stop) {
+        long n = uart_sink_pump(&sink, 1000);
+        if (n < 0) {
+            metric_inc(&rx_errors);
+            break;
+        }
+        metric_add(&rx_bytes, n);
+    }
+
+    printf("Logged %llu bytes in %lu wake-ups, %lu rotations; socket took %llu, missed %llu\n",
+           sink.bytes, sink.wakeups, sink.rotations, sink.sock_bytes, sink.sock_dropped);
+    uart_sink_close(&sink);
+    close(fd);
+    return 0;
+}
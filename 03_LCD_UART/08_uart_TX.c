@@ -3,48 +3,33 @@
 #include <unistd.h>
 #include <mraa.h>
 #include <mraa/uart.h>
+#include "uart_cfg.h"
 #include <stdbool.h> 
 int main() {
     char *portname = "/dev/ttyS3";
     mraa_uart_context uart;
+    uart_cfg_t cfg;
     char input[100]; // Buffer for user input
 
-    // Initialize UART
-    uart = mraa_uart_init_raw(portname);
+    // Initialize UART (UART_DEV, UART_BAUD, ... override the defaults)
+    uart_cfg_init(&cfg, portname, 115200);
+    uart = uart_open(&cfg);
     if (uart == NULL) {
-        fprintf(stderr, "Error initializing UART on %s\n", portname);
         return -1;
     }
-
-    // Set UART parameters
-    if (mraa_uart_set_baudrate(uart, 115200) != MRAA_SUCCESS) {
-        fprintf(stderr, "Error setting baud rate\n");
-        mraa_uart_stop(uart);
-        return -1;
-    }
-
-    if (mraa_uart_set_mode(uart, 8, MRAA_UART_PARITY_NONE, 1) != MRAA_SUCCESS) {
-        fprintf(stderr, "Error setting UART mode\n");
-        mraa_uart_stop(uart);
-        return -1;
-    }
-
-    if (mraa_uart_set_flowcontrol(uart, false, false) != MRAA_SUCCESS) {
-        fprintf(stderr, "Error setting flow control\n");
-        mraa_uart_stop(uart);
-        return -1;
-    }
-
-    printf("UART initialized successfully on %s\n", portname);
+    uart_cfg_print(&cfg, stdout);
 
     while (1) {
         // Get input from user
         printf("Enter message: ");
-        fgets(input, sizeof(input), stdin);
+        if (fgets(input, sizeof(input), stdin) == NULL) {
+            break; // End of input
+        }
         input[strcspn(input, "\n")] = '\0'; // Remove newline character
+        int len = strlen(input);
 
         // Transmit data
-        if (mraa_uart_write(uart, input, strlen(input)) != strlen(input)) {
+        if (mraa_uart_write(uart, input, len) != len) {
             fprintf(stderr, "Error writing to UART\n");
         } else {
             printf("Message sent: %s\n", input);
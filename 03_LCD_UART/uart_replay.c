@@ -0,0 +1,185 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pty.h>
+#include <signal.h>
+#include <termios.h>
+#include <unistd.h>
+#include "timing.h"
+#include "uart_log.h"
+
+// Plays a capture made with UART_CAPTURE=file (08_uart_RX) back into a
+// UART program, at the original timing or N times faster.
+//
+//   uart_replay [-s speed] [-n repeat] [-d device] capture.bin
+//
+// Without -d a new pty is made: start the program under test with
+// UART_DEV=<the printed /dev/pts path> (also linked at /tmp/uart-replay);
+// the replay begins when it opens the port. With -d the bytes go to that
+// device, e.g. /tmp/mock-ttyS3 on the host or a serial adapter wired to
+// the board.
+//
+// Writes never block: what the receiving end cannot take in time is
+// counted as dropped, as a UART overruns when nobody reads it. -s 0 sends
+// as fast as the receiver takes the bytes.
+
+#define REPLAY_LINK "/tmp/uart-replay"
+
+static volatile sig_atomic_t stop;
+
+static void on_signal(int sig) {
+    (void)sig;
+    stop = 1;
+}
+
+static void make_raw(int fd) {
+    struct termios tio;
+
+    if (tcgetattr(fd, &tio) == 0) {
+        cfmakeraw(&tio);
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+}
+
+// A pty whose slave we do not hold reports a hangup until someone opens it
+static int wait_for_reader(int master) {
+    struct pollfd pfd = {master, POLLOUT, 0};
+
+    while (!stop) {
+        if (poll(&pfd, 1, 100) > 0 && !(pfd.revents & POLLHUP)) {
+            return 0;
+        }
+    }
+    return -1;
+}
+
+int main(int argc, char **argv) {
+    double speed = 1.0;
+    long repeat = 1;
+    const char *device = NULL;
+    uart_log_t log;
+    int fd, opt;
+
+    while ((opt = getopt(argc, argv, "s:n:d:")) != -1) {
+        switch (opt) {
+        case 's': speed = atof(optarg); break;
+        case 'n': repeat = atol(optarg); break;
+        case 'd': device = optarg; break;
+        default:
+            fprintf(stderr, "Usage: %s [-s speed] [-n repeat] [-d device] capture.bin\n", argv[0]);
+            return 1;
+        }
+    }
+    if (optind != argc - 1 || speed < 0 || repeat < 1) {
+        fprintf(stderr, "Usage: %s [-s speed] [-n repeat] [-d device] capture.bin\n", argv[0]);
+        return 1;
+    }
+    if (uart_log_open(&log, argv[optind]) != 0) {
+        return 1;
+    }
+
+    uint64_t total, span;
+    uart_log_totals(&log, &total, &span);
+    printf("%s: %llu reads, %llu bytes over %.3f s\n", argv[optind],
+           (unsigned long long)log.hdr->records, (unsigned long long)total, span / 1e9);
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+    signal(SIGPIPE, SIG_IGN);
+
+    if (device != NULL) {
+        fd = open(device, O_WRONLY | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+        if (fd < 0) {
+            fprintf(stderr, "Cannot open %s: %s\n", device, strerror(errno));
+            uart_log_close(&log);
+            return 1;
+        }
+        make_raw(fd);
+    } else {
+        char slave[64];
+        int peer;
+
+        if (openpty(&fd, &peer, slave, NULL, NULL) != 0) {
+            fprintf(stderr, "openpty failed: %s\n", strerror(errno));
+            uart_log_close(&log);
+            return 1;
+        }
+        make_raw(fd);
+        make_raw(peer);
+        close(peer);
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        unlink(REPLAY_LINK);
+        if (symlink(slave, REPLAY_LINK) == 0) {
+            printf("Waiting for a reader on %s (%s)\n", slave, REPLAY_LINK);
+        } else {
+            printf("Waiting for a reader on %s\n", slave);
+        }
+        fflush(stdout);
+        if (wait_for_reader(fd) != 0) {
+            close(fd);
+            unlink(REPLAY_LINK);
+            uart_log_close(&log);
+            return 1;
+        }
+    }
+
+    // Send each read at its time from the start, scaled by the speed;
+    // a late record goes at once, it is not skipped
+    uint64_t sent = 0, dropped = 0, max_late = 0;
+    uint64_t start = timing_now_ns(), base = start;
+    for (long r = 0; r < repeat && !stop; r++) {
+        const uart_log_rec_t *rec;
+
+        uart_log_rewind(&log);
+        while (!stop && (rec = uart_log_next(&log)) != NULL) {
+            if (speed > 0) {
+                uint64_t due = base + (uint64_t)(rec->t_ns / speed);
+                uint64_t now = timing_now_ns();
+                if (now < due) {
+                    timing_sleep_until(due);
+                } else if (now - due > max_late) {
+                    max_late = now - due;
+                }
+            }
+            uint32_t off = 0;
+            while (off < rec->len && !stop) {
+                ssize_t n = write(fd, rec->data + off, rec->len - off);
+                if (n < 0 && errno != EAGAIN && errno != EINTR) {
+                    fprintf(stderr, "Reader gone: %s\n", strerror(errno));
+                    stop = 1;
+                    break;
+                }
+                off += n > 0 ? n : 0;
+                if (speed > 0) {
+                    break;
+                }
+                // Flat out: wait for room instead of dropping
+                struct pollfd pfd = {fd, POLLOUT, 0};
+                if (off < rec->len) {
+                    poll(&pfd, 1, 100);
+                }
+            }
+            sent += off;
+            dropped += rec->len - off;
+        }
+        base = timing_now_ns();
+    }
+
+    double elapsed = (timing_now_ns() - start) / 1e9;
+    printf("Replayed %llu bytes in %.3f s (%.0f bytes/s), %llu dropped, %.3f ms max behind\n",
+           (unsigned long long)sent, elapsed, elapsed > 0 ? sent / elapsed : 0.0,
+           (unsigned long long)dropped, max_late / 1e6);
+
+    close(fd);
+    if (device == NULL) {
+        unlink(REPLAY_LINK);
+    }
+    uart_log_close(&log);
+    return dropped > 0 ? 2 : 0;
+}
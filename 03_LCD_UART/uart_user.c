@@ -1,56 +1,56 @@
 #include <stdio.h>
 #include <string.h>
 #include <unistd.h>
-#include <mraa.h>
-#include <mraa/uart.h>
+#include "uart_cfg.h"
+#include "uart_link.h"
 
 // UART Configuration
 #define UART_DEVICE "/dev/ttyS3"  // Adjust based on your UART device
 #define UART_BAUDRATE 9600
 
+// Chat between two boards over the link engine (uart_link.h): what is typed
+// here is sent, what the other side sends is printed as it arrives, without
+// waiting for the next line of input. With the UART looped back, each
+// message comes straight back.
+
+// Runs on the link thread
+static void on_message(void *arg, const uint8_t *data, int len) {
+    (void)arg;
+    printf("\nReceived data: %.*s\n", len, (const char *)data);
+    fflush(stdout);
+}
+
 int main() {
-    // Initialize MRAA library
-    if (mraa_init() != MRAA_SUCCESS) {
-        fprintf(stderr, "Failed to initialize MRAA\n");
-        return 1;
-    }
-    printf("MRAA initialized successfully\n");
+    uart_link_t link;
 
-    // Initialize UART
-    mraa_uart_context uart = mraa_uart_init_raw(UART_DEVICE);
-    if (!uart) {
-        fprintf(stderr, "Failed to initialize UART\n");
+    // Initialize UART (UART_DEV, UART_BAUD, ... override the defaults)
+    uart_cfg_t cfg;
+    uart_cfg_init(&cfg, UART_DEVICE, UART_BAUDRATE);
+    int fd = uart_open_fd(&cfg);
+    if (fd < 0) {
         return 1;
     }
+    uart_cfg_print(&cfg, stdout);
 
-    // Configure UART settings
-    if (mraa_uart_set_baudrate(uart, UART_BAUDRATE) != MRAA_SUCCESS) {
-        fprintf(stderr, "Failed to set UART baudrate\n");
-        mraa_uart_stop(uart);
+    if (uart_link_start(&link, fd, cfg.baud, on_message, NULL) != 0) {
         return 1;
     }
-    mraa_uart_set_mode(uart, 8, MRAA_UART_PARITY_NONE, 1);  // 8N1 mode
-    mraa_uart_set_flowcontrol(uart, 0, 0);                  // Disable flow control
-
-    printf("UART initialized on %s with baudrate %d\n", UART_DEVICE, UART_BAUDRATE);
 
     // Main loop
     while (1) {
         char user_input[128];
-        char recv_buffer[128];
-        int bytes_written, bytes_read;
 
         // Prompt the user for input
         printf("Enter a message to send over UART (or type 'exit' to quit): ");
+        fflush(stdout);
         if (fgets(user_input, sizeof(user_input), stdin) == NULL) {
-            fprintf(stderr, "Error reading user input\n");
-            continue;
+            break;
         }
 
         // Remove the newline character from user input
         size_t len = strlen(user_input);
         if (len > 0 && user_input[len - 1] == '\n') {
-            user_input[len - 1] = '\0';
+            user_input[--len] = '\0';
         }
 
         // Exit the program if the user types "exit"
@@ -58,31 +58,24 @@ int main() {
             printf("Exiting program...\n");
             break;
         }
-
-        // Send the user input over UART
-        bytes_written = mraa_uart_write(uart, user_input, strlen(user_input));
-        if (bytes_written > 0) {
-            printf("Data sent: %s (%d bytes)\n", user_input, bytes_written);
-        } else {
-            fprintf(stderr, "Failed to send data over UART\n");
+        if (len == 0) {
             continue;
         }
 
-        // Wait and receive the data
-        usleep(500000);  // Wait for data to loop back (500ms)
-        bytes_read = mraa_uart_read(uart, recv_buffer, sizeof(recv_buffer) - 1);
-        if (bytes_read > 0) {
-            recv_buffer[bytes_read] = '\0';  // Null-terminate the received string
-            printf("Received data: %s\n", recv_buffer);
-        } else {
-            fprintf(stderr, "No data received over UART\n");
+        // Queue it; the link thread sends it and resends it until acked
+        if (uart_link_send(&link, user_input, len) < 0) {
+            fprintf(stderr, "Link is down\n");
+            break;
         }
+        printf("Data sent: %s (%zu bytes)\n", user_input, len);
     }
 
     // Cleanup
-    mraa_uart_stop(uart);
-    mraa_deinit();
+    if (uart_link_flush(&link, 2000) != 0) {
+        fprintf(stderr, "Not everything was acknowledged\n");
+    }
+    printf("Sent %lu frames (%lu resent), received %lu\n", link.tx_frames, link.retransmits, link.rx_frames);
+    uart_link_stop(&link);
 
     return 0;
 }
-
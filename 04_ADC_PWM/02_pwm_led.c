@@ -1,15 +1,35 @@
 #include <mraa/aio.h>
-#include <mraa/pwm.h>
 #include <stdio.h>
 #include <unistd.h>
+#include "trace.h"
+#include "metrics.h"
+#include "log.h"
+#include "rt.h"
+#include "pinmap.h"
+#include "lcd.h"
+#include "lcd_bar.h"
+#include "pwm_bank.h"
+
+static METRIC_DEFINE(adc_level, METRIC_GAUGE, "adc_level", "Last potentiometer reading (raw ADC)")
+static METRIC_DEFINE(duty_permille, METRIC_GAUGE, "pwm_duty_permille", "Current LED duty cycle in 1/1000")
+static METRIC_DEFINE(pwm_write_ns, METRIC_HISTOGRAM, "pwm_write_latency_ns", "Time spent writing the duty cycle")
 
 #define POTENTIOMETER_PIN 6   // Analog pin connected to the potentiometer
-#define LED_PWM_PIN 72        // PWM pin connected to the LED
-#define MAX_ADC_VALUE 1023.0  // Maximum ADC value for the potentiometer
+#define MAX_ADC_VALUE 1023    // Maximum ADC value for the potentiometer
+#define PWM_PERIOD_NS (20 * TIMING_MS)
+#define LCD_I2C_BUS 0         // Duty meter on the I2C LCD
+#define METER_FPS 30
+
+static rt_latency_t loop_latency = RT_LATENCY_INIT("pwm update");
 
 int main() {
+    rt_setup();    // SCHED_FIFO etc. when RT_PRIO is set
+    TRACE_INIT();
+
     // Initialize MRAA
     mraa_init();
+    metrics_serve(NULL);
+    log_init();
     printf("MRAA Version: %s\n", mraa_get_version());
 
     // Initialize analog input (potentiometer)
@@ -19,48 +39,75 @@ int main() {
         return -1;
     }
 
-    // Initialize PWM output (LED)
-    mraa_pwm_context led_pwm = mraa_pwm_init(LED_PWM_PIN);
-    if (led_pwm == NULL) {
-        fprintf(stderr, "Error initializing PWM on pin %d\n", LED_PWM_PIN);
+    // Initialize PWM output (LED): 20 ms period, enabled, kept open
+    // on pwm.0 of the [pwm] section of pins.conf
+    int led_pin;
+    pwm_bank_t led_pwm;
+    if (pinmap_load(NULL, "pwm") != 0 || pinmap_pin_array("pwm.", &led_pin, 1) != 1) {
+        fprintf(stderr, "No pwm.0 in the [pwm] section of the pin map\n");
         return -1;
     }
-
-    // Set PWM period and enable it
-    if (mraa_pwm_period(led_pwm, 0.02) != MRAA_SUCCESS) { // 20ms period
-        fprintf(stderr, "Failed to set PWM period\n");
+    if (pwm_bank_open(&led_pwm, &led_pin, 1, PWM_PERIOD_NS) != 0) {
+        fprintf(stderr, "Error initializing PWM on pin %d\n", led_pin);
         return -1;
     }
-    if (mraa_pwm_enable(led_pwm, 1) != MRAA_SUCCESS) {
-        fprintf(stderr, "Failed to enable PWM\n");
-        return -1;
+
+    // Duty meter: a label on the first line, the bar on the second
+    lcd_t lcd;
+    lcd_bar_t meter;
+    int have_lcd = 0;
+    if (lcd_open_i2c(&lcd, LCD_I2C_BUS, LCD_I2C_DEFAULT_ADDR) == 0) {
+        lcd_init(&lcd);
+        lcd_write_string(&lcd, "LED duty");  // the percentage goes in columns 12-15
+        have_lcd = lcd_bar_init(&meter, &lcd, 1, 0, lcd.cols, METER_FPS) == 0;
+    } else {
+        fprintf(stderr, "No LCD, duty cycle goes to the log only\n");
     }
 
     printf("Adjust the potentiometer to change the LED intensity.\n");
 
+    // Update every 20 ms on absolute deadlines, so the logging and metrics
+    // in the loop body do not stretch the period; the meter redraws at
+    // most METER_FPS times a second
+    timing_period_t tick;
+    timing_period_init(&tick, 20 * TIMING_MS);
+
     while (1) {
         // Read the potentiometer value (0 to MAX_ADC_VALUE)
         int pot_value = mraa_aio_read(potentiometer);
         if (pot_value < 0) {
-            fprintf(stderr, "Error reading analog value\n");
+            LOG_ERROR("Error reading analog value\n");
+            rt_period_wait(&tick, &loop_latency);
             continue;
         }
 
-        // Map the potentiometer value to a duty cycle (0.0 to 1.0)
-        float duty_cycle = pot_value / MAX_ADC_VALUE;
+        // Map the potentiometer value to the LED's high time, in integer ns
+        uint32_t duty_ns = pwm_bank_fraction_ns(&led_pwm, pot_value, MAX_ADC_VALUE);
+        int permille = pot_value * 1000 / MAX_ADC_VALUE;
 
-        // Set the PWM duty cycle for the LED
-        mraa_pwm_write(led_pwm, duty_cycle);
+        // Set the PWM duty cycle for the LED; unchanged values write nothing
+        TRACE_BEGIN("pwm_write");
+        uint64_t t0 = metrics_now_ns();
+        pwm_bank_update(&led_pwm, &duty_ns);
+        metric_observe(&pwm_write_ns, metrics_now_ns() - t0);
+        TRACE_END("pwm_write");
+        metric_set(&adc_level, pot_value);
+        metric_set(&duty_permille, permille);
+        TRACE_COUNTER("duty_permille", permille);
 
-        // Print the current duty cycle
-        printf("Potentiometer Value: %d, Duty Cycle: %.2f\n", pot_value, duty_cycle);
+        // Show the current duty cycle
+        LOG_DEBUG("Potentiometer Value: %d, Duty Cycle: %d.%d%%\n", pot_value, permille / 10, permille % 10);
+        if (have_lcd) {
+            lcd_printf(&lcd, 0, 12, "%3d%%", (permille + 5) / 10);
+            lcd_bar_update(&meter, pot_value, MAX_ADC_VALUE);
+        }
 
-        usleep(100000); // Delay for 100ms
+        rt_period_wait(&tick, &loop_latency); // Every 20ms
     }
 
     // Clean up
     mraa_aio_close(potentiometer);
-    mraa_pwm_close(led_pwm);
+    pwm_bank_close(&led_pwm);
 
     return 0;
 }
@@ -1,44 +1,51 @@
-#include <mraa/pwm.h>
 #include <stdio.h>
 #include <unistd.h>
+#include "trace.h"
+#include "timing.h"
+#include "pinmap.h"
+#include "pwm_bank.h"
+
+#define DUTY_STEPS 11   // 0%, 10%, ... 100%
 
 int main() {
-    int pwm_pin = 72; // Correct PWM pin for the RuggedBoard
-    float period_sec = 0.02; // 20ms period
-    float duty_cycle = 0.5; // 50% duty cycle
+    int pwm_pin; // pwm.0 of the [pwm] section of pins.conf
+    uint32_t period_ns = 20 * TIMING_MS; // 20ms period
+    int step = 5; // 50% duty cycle
+    pwm_bank_t pwm;
 
-    // Initialize PWM
-    mraa_pwm_context pwm = mraa_pwm_init(pwm_pin);
-    if (pwm == NULL) {
-        printf("Failed to initialize PWM on pin %d\n", pwm_pin);
+    TRACE_INIT();
+
+    if (pinmap_load(NULL, "pwm") != 0 || pinmap_pin_array("pwm.", &pwm_pin, 1) != 1) {
+        printf("No pwm.0 in the [pwm] section of the pin map\n");
         return 1;
     }
 
-    // Set PWM period
-    if (mraa_pwm_period(pwm, period_sec) != MRAA_SUCCESS) {
-        printf("Failed to set PWM period\n");
+    // Initialize PWM: opened, 20 ms period and enabled once, kept open
+    if (pwm_bank_open(&pwm, &pwm_pin, 1, period_ns) != 0) {
+        printf("Failed to initialize PWM on pin %d\n", pwm_pin);
         return 1;
     }
 
-    // Enable PWM
-    if (mraa_pwm_enable(pwm, 1) != MRAA_SUCCESS) {
-        printf("Failed to enable PWM\n");
-        return 1;
+    // The duty cycles in ns, worked out before the loop
+    uint32_t duty_ns[DUTY_STEPS];
+    for (int i = 0; i < DUTY_STEPS; i++) {
+        duty_ns[i] = pwm_bank_fraction_ns(&pwm, i, DUTY_STEPS - 1);
     }
 
-    // Generate PWM signal
+    // Generate PWM signal, stepping every 100 ms on absolute deadlines
+    timing_period_t tick;
+    timing_period_init(&tick, 100 * TIMING_MS);
     while (1) {
-        mraa_pwm_write(pwm, duty_cycle); // Set duty cycle
-        printf("PWM duty cycle: %.2f\n", duty_cycle);
-        duty_cycle += 0.1; // Increment duty cycle
-        if (duty_cycle > 1.0) {
-            duty_cycle = 0.0; // Reset if it exceeds 100%
-        }
-        usleep(100000); // 100ms delay
+        TRACE_BEGIN("pwm_write");
+        pwm_bank_update(&pwm, &duty_ns[step]); // Set duty cycle
+        TRACE_END("pwm_write");
+        printf("PWM duty cycle: %u ns of %u\n", duty_ns[step], period_ns);
+        step = (step + 1) % DUTY_STEPS; // Back to 0% after 100%
+        timing_period_wait(&tick); // 100ms period
     }
 
     // Close PWM (unreachable due to infinite loop)
-    mraa_pwm_close(pwm);
+    pwm_bank_close(&pwm);
     return 0;
 }
 
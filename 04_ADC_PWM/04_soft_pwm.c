@@ -0,0 +1,64 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "pinmap.h"
+#include "rt.h"
+#include "soft_pwm.h"
+
+// The GPIO LEDs of 01_GPIO (36, 61, 62) have no PWM unit, so they are
+// dimmed by the software PWM engine (soft_pwm.h): all three breathe, a
+// third of a cycle apart. SOFT_PWM_BITS and SOFT_PWM_HZ change the
+// resolution and the frame rate; the cost and the edge jitter are printed
+// on Ctrl-C.
+
+#define LED_COUNT 3
+#define PWM_BITS 8            // 256 levels
+#define PWM_HZ 200            // frames a second, well above flicker
+#define BREATH_STEPS 200      // 20 ms steps: a 4 s breath
+
+static volatile sig_atomic_t stop;
+
+static int env_int(const char *name, int def) {
+    const char *v = getenv(name);
+    return (v != NULL && *v != '\0') ? atoi(v) : def;
+}
+
+int main() {
+    int leds[LED_COUNT];
+    soft_pwm_t pwm;
+
+    rt_setup();    // SCHED_FIFO etc. when RT_PRIO is set; the PWM thread inherits it
+    rt_stop_on_signal(&stop);
+
+    if (pinmap_setup("leds") != 0 || pinmap_line_array("led.", 0, leds, LED_COUNT) != 0) {
+        fprintf(stderr, "Failed to initialize GPIO\n");
+        return 1;
+    }
+    if (soft_pwm_init(&pwm, leds, LED_COUNT, env_int("SOFT_PWM_BITS", PWM_BITS), env_int("SOFT_PWM_HZ", PWM_HZ)) != 0 ||
+        soft_pwm_start(&pwm) != 0) {
+        pinmap_close_all();
+        return 1;
+    }
+    uint32_t full = (1u << pwm.bits) - 1;
+    printf("Dimming %d LEDs, %u levels at %llu Hz; Ctrl-C to stop\n", LED_COUNT, full + 1,
+           (unsigned long long)(TIMING_S / pwm.period_ns));
+
+    timing_period_t tick;
+    timing_period_init(&tick, 20 * TIMING_MS);
+
+    for (int step = 0; !stop; step++) {
+        for (int i = 0; i < LED_COUNT; i++) {
+            // Triangle wave, squared so the fade looks even to the eye
+            int pos = (step + i * BREATH_STEPS / LED_COUNT) % BREATH_STEPS;
+            int ramp = pos < BREATH_STEPS / 2 ? pos : BREATH_STEPS - pos;
+            uint64_t level = (uint64_t)ramp * ramp * full / ((BREATH_STEPS / 2) * (BREATH_STEPS / 2));
+            soft_pwm_set(&pwm, i, (uint32_t)level);
+        }
+        timing_period_wait(&tick);
+    }
+
+    soft_pwm_stop(&pwm);    // LEDs off
+    soft_pwm_report(&pwm, stdout);
+    pinmap_close_all();
+
+    return 0;
+}
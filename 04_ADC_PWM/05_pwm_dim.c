@@ -0,0 +1,70 @@
+#include <mraa/aio.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "pinmap.h"
+#include "rt.h"
+#include "pwm_bank.h"
+#include "pwm_dither.h"
+
+// 02_pwm_led without the flicker: the LED on pwm.0 (pins.conf) runs at 4 kHz instead
+// of 50 Hz, and the duty is dithered (pwm_dither.h), one step a period, so
+// the potentiometer still gets 13 bits of brightness, through a gamma
+// curve so that turning it looks even. The cost is printed on Ctrl-C.
+//
+// PWM_STEP_NS is the duty resolution of the PWM unit (its counter clock).
+
+#define POTENTIOMETER_PIN 6   // Analog pin connected to the potentiometer
+#define MAX_ADC_VALUE 1023
+#define PWM_PERIOD_NS (250 * TIMING_US)   // 4 kHz
+#define PWM_STEP_NS 1000
+#define DITHER_BITS 5         // the most at 4 kHz: the slowest pattern is 125 Hz
+
+static volatile sig_atomic_t stop;
+
+int main() {
+    int led_pin;      // pwm.0 of the [pwm] section of pins.conf
+    const char *step = getenv("PWM_STEP_NS");
+    pwm_bank_t led_pwm;
+    pwm_dither_t dim;
+
+    rt_setup();    // SCHED_FIFO etc. when RT_PRIO is set; the dither thread inherits it
+    rt_stop_on_signal(&stop);
+
+    mraa_aio_context potentiometer = mraa_aio_init(POTENTIOMETER_PIN);
+    if (potentiometer == NULL) {
+        fprintf(stderr, "Error initializing analog input on pin %d\n", POTENTIOMETER_PIN);
+        return -1;
+    }
+    if (pinmap_load(NULL, "pwm") != 0 || pinmap_pin_array("pwm.", &led_pin, 1) != 1) {
+        fprintf(stderr, "No pwm.0 in the [pwm] section of the pin map\n");
+        return -1;
+    }
+    if (pwm_bank_open(&led_pwm, &led_pin, 1, PWM_PERIOD_NS) != 0) {
+        fprintf(stderr, "Error initializing PWM on pin %d\n", led_pin);
+        return -1;
+    }
+    if (pwm_dither_init(&dim, &led_pwm, step ? atoi(step) : PWM_STEP_NS, DITHER_BITS) != 0 ||
+        pwm_dither_start(&dim) != 0) {
+        pwm_bank_close(&led_pwm);
+        return -1;
+    }
+    printf("LED at 4 kHz, %.1f bits of brightness; adjust the potentiometer\n", pwm_dither_bits(&dim));
+
+    // The potentiometer is read every 20 ms; the dither thread does the rest
+    timing_period_t tick;
+    timing_period_init(&tick, 20 * TIMING_MS);
+    while (!stop) {
+        int pot_value = mraa_aio_read(potentiometer);
+        if (pot_value >= 0) {
+            pwm_dither_brightness(&dim, 0, (uint16_t)((uint32_t)pot_value * 65535 / MAX_ADC_VALUE));
+        }
+        timing_period_wait(&tick);
+    }
+
+    pwm_dither_stop(&dim);
+    pwm_dither_report(&dim, stdout);
+    pwm_bank_close(&led_pwm);
+    mraa_aio_close(potentiometer);
+
+    return 0;
+}
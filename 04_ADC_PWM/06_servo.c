@@ -0,0 +1,72 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pinmap.h"
+#include "rt.h"
+#include "servo.h"
+
+// Up to three servos on the 20 ms PWM frame, moved through a few poses
+// together (servo.h): each move is planned so that all of them start and
+// arrive at the same time, on an S-curve, or a trapezoid with
+// SERVO_PROFILE=trapezoid. The frame statistics are printed on Ctrl-C.
+//
+// The servos are servo.0, servo.1, ... of the [servo] section of pins.conf.
+// The board has one PWM pin, 72, so one servo; with PWM_SYSFS the
+// chip:channel list picks the channels, one per entry (see pwm_bank.h).
+
+#define SERVO_COUNT 3
+#define POSE_COUNT 4
+#define DWELL_MS 500          // pause at each pose
+
+// Pulse widths in ns
+static const uint32_t poses[POSE_COUNT][SERVO_COUNT] = {
+    {1500000, 1500000, 1500000},   // centre
+    {1000000, 2000000, 1200000},
+    {2000000, 1000000, 1800000},
+    {1250000, 1750000, 1500000},
+};
+
+static volatile sig_atomic_t stop;
+
+int main() {
+    const char *name = getenv("SERVO_PROFILE");
+    servo_profile_t profile = (name != NULL && strcmp(name, "trapezoid") == 0) ? SERVO_TRAPEZOID : SERVO_SCURVE;
+    servo_bank_t servos;
+    int pins[SERVO_COUNT];
+    int count = 0;
+
+    rt_setup();    // SCHED_FIFO etc. when RT_PRIO is set; the frame thread inherits it
+    rt_stop_on_signal(&stop);
+
+    if (pinmap_load(NULL, "servo") == 0) {
+        count = pinmap_pin_array("servo.", pins, SERVO_COUNT);
+    }
+    if (count == 0) {
+        fprintf(stderr, "No servo.0 in the [servo] section of the pin map\n");
+        return -1;
+    }
+    if (servo_open(&servos, pins, count) != 0) {
+        fprintf(stderr, "Error initializing the servo PWM channels\n");
+        return -1;
+    }
+    if (servo_start(&servos) != 0) {
+        servo_close(&servos);
+        return -1;
+    }
+
+    for (int pose = 0; !stop; pose = (pose + 1) % POSE_COUNT) {
+        uint64_t ns = servo_move(&servos, poses[pose], profile);
+        printf("Pose %d, %s, %llu ms\n", pose, profile == SERVO_SCURVE ? "S-curve" : "trapezoid",
+               (unsigned long long)(ns / TIMING_MS));
+        while (servo_busy(&servos) && !stop) {
+            delay_ms(20);
+        }
+        delay_ms(DWELL_MS);
+    }
+
+    servo_stop(&servos);
+    servo_report(&servos, stdout);
+    servo_close(&servos);
+
+    return 0;
+}
@@ -1,23 +1,37 @@
 #include <stdio.h>
 #include <mraa.h>
 #include <unistd.h>
+#include "pinmap.h"
+#include "metrics.h"
+#include "log.h"
+#include "lcd.h"
+#include "lcd_bar.h"
+#include "timing.h"
+
+static METRIC_DEFINE(adc_level, METRIC_GAUGE, "adc_level", "Last analog sound level (raw ADC)")
+static METRIC_DEFINE(sound_events, METRIC_COUNTER, "sound_detected_total", "Samples with the digital output HIGH")
+static METRIC_DEFINE(adc_errors, METRIC_COUNTER, "adc_read_errors_total", "Failed ADC reads")
 
-#define DIGITAL_PIN 12   // Pin connected to KY-037 DO (Digital Output)
 #define ANALOG_PIN 6    // Pin connected to KY-037 AO (Analog Output)
+#define MAX_ADC_VALUE 1023
+#define LCD_I2C_BUS 0    // Level meter on the I2C LCD; the GPIO LCD uses pin 12
+#define METER_FPS 30
+
+// The KY-037 DO (Digital Output) pin comes from the [sound] section of pins.conf
 
 int main() {
     // Initialize MRAA
     mraa_init();
+    metrics_serve(NULL);
+    log_init();
     printf("MRAA Version: %s\n", mraa_get_version());
 
     // Initialize the digital input for DO
-    mraa_gpio_context digital_pin;
-    digital_pin = mraa_gpio_init(DIGITAL_PIN);
-    if (digital_pin == NULL) {
-        fprintf(stderr, "Error initializing GPIO %d\n", DIGITAL_PIN);
+    int digital_pin;
+    if (pinmap_setup("sound") != 0 || (digital_pin = pinmap_line("sound.do")) < 0) {
+        fprintf(stderr, "Error initializing the DO pin\n");
         return -1;
     }
-    mraa_gpio_dir(digital_pin, MRAA_GPIO_IN);
 
     // Initialize the analog input for AO
     mraa_aio_context analog_pin;
@@ -27,28 +41,57 @@ int main() {
         return -1;
     }
 
+    // Level meter: a label on the first line, the bar on the second
+    lcd_t lcd;
+    lcd_bar_t meter;
+    int have_lcd = 0;
+    if (lcd_open_i2c(&lcd, LCD_I2C_BUS, LCD_I2C_DEFAULT_ADDR) == 0) {
+        lcd_init(&lcd);
+        lcd_write_string(&lcd, "Sound");  // level in columns 6-9, DO state in 12-15
+        have_lcd = lcd_bar_init(&meter, &lcd, 1, 0, lcd.cols, METER_FPS) == 0;
+    } else {
+        fprintf(stderr, "No LCD, sound level goes to the log only\n");
+    }
+
+    // Sample every 10 ms; the meter redraws at most METER_FPS times a second
+    timing_period_t tick;
+    int last_detected = -1;
+    timing_period_init(&tick, 10 * TIMING_MS);
+
     while (1) {
-        // Read digital output
-        int sound_detected = mraa_gpio_read(digital_pin);
+        // Read digital output, report changes only
+        int sound_detected = gpio_pool_read(digital_pin);
         if (sound_detected == 1) {
-            printf("Sound detected! (Digital Output HIGH)\n");
-        } else {
-            printf("No sound detected. (Digital Output LOW)\n");
+            metric_inc(&sound_events);
+        }
+        if (sound_detected != last_detected) {
+            last_detected = sound_detected;
+            if (sound_detected == 1) {
+                LOG_INFO("Sound detected! (Digital Output HIGH)\n");
+            } else {
+                LOG_INFO("No sound detected. (Digital Output LOW)\n");
+            }
         }
 
         // Read analog output
         int analog_value = mraa_aio_read(analog_pin);
         if (analog_value < 0) {
-            fprintf(stderr, "Error reading analog value\n");
+            metric_inc(&adc_errors);
+            LOG_ERROR("Error reading analog value\n");
         } else {
-            printf("Analog Sound Level: %d\n", analog_value);
+            metric_set(&adc_level, analog_value);
+            LOG_DEBUG("Analog Sound Level: %d\n", analog_value);
+            if (have_lcd) {
+                lcd_printf(&lcd, 0, 6, "%4d  %4s", analog_value, sound_detected == 1 ? "LOUD" : "");
+                lcd_bar_update(&meter, analog_value, MAX_ADC_VALUE);
+            }
         }
 
-        usleep(500000); // Delay for 500 ms
+        timing_period_wait(&tick);
     }
 
     // Clean up
-    mraa_gpio_close(digital_pin);
+    pinmap_close_all();
     mraa_aio_close(analog_pin);
 
     return 0;
@@ -0,0 +1,276 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <mraa.h>
+#include "bench.h"
+#include "rt.h"
+
+// Bus primitive benchmark for the RuggedBoard drivers.
+//
+//   bench [-n iterations] [-o results.json] [-l] [scenario ...]
+//
+// With no scenario names every scenario runs. Scenarios whose hardware
+// cannot be opened are reported as skipped, so the same binary runs on the
+// board, on mraa's mock platform and on the host mock backend.
+//
+// RT_PRIO/RT_CPU run it in real-time mode (see common/rt.h); compare
+// period_jitter with and without to see what it buys.
+
+static const bench_scenario_t scenarios[] = {
+    {"gpio_toggle",   "GPIO output toggles ([led])",            bench_gpio_toggle,     100000},
+    {"gpio_read",     "GPIO input read latency ([keypad] col.0)", bench_gpio_read,     100000},
+    {"display_digit", "7-segment digit updates ([seg7])",       bench_display_digit,   20000},
+    {"lcd8_char",     "LCD characters, 8-bit GPIO bus",         bench_lcd8_char,       200},
+    {"lcd4_char",     "LCD characters, 4-bit GPIO bus",         bench_lcd4_char,       200},
+    {"lcd_i2c_char",  "LCD characters, I2C backpack",           bench_lcd_i2c_char,    200},
+    {"lcd_bar_frame", "LCD level meter frame, I2C backpack",    bench_lcd_bar_frame,   500},
+    {"lcd_printf",    "LCD counter update with lcd_printf, 8-bit bus", bench_lcd_printf, 500},
+    {"lcd_async_post", "LCD screen posted to the render thread", bench_lcd_async_post, 5000},
+    {"lcd_term_stream", "UART-rate text streamed to the LCD terminal, 4-bit bus", bench_lcd_term_stream, 2000},
+    {"uart_throughput", "UART bulk transfer over a pty",        bench_uart_throughput, 2000},
+    {"uart_rtt",      "UART 1-byte round trip over a pty",      bench_uart_rtt,        5000},
+    {"uart_panel",    "Panel command frame and its ack over a pty", bench_uart_panel,  2000},
+    {"uart_cfg_byte", "UART VMIN 1 VTIME 0: stream, then 1-byte latency", bench_uart_cfg_byte, 2000},
+    {"uart_cfg_batch", "UART VMIN 64 VTIME 1: stream, then 1-byte latency", bench_uart_cfg_batch, 20},
+    {"uart_cfg_fast", "UART 5.19 Mbaud, low latency, RTS/CTS: stream and latency", bench_uart_cfg_fast, 2000},
+    {"uart_log_append", "UART capture: one 64 byte read recorded", bench_uart_log_append, 100000},
+    {"uart_duplex",   "UART link, 253 byte messages both ways over a pty", bench_uart_duplex, 20000},
+    {"uart_lossy",    "UART link over a line that drops bytes, short writes", bench_uart_lossy, 2000},
+    {"uart_sink_splice", "UART log passthrough, 4 KB bursts, splice", bench_uart_sink_splice, 5000},
+    {"uart_sink_copy", "UART log passthrough, 4 KB bursts, read/write", bench_uart_sink_copy, 5000},
+    {"adc_read",      "ADC samples",                            bench_adc_read,        20000},
+    {"pwm_write",     "PWM duty cycle updates",                 bench_pwm_write,       20000},
+    {"soft_pwm_frame", "Software PWM, 3 LEDs, 8 bit 200 Hz: latest edge per frame", bench_soft_pwm_frame, 400},
+    {"soft_pwm_set",  "Software PWM duty updates",              bench_soft_pwm_set,    100000},
+    {"pwm_bank_update", "PWM bank, the [pwm] channels updated together: skew", bench_pwm_bank_update, 20000},
+    {"pwm_dither_tick", "Dithered 4 kHz PWM, the [pwm] channels: one tick", bench_pwm_dither_tick, 20000},
+    {"servo_frame",   "Servos on the [pwm] channels, S-curve moves: frame done after its deadline", bench_servo_frame, 150},
+    {"trace_event",   "One enabled trace point",                bench_trace_event,     100000},
+    {"log_event",     "One LOG_INFO call with two arguments",   bench_log_event,       100000},
+    {"delay_us",      "delay_us(50) overshoot",                 bench_delay_us,        2000},
+    {"period_jitter", "1 ms periodic loop wake-up lateness",   bench_period_jitter,   2000},
+};
+
+#define NUM_SCENARIOS (int)(sizeof(scenarios) / sizeof(scenarios[0]))
+
+long bench_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1000000000L + ts.tv_nsec;
+}
+
+int bench_samples_init(bench_samples_t *s, long cap) {
+    s->ns = malloc(cap * sizeof(long));
+    s->count = 0;
+    s->cap = s->ns ? cap : 0;
+    return s->ns ? 0 : -1;
+}
+
+void bench_samples_free(bench_samples_t *s) {
+    free(s->ns);
+    s->ns = NULL;
+    s->count = s->cap = 0;
+}
+
+static int cmp_long(const void *a, const void *b) {
+    long x = *(const long *)a, y = *(const long *)b;
+    return (x > y) - (x < y);
+}
+
+static long percentile(const long *sorted, long n, double p) {
+    long idx = (long)(p * (n - 1) + 0.5);
+    return sorted[idx];
+}
+
+void bench_finish(bench_samples_t *s, long bytes, bench_result_t *res) {
+    long n = s->count;
+
+    res->iterations = n;
+    if (n == 0) {
+        bench_samples_free(s);
+        return;
+    }
+
+    qsort(s->ns, n, sizeof(long), cmp_long);
+
+    double sum = 0;
+    for (long i = 0; i < n; i++) {
+        sum += s->ns[i];
+    }
+
+    res->mean_ns = sum / n;
+    res->min_ns = s->ns[0];
+    res->max_ns = s->ns[n - 1];
+    res->p50_ns = percentile(s->ns, n, 0.50);
+    res->p90_ns = percentile(s->ns, n, 0.90);
+    res->p99_ns = percentile(s->ns, n, 0.99);
+    res->p999_ns = percentile(s->ns, n, 0.999);
+    // Rates are over the timed sections only, so setup work done between
+    // samples (cursor moves, block refills) does not dilute them
+    res->ops_per_sec = sum > 0 ? n * 1e9 / sum : 0;
+    res->bytes_per_sec = (sum > 0 && bytes > 0) ? bytes * 1e9 / sum : 0;
+
+    bench_samples_free(s);
+}
+
+void bench_finish_latency(bench_samples_t *s, bench_result_t *res) {
+    bench_finish(s, 0, res);
+    res->no_rate = 1;
+    res->ops_per_sec = 0;
+}
+
+int bench_skip(bench_result_t *res, const char *why) {
+    res->skipped = 1;
+    snprintf(res->note, sizeof(res->note), "%s", why);
+    return 1;
+}
+
+static void print_result(const bench_result_t *r) {
+    if (r->skipped) {
+        printf("%-16s skipped: %s\n", r->name, r->note);
+        return;
+    }
+    if (r->no_rate) {
+        printf("%-16s %9s        p50 %8ld  p90 %8ld  p99 %8ld  max %9ld ns",
+               r->name, "", r->p50_ns, r->p90_ns, r->p99_ns, r->max_ns);
+    } else {
+        printf("%-16s %9.0f ops/s  p50 %8ld  p90 %8ld  p99 %8ld  max %9ld ns",
+               r->name, r->ops_per_sec, r->p50_ns, r->p90_ns, r->p99_ns, r->max_ns);
+    }
+    if (r->bytes_per_sec > 0) {
+        printf("  %.0f B/s", r->bytes_per_sec);
+    }
+    if (r->note[0]) {
+        printf("  (%s)", r->note);
+    }
+    printf("\n");
+}
+
+// s as a JSON string, quotes included
+static void json_string(FILE *fp, const char *s) {
+    fputc('"', fp);
+    for (; *s; s++) {
+        unsigned char c = *s;
+        if (c == '"' || c == '\\') {
+            fprintf(fp, "\\%c", c);
+        } else if (c < 0x20) {
+            fprintf(fp, "\\u%04x", c);
+        } else {
+            fputc(c, fp);
+        }
+    }
+    fputc('"', fp);
+}
+
+static void write_json(FILE *fp, const bench_result_t *results, int count) {
+    fprintf(fp, "{\n  \"mraa_version\": ");
+    json_string(fp, mraa_get_version());
+    fprintf(fp, ",\n  \"scenarios\": [\n");
+    for (int i = 0; i < count; i++) {
+        const bench_result_t *r = &results[i];
+        fprintf(fp, "    {\"name\": ");
+        json_string(fp, r->name);
+        fprintf(fp, ", \"skipped\": %s, \"note\": ", r->skipped ? "true" : "false");
+        json_string(fp, r->note);
+        if (!r->skipped) {
+            fprintf(fp, ", \"iterations\": %ld", r->iterations);
+            if (!r->no_rate) {
+                fprintf(fp, ", \"ops_per_sec\": %.1f, \"bytes_per_sec\": %.1f", r->ops_per_sec, r->bytes_per_sec);
+            }
+            fprintf(fp, ", \"latency_ns\": {\"min\": %ld, \"mean\": %.1f, \"p50\": %ld,"
+                        " \"p90\": %ld, \"p99\": %ld, \"p999\": %ld, \"max\": %ld}",
+                    r->min_ns, r->mean_ns, r->p50_ns, r->p90_ns, r->p99_ns, r->p999_ns, r->max_ns);
+        }
+        fprintf(fp, "}%s\n", i + 1 < count ? "," : "");
+    }
+    fprintf(fp, "  ]\n}\n");
+}
+
+static void usage(const char *prog) {
+    fprintf(stderr, "Usage: %s [-n iterations] [-o results.json] [-l] [scenario ...]\n", prog);
+}
+
+int main(int argc, char *argv[]) {
+    long iterations = 0;
+    const char *json_path = NULL;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:o:lh")) != -1) {
+        switch (opt) {
+        case 'n':
+            iterations = atol(optarg);
+            break;
+        case 'o':
+            json_path = optarg;
+            break;
+        case 'l':
+            for (int i = 0; i < NUM_SCENARIOS; i++) {
+                printf("%-16s %s\n", scenarios[i].name, scenarios[i].desc);
+            }
+            return 0;
+        default:
+            usage(argv[0]);
+            return opt == 'h' ? 0 : 2;
+        }
+    }
+
+    rt_setup();
+    if (mraa_init() != MRAA_SUCCESS) {
+        fprintf(stderr, "Failed to initialize MRAA\n");
+        return 1;
+    }
+
+    // Select scenarios, in table order
+    int selected[NUM_SCENARIOS];
+    int num_selected = 0;
+    for (int i = 0; i < NUM_SCENARIOS; i++) {
+        int want = (optind == argc);
+        for (int a = optind; a < argc; a++) {
+            if (strcmp(argv[a], scenarios[i].name) == 0) {
+                want = 1;
+            }
+        }
+        if (want) {
+            selected[num_selected++] = i;
+        }
+    }
+    for (int a = optind; a < argc; a++) {
+        int known = 0;
+        for (int i = 0; i < NUM_SCENARIOS; i++) {
+            known |= strcmp(argv[a], scenarios[i].name) == 0;
+        }
+        if (!known) {
+            fprintf(stderr, "Unknown scenario '%s' (use -l to list)\n", argv[a]);
+            return 2;
+        }
+    }
+
+    bench_result_t results[NUM_SCENARIOS];
+    int failures = 0;
+
+    for (int k = 0; k < num_selected; k++) {
+        const bench_scenario_t *sc = &scenarios[selected[k]];
+        bench_result_t *r = &results[k];
+
+        memset(r, 0, sizeof(*r));
+        r->name = sc->name;
+        if (sc->fn(iterations > 0 ? iterations : sc->default_iterations, r) < 0) {
+            failures++;
+        }
+        print_result(r);
+    }
+
+    if (json_path != NULL) {
+        FILE *fp = fopen(json_path, "w");
+        if (fp == NULL) {
+            fprintf(stderr, "Failed to open %s\n", json_path);
+            return 1;
+        }
+        write_json(fp, results, num_selected);
+        fclose(fp);
+    }
+
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,98 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdio.h>
+
+// Shared helpers for the bus benchmark (bench.c) and its scenarios.
+//
+// Every scenario times single operations with CLOCK_MONOTONIC, collects
+// the samples and hands them to bench_finish(), which fills in the rate
+// and the latency percentiles reported on stdout and in the JSON file.
+
+typedef struct {
+    const char *name;
+    long iterations;
+    double ops_per_sec;
+    double bytes_per_sec;   // 0 when the scenario does not move bytes
+    double mean_ns;
+    long min_ns, p50_ns, p90_ns, p99_ns, p999_ns, max_ns;
+    int skipped;
+    int no_rate;            // samples are lateness or skew, not operation times
+    char note[96];          // skip reason or scenario specific detail
+} bench_result_t;
+
+typedef struct {
+    long *ns;
+    long count;
+    long cap;
+} bench_samples_t;
+
+typedef int (*bench_fn)(long iterations, bench_result_t *res);
+
+typedef struct {
+    const char *name;
+    const char *desc;
+    bench_fn fn;
+    long default_iterations;
+} bench_scenario_t;
+
+long bench_now_ns(void);
+
+int bench_samples_init(bench_samples_t *s, long cap);
+void bench_samples_free(bench_samples_t *s);
+
+static inline void bench_sample(bench_samples_t *s, long ns) {
+    if (s->count < s->cap) {
+        s->ns[s->count++] = ns;
+    }
+}
+
+// Compute percentiles from the samples; 'bytes' is the payload moved in
+// total (0 if not applicable). Frees the samples.
+void bench_finish(bench_samples_t *s, long bytes, bench_result_t *res);
+
+// bench_finish() for samples that are not the time an operation took
+// (wake-up lateness, overshoot, skew): their sum is not time spent in
+// operations, so no rate is reported
+void bench_finish_latency(bench_samples_t *s, bench_result_t *res);
+
+// Mark a scenario as skipped, e.g. when its hardware is not present.
+// Returns 1 so scenarios can 'return bench_skip(...)'.
+int bench_skip(bench_result_t *res, const char *why);
+
+// Scenarios (bench_gpio.c, bench_lcd.c, bench_uart.c, bench_analog.c, bench_trace.c,
+// bench_log.c, bench_timing.c, bench_pwm.c)
+int bench_gpio_toggle(long iterations, bench_result_t *res);
+int bench_gpio_read(long iterations, bench_result_t *res);
+int bench_display_digit(long iterations, bench_result_t *res);
+int bench_lcd8_char(long iterations, bench_result_t *res);
+int bench_lcd4_char(long iterations, bench_result_t *res);
+int bench_lcd_i2c_char(long iterations, bench_result_t *res);
+int bench_lcd_bar_frame(long iterations, bench_result_t *res);
+int bench_lcd_async_post(long iterations, bench_result_t *res);
+int bench_lcd_term_stream(long iterations, bench_result_t *res);
+int bench_lcd_printf(long iterations, bench_result_t *res);
+int bench_uart_throughput(long iterations, bench_result_t *res);
+int bench_uart_rtt(long iterations, bench_result_t *res);
+int bench_uart_panel(long iterations, bench_result_t *res);
+int bench_uart_cfg_byte(long iterations, bench_result_t *res);
+int bench_uart_cfg_batch(long iterations, bench_result_t *res);
+int bench_uart_cfg_fast(long iterations, bench_result_t *res);
+int bench_uart_log_append(long iterations, bench_result_t *res);
+int bench_uart_duplex(long iterations, bench_result_t *res);
+int bench_uart_lossy(long iterations, bench_result_t *res);
+int bench_uart_sink_splice(long iterations, bench_result_t *res);
+int bench_uart_sink_copy(long iterations, bench_result_t *res);
+int bench_adc_read(long iterations, bench_result_t *res);
+int bench_pwm_write(long iterations, bench_result_t *res);
+int bench_soft_pwm_frame(long iterations, bench_result_t *res);
+int bench_soft_pwm_set(long iterations, bench_result_t *res);
+int bench_pwm_bank_update(long iterations, bench_result_t *res);
+int bench_pwm_dither_tick(long iterations, bench_result_t *res);
+int bench_servo_frame(long iterations, bench_result_t *res);
+int bench_trace_event(long iterations, bench_result_t *res);
+int bench_log_event(long iterations, bench_result_t *res);
+int bench_delay_us(long iterations, bench_result_t *res);
+int bench_period_jitter(long iterations, bench_result_t *res);
+
+#endif
@@ -0,0 +1,61 @@
+#include <stdio.h>
+#include <mraa/aio.h>
+#include <mraa/pwm.h>
+#include "bench.h"
+
+// Same channels as 04_ADC_PWM
+#define BENCH_ADC_PIN 6
+#define BENCH_PWM_PIN 72
+
+int bench_adc_read(long iterations, bench_result_t *res) {
+    bench_samples_t s;
+    mraa_aio_context adc = mraa_aio_init(BENCH_ADC_PIN);
+
+    if (adc == NULL) {
+        return bench_skip(res, "ADC not available");
+    }
+    if (bench_samples_init(&s, iterations) != 0) {
+        mraa_aio_close(adc);
+        return -1;
+    }
+
+    for (long i = 0; i < iterations; i++) {
+        long t0 = bench_now_ns();
+        mraa_aio_read(adc);
+        bench_sample(&s, bench_now_ns() - t0);
+    }
+
+    bench_finish(&s, 0, res);
+    mraa_aio_close(adc);
+    return 0;
+}
+
+int bench_pwm_write(long iterations, bench_result_t *res) {
+    bench_samples_t s;
+    mraa_pwm_context pwm = mraa_pwm_init(BENCH_PWM_PIN);
+
+    if (pwm == NULL) {
+        return bench_skip(res, "PWM not available");
+    }
+    if (mraa_pwm_period(pwm, 0.02) != MRAA_SUCCESS || mraa_pwm_enable(pwm, 1) != MRAA_SUCCESS) {
+        mraa_pwm_close(pwm);
+        return bench_skip(res, "PWM period/enable failed");
+    }
+    if (bench_samples_init(&s, iterations) != 0) {
+        mraa_pwm_close(pwm);
+        return -1;
+    }
+
+    // Sweep the duty cycle so every write is a real change
+    for (long i = 0; i < iterations; i++) {
+        float duty = (i % 100) / 100.0f;
+        long t0 = bench_now_ns();
+        mraa_pwm_write(pwm, duty);
+        bench_sample(&s, bench_now_ns() - t0);
+    }
+
+    bench_finish(&s, 0, res);
+    mraa_pwm_enable(pwm, 0);
+    mraa_pwm_close(pwm);
+    return 0;
+}
@@ -0,0 +1,80 @@
+#include <stdio.h>
+#include "pinmap.h"
+#include "gpio_pool.h"
+#include "sevenseg.h"
+#include "bench.h"
+
+int bench_gpio_toggle(long iterations, bench_result_t *res) {
+    bench_samples_t s;
+    int led;
+
+    if (pinmap_setup("led") != 0 || (led = pinmap_line("led")) < 0) {
+        return bench_skip(res, "no [led] pin");
+    }
+    if (bench_samples_init(&s, iterations) != 0) {
+        pinmap_close_all();
+        return -1;
+    }
+
+    // Every write changes the level, so none is filtered by the pool cache
+    for (long i = 0; i < iterations; i++) {
+        long t0 = bench_now_ns();
+        gpio_pool_write(led, i & 1);
+        bench_sample(&s, bench_now_ns() - t0);
+    }
+
+    bench_finish(&s, 0, res);
+    snprintf(res->note, sizeof(res->note), "%s backend",
+             gpio_pool_backend() == GPIO_POOL_CHARDEV ? "chardev" : "mraa");
+    pinmap_close_all();
+    return 0;
+}
+
+int bench_gpio_read(long iterations, bench_result_t *res) {
+    bench_samples_t s;
+    int col;
+
+    if (pinmap_setup("keypad") != 0 || (col = pinmap_line("col.0")) < 0) {
+        return bench_skip(res, "no [keypad] pins");
+    }
+    if (bench_samples_init(&s, iterations) != 0) {
+        pinmap_close_all();
+        return -1;
+    }
+
+    for (long i = 0; i < iterations; i++) {
+        long t0 = bench_now_ns();
+        gpio_pool_read(col);
+        bench_sample(&s, bench_now_ns() - t0);
+    }
+
+    bench_finish(&s, 0, res);
+    pinmap_close_all();
+    return 0;
+}
+
+int bench_display_digit(long iterations, bench_result_t *res) {
+    bench_samples_t s;
+    int seg_pins[NUM_SEGMENTS];
+
+    if (pinmap_setup("seg7") != 0 ||
+        pinmap_line_array("seg.", 0, seg_pins, NUM_SEGMENTS) != 0) {
+        return bench_skip(res, "no [seg7] pins");
+    }
+    if (bench_samples_init(&s, iterations) != 0) {
+        pinmap_close_all();
+        return -1;
+    }
+
+    // Count through 0-9 the way the keypad and counter exercises do
+    for (long i = 0; i < iterations; i++) {
+        long t0 = bench_now_ns();
+        display_digit(i % 10, seg_pins);
+        bench_sample(&s, bench_now_ns() - t0);
+    }
+
+    bench_finish(&s, 0, res);
+    turn_off_7seg(seg_pins);
+    pinmap_close_all();
+    return 0;
+}
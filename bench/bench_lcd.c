@@ -0,0 +1,247 @@
+#include <stdio.h>
+#include <string.h>
+#include "pinmap.h"
+#include "lcd.h"
+#include "lcd_bar.h"
+#include "lcd_async.h"
+#include "timing.h"
+#include "bench.h"
+#ifdef MRAA_MOCK
+#include "mock.h"
+#endif
+
+#define BENCH_LCD_I2C_BUS 0
+
+static const char text[] = "RuggedBoard A5D2X bench 0123456789";
+
+// Time single characters; the cursor is moved back to the start of a row
+// outside the timed section whenever the row is full
+static int run_chars(lcd_t *lcd, long iterations, bench_result_t *res) {
+    bench_samples_t s;
+
+    if (bench_samples_init(&s, iterations) != 0) {
+        return -1;
+    }
+
+    lcd_init(lcd);
+    for (long i = 0; i < iterations; i++) {
+        if (i % lcd->cols == 0) {
+            lcd_set_cursor(lcd, (i / lcd->cols) % lcd->rows, 0);
+        }
+
+        long t0 = bench_now_ns();
+        lcd_data(lcd, text[i % (sizeof(text) - 1)]);
+        bench_sample(&s, bench_now_ns() - t0);
+    }
+
+    bench_finish(&s, 0, res);
+    return 0;
+}
+
+static int run_gpio(const char *section, lcd_bus_t bus, long iterations, bench_result_t *res) {
+    lcd_t lcd;
+    int ret;
+
+    if (pinmap_setup(section) != 0 || lcd_open_gpio(&lcd, bus) != 0) {
+        pinmap_close_all();
+        return bench_skip(res, "LCD pins not available");
+    }
+    ret = run_chars(&lcd, iterations, res);
+    pinmap_close_all();
+    return ret;
+}
+
+int bench_lcd8_char(long iterations, bench_result_t *res) {
+    return run_gpio("lcd8", LCD_BUS_8BIT, iterations, res);
+}
+
+int bench_lcd4_char(long iterations, bench_result_t *res) {
+    return run_gpio("lcd4", LCD_BUS_4BIT, iterations, res);
+}
+
+int bench_lcd_i2c_char(long iterations, bench_result_t *res) {
+    lcd_t lcd;
+    int ret;
+
+    if (lcd_open_i2c(&lcd, BENCH_LCD_I2C_BUS, LCD_I2C_DEFAULT_ADDR) != 0) {
+        return bench_skip(res, "I2C LCD not available");
+    }
+    ret = run_chars(&lcd, iterations, res);
+    lcd_close(&lcd);
+    return ret;
+}
+
+// A counter in a fixed width field, redrawn with lcd_printf() on every
+// increment: mostly only the last digit goes out on the bus
+int bench_lcd_printf(long iterations, bench_result_t *res) {
+    bench_samples_t s;
+    lcd_t lcd;
+    long cells = 0;
+
+    if (pinmap_setup("lcd8") != 0 || lcd_open_gpio(&lcd, LCD_BUS_8BIT) != 0) {
+        pinmap_close_all();
+        return bench_skip(res, "LCD pins not available");
+    }
+    if (bench_samples_init(&s, iterations) != 0) {
+        pinmap_close_all();
+        return -1;
+    }
+
+    lcd_init(&lcd);
+    for (long i = 0; i < iterations; i++) {
+        long t0 = bench_now_ns();
+        cells += lcd_printf(&lcd, 0, 0, "Count %6ld %3.1f", i, i / 10.0);
+        bench_sample(&s, bench_now_ns() - t0);
+    }
+
+    snprintf(res->note, sizeof(res->note), "%.2f of 16 cells sent per update", (double)cells / iterations);
+    pinmap_close_all();
+    bench_finish(&s, 0, res);
+    return 0;
+}
+
+// Cost to the caller of putting a new screen up through the render thread,
+// posting far faster than the 8-bit LCD can be refreshed
+int bench_lcd_async_post(long iterations, bench_result_t *res) {
+    static lcd_async_t screen;
+    bench_samples_t s;
+    lcd_t lcd;
+    char text[LCD_ASYNC_TEXT + 1];
+
+    if (pinmap_setup("lcd8") != 0 || lcd_open_gpio(&lcd, LCD_BUS_8BIT) != 0) {
+        pinmap_close_all();
+        return bench_skip(res, "LCD pins not available");
+    }
+    if (bench_samples_init(&s, iterations) != 0) {
+        pinmap_close_all();
+        return -1;
+    }
+    lcd_init(&lcd);
+    if (lcd_async_start(&screen, &lcd, 30) != 0) {
+        bench_samples_free(&s);
+        pinmap_close_all();
+        return -1;
+    }
+
+    for (long i = 0; i < iterations; i++) {
+        snprintf(text, sizeof(text), "frame %ld", i);
+
+        long t0 = bench_now_ns();
+        lcd_async_show(&screen, text);
+        bench_sample(&s, bench_now_ns() - t0);
+
+        delay_us(100);   // 10000 posts a second
+    }
+    lcd_async_stop(&screen);
+
+    snprintf(res->note, sizeof(res->note), "%lu frames drawn, %lu cells, %lu coalesced",
+             screen.frames, screen.cells, screen.coalesced);
+    pinmap_close_all();
+    bench_finish(&s, 0, res);
+    return 0;
+}
+
+// Lines of text streamed to the terminal in UART sized reads, 64 bytes
+// every 500 us (faster than 115200 baud) on the slower 4-bit bus. At the
+// end the screen has to show the last lines of the stream.
+int bench_lcd_term_stream(long iterations, bench_result_t *res) {
+    static lcd_async_t screen;
+    bench_samples_t s;
+    lcd_t lcd;
+    char chunk[64];
+    long line = 0, bytes = 0;
+    const char *screen_state = "not checked";
+    int fill = 0;
+
+    if (pinmap_setup("lcd4") != 0 || lcd_open_gpio(&lcd, LCD_BUS_4BIT) != 0) {
+        pinmap_close_all();
+        return bench_skip(res, "LCD pins not available");
+    }
+    if (bench_samples_init(&s, iterations) != 0) {
+        pinmap_close_all();
+        return -1;
+    }
+    lcd_init(&lcd);
+    if (lcd_async_start(&screen, &lcd, 20) != 0) {
+        bench_samples_free(&s);
+        pinmap_close_all();
+        return -1;
+    }
+
+    for (long i = 0; i < iterations; i++) {
+        // Lines of varying length, some wider than the display
+        while (fill < (int)sizeof(chunk)) {
+            char text[48];
+            int n = snprintf(text, sizeof(text), "line %ld %.*s\r\n", line, (int)(line % 23), "abcdefghijklmnopqrstuvw");
+            if (fill + n > (int)sizeof(chunk)) {
+                break;
+            }
+            memcpy(chunk + fill, text, n);
+            fill += n;
+            line++;
+        }
+
+        long t0 = bench_now_ns();
+        lcd_async_stream(&screen, chunk, fill);
+        bench_sample(&s, bench_now_ns() - t0);
+
+        bytes += fill;
+        fill = 0;
+        delay_us(500);
+    }
+    lcd_async_stop(&screen);
+
+#ifdef MRAA_MOCK
+    // What the controller holds, as the mock decoded it from the bus, not
+    // what the driver believes it sent
+    screen_state = "ok";
+    for (int r = 0; r < lcd.rows; r++) {
+        char row[LCD_MAX_COLS + 1];
+        if (mock_lcd_row(MOCK_LCD_GPIO, r, row, sizeof(row)) != 0 ||
+            memcmp(row, lcd_term_row(&screen.term, r), lcd.cols) != 0) {
+            screen_state = "stale";
+        }
+    }
+#endif
+    snprintf(res->note, sizeof(res->note), "%lu lines in %lu frames, %lu cells, %lu coalesced, screen %s",
+             screen.term.new_lines, screen.frames, screen.cells, screen.coalesced, screen_state);
+    pinmap_close_all();
+    bench_finish(&s, bytes, res);
+    return 0;
+}
+
+// One level meter frame on the I2C LCD, with the level sweeping up and
+// down by a few pixels per frame like a live signal; no rate limit
+int bench_lcd_bar_frame(long iterations, bench_result_t *res) {
+    bench_samples_t s;
+    lcd_t lcd;
+    lcd_bar_t bar;
+    int level = 0, step = 3;
+
+    if (lcd_open_i2c(&lcd, BENCH_LCD_I2C_BUS, LCD_I2C_DEFAULT_ADDR) != 0) {
+        return bench_skip(res, "I2C LCD not available");
+    }
+    if (bench_samples_init(&s, iterations) != 0) {
+        lcd_close(&lcd);
+        return -1;
+    }
+
+    lcd_init(&lcd);
+    lcd_bar_init(&bar, &lcd, 1, 0, lcd.cols, 0);
+    for (long i = 0; i < iterations; i++) {
+        level += step;
+        if (level <= 0 || level >= 80) {
+            step = -step;
+        }
+
+        long t0 = bench_now_ns();
+        lcd_bar_update(&bar, level, 80);
+        bench_sample(&s, bench_now_ns() - t0);
+    }
+
+    snprintf(res->note, sizeof(res->note), "%.2f cells per frame, %lu glyph uploads",
+             (double)bar.cells_written / bar.frames, lcd.glyphs.uploads);
+    lcd_close(&lcd);
+    bench_finish(&s, 0, res);
+    return 0;
+}
@@ -0,0 +1,41 @@
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "log.h"
+#include "bench.h"
+
+// Cost of a log call on the hot path; the lines themselves go to /dev/null
+int bench_log_event(long iterations, bench_result_t *res) {
+    bench_samples_t s;
+    int null_fd = open("/dev/null", O_WRONLY);
+
+    if (null_fd < 0) {
+        return -1;
+    }
+    if (bench_samples_init(&s, iterations) != 0) {
+        close(null_fd);
+        return -1;
+    }
+
+    log_init();
+    log_set_rate(0);
+
+    fflush(stdout);
+    int saved_fd = dup(STDOUT_FILENO);
+    dup2(null_fd, STDOUT_FILENO);
+
+    for (long i = 0; i < iterations; i++) {
+        long t0 = bench_now_ns();
+        LOG_INFO("bench %ld %s\n", i, "log_event");
+        bench_sample(&s, bench_now_ns() - t0);
+    }
+
+    log_flush();
+    fflush(stdout);
+    dup2(saved_fd, STDOUT_FILENO);
+    close(saved_fd);
+    close(null_fd);
+
+    bench_finish(&s, 0, res);
+    return 0;
+}
@@ -0,0 +1,278 @@
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "pinmap.h"
+#include "soft_pwm.h"
+#include "pwm_bank.h"
+#include "pwm_dither.h"
+#include "servo.h"
+#include "bench.h"
+
+// Software PWM on the [leds] pins, to set against pwm_write (bench_analog.c)
+// on the hardware channel, and the hardware channels of [pwm] driven as a
+// bank
+
+#define BENCH_LED_COUNT 3
+
+static int open_leds(int *leds) {
+    return pinmap_setup("leds") == 0 && pinmap_line_array("led.", 0, leds, BENCH_LED_COUNT) == 0 ? 0 : -1;
+}
+
+// The pins of pwm.0, pwm.1, ...: only 72 on the board. With PWM_SYSFS the
+// chip:channel list picks the channels, one per entry.
+static int pwm_pins(int *pins) {
+    return pinmap_load(NULL, "pwm") == 0 ? pinmap_pin_array("pwm.", pins, PWM_BANK_MAX_CHANNELS) : 0;
+}
+
+static uint64_t thread_cpu_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * TIMING_S + ts.tv_nsec;
+}
+
+// 8 bit frames at 200 Hz, run on this thread: each sample is the latest
+// slot edge of a frame. The note has what the hardware channel does not
+// pay: the CPU share and the wake-ups.
+int bench_soft_pwm_frame(long iterations, bench_result_t *res) {
+    bench_samples_t s;
+    soft_pwm_t pwm;
+    int leds[BENCH_LED_COUNT];
+
+    if (open_leds(leds) != 0) {
+        return bench_skip(res, "no [leds] pins");
+    }
+    if (soft_pwm_init(&pwm, leds, BENCH_LED_COUNT, 8, 200) != 0 || bench_samples_init(&s, iterations) != 0) {
+        pinmap_close_all();
+        return -1;
+    }
+    // Duties with every bit set somewhere, so each frame has all its edges
+    soft_pwm_set(&pwm, 0, 0x55);
+    soft_pwm_set(&pwm, 1, 0xaa);
+    soft_pwm_set(&pwm, 2, 0x81);
+
+    uint64_t cpu0 = thread_cpu_ns(), t0 = timing_now_ns();
+    for (long i = 0; i < iterations; i++) {
+        bench_sample(&s, (long)soft_pwm_frame(&pwm));
+    }
+    uint64_t cpu = thread_cpu_ns() - cpu0, wall = timing_now_ns() - t0;
+
+    bench_finish_latency(&s, res);
+    snprintf(res->note, sizeof(res->note), "CPU %.1f%%, %.0f wake-ups/s, %llu frames missed",
+             100.0 * cpu / wall, pwm.wakeups * (double)TIMING_S / wall, (unsigned long long)pwm.missed);
+    soft_pwm_stop(&pwm);
+    pinmap_close_all();
+    return 0;
+}
+
+// Duty update: a store for the engine to pick up at the next frame
+int bench_soft_pwm_set(long iterations, bench_result_t *res) {
+    bench_samples_t s;
+    soft_pwm_t pwm;
+    int leds[BENCH_LED_COUNT];
+
+    if (open_leds(leds) != 0) {
+        return bench_skip(res, "no [leds] pins");
+    }
+    if (soft_pwm_init(&pwm, leds, BENCH_LED_COUNT, 8, 200) != 0 || bench_samples_init(&s, iterations) != 0) {
+        pinmap_close_all();
+        return -1;
+    }
+
+    for (long i = 0; i < iterations; i++) {
+        long t0 = bench_now_ns();
+        soft_pwm_set(&pwm, i % BENCH_LED_COUNT, i & 0xff);
+        bench_sample(&s, bench_now_ns() - t0);
+    }
+
+    bench_finish(&s, 0, res);
+    soft_pwm_stop(&pwm);
+    pinmap_close_all();
+    return 0;
+}
+
+// A new duty on every channel of the bank, committed together: each sample
+// is the skew, from the start of the first write to the end of the last.
+// The note has the update rate per channel.
+int bench_pwm_bank_update(long iterations, bench_result_t *res) {
+    bench_samples_t s;
+    pwm_bank_t bank;
+    int pins[PWM_BANK_MAX_CHANNELS];
+    uint32_t duty[PWM_BANK_MAX_CHANNELS];
+    int count = pwm_pins(pins);
+
+    if (count == 0 || pwm_bank_open(&bank, pins, count, 20 * TIMING_MS) != 0) {
+        return bench_skip(res, "PWM channels not available");
+    }
+    if (bench_samples_init(&s, iterations) != 0) {
+        pwm_bank_close(&bank);
+        return -1;
+    }
+
+    long t0 = bench_now_ns();
+    for (long i = 0; i < iterations; i++) {
+        // A sweep offset per channel, so every channel changes every time
+        for (int c = 0; c < bank.count; c++) {
+            duty[c] = pwm_bank_fraction_ns(&bank, (i + c * 25) % 100 + 1, 101);
+        }
+        pwm_bank_update(&bank, duty);
+        bench_sample(&s, (long)bank.last_skew_ns);
+    }
+    long wall = bench_now_ns() - t0;
+
+    bench_finish_latency(&s, res);
+    snprintf(res->note, sizeof(res->note), "%d ch via %s, %.0f updates/s per channel",
+             bank.count, bank.backend == PWM_BANK_SYSFS ? "sysfs" : "mraa", iterations * 1e9 / wall);
+    pwm_bank_close(&bank);
+    return 0;
+}
+
+// What the dithering achieves on channel 0, from the steps it writes, as
+// seen through a 10 ms window (one pattern at PWM_DITHER_MIN_HZ, about
+// what the eye averages over). Each fine value is started afresh and the
+// mean of its first window kept: 'levels' is how many different means
+// there are. The window then slides over a whole dither cycle: 'ripple' is
+// the largest swing of its mean, in steps. -1 if a write failed, as the
+// steps read back would then not be what the unit got.
+static int dither_measure(pwm_dither_t *d, uint32_t *levels, double *ripple) {
+    uint32_t window = TIMING_S / PWM_DITHER_MIN_HZ / d->bank->period_ns;
+    uint32_t cycle = 1u << d->frac_bits, steps = d->full >> d->frac_bits;
+    uint64_t worst = 0;
+    int failed = 0;
+
+    if (window == 0) {
+        window = 1;
+    }
+    uint8_t *seen = calloc((uint64_t)steps * window + 1, 1);   // window sums
+    uint32_t *last = malloc(window * sizeof(uint32_t));         // its steps
+    if (seen == NULL || last == NULL) {
+        free(seen);
+        free(last);
+        return -1;
+    }
+
+    *levels = 0;
+    for (uint32_t fine = 0; fine <= d->full; fine++) {
+        uint64_t sum = 0;
+        pwm_dither_set(d, 0, fine);
+        d->acc[0] = 0;
+        for (uint32_t t = 0; t < window; t++) {
+            failed |= pwm_dither_tick(d) < 0;
+            last[t] = d->bank->ch[0].duty_ns / d->step_ns;
+            sum += last[t];
+        }
+        if (!seen[sum]) {
+            seen[sum] = 1;
+            (*levels)++;
+        }
+
+        uint64_t lo = sum, hi = sum;
+        for (uint32_t t = 0; t < cycle; t++) {
+            failed |= pwm_dither_tick(d) < 0;
+            uint32_t step = d->bank->ch[0].duty_ns / d->step_ns;
+            sum = sum - last[t % window] + step;
+            last[t % window] = step;
+            lo = sum < lo ? sum : lo;
+            hi = sum > hi ? sum : hi;
+        }
+        if (hi - lo > worst) {
+            worst = hi - lo;
+        }
+    }
+    *ripple = (double)worst / window;
+    free(seen);
+    free(last);
+    return failed ? -1 : 0;
+}
+
+// A dither tick of the bank at 4 kHz, 1 us steps and as many dither bits
+// as that allows, with every channel dim so that each tick has steps to
+// change. The note has the CPU share at a tick per period, and the
+// resolution measured on channel 0 (dither_measure()): the number of
+// levels in bits and the ripple, against the bits worked out.
+int bench_pwm_dither_tick(long iterations, bench_result_t *res) {
+    bench_samples_t s;
+    pwm_bank_t bank;
+    pwm_dither_t d;
+    int pins[PWM_BANK_MAX_CHANNELS];
+    int count = pwm_pins(pins);
+
+    if (count == 0 || pwm_bank_open(&bank, pins, count, 250 * TIMING_US) != 0) {
+        return bench_skip(res, "PWM channels not available");
+    }
+    if (pwm_dither_init(&d, &bank, 1000, PWM_DITHER_MAX_FRAC_BITS) != 0 ||
+        bench_samples_init(&s, iterations) != 0) {
+        pwm_bank_close(&bank);
+        return -1;
+    }
+    for (int c = 0; c < bank.count; c++) {
+        pwm_dither_brightness(&d, c, 3000 + c * 1111);
+    }
+
+    long total = 0;
+    int failed = 0;
+    for (long i = 0; i < iterations; i++) {
+        long t0 = bench_now_ns();
+        failed |= pwm_dither_tick(&d) < 0;
+        long t = bench_now_ns() - t0;
+        bench_sample(&s, t);
+        total += t;
+    }
+    bench_finish(&s, 0, res);
+
+    uint32_t hz = TIMING_S / bank.period_ns, levels;
+    double ripple;
+    if (failed || dither_measure(&d, &levels, &ripple) != 0) {
+        fprintf(stderr, "pwm_dither_tick: PWM writes failed\n");
+        pwm_bank_close(&bank);
+        return -1;
+    }
+    snprintf(res->note, sizeof(res->note), "CPU %.2f%% at %u Hz, %.1f bits measured of %.1f, ripple %.3f steps",
+             total / (double)iterations * hz / 1e7, hz, log2(levels), pwm_dither_bits(&d), ripple);
+    pwm_bank_close(&bank);
+    return 0;
+}
+
+// Servos on the bank channels, swung between the ends of their range
+// with S-curve moves, on real 20 ms deadlines: each sample is how long
+// after its deadline a frame's writes were done. The note has the work per
+// frame against the 20 ms budget and the frames that overran.
+int bench_servo_frame(long iterations, bench_result_t *res) {
+    bench_samples_t s;
+    servo_bank_t servos;
+    int pins[PWM_BANK_MAX_CHANNELS];
+    uint32_t target[PWM_BANK_MAX_CHANNELS];
+    timing_period_t tick;
+    int count = pwm_pins(pins);
+
+    if (count == 0 || servo_open(&servos, pins, count) != 0) {
+        return bench_skip(res, "PWM channels not available");
+    }
+    if (bench_samples_init(&s, iterations) != 0) {
+        servo_close(&servos);
+        return -1;
+    }
+
+    int side = 0;
+    timing_period_init(&tick, SERVO_FRAME_NS);
+    for (long i = 0; i < iterations; i++) {
+        if (!servo_busy(&servos)) {
+            side = !side;
+            for (int c = 0; c < servos.count; c++) {
+                // Different distances, so the channels are scaled to one time
+                target[c] = side ? SERVO_MAX_NS - c * 100000 : SERVO_MIN_NS + c * 50000;
+            }
+            servo_move(&servos, target, SERVO_SCURVE);
+        }
+        uint64_t deadline = tick.next_ns;
+        timing_period_wait(&tick);
+        servo_frame(&servos, deadline);
+        bench_sample(&s, (long)(timing_now_ns() - deadline));
+    }
+
+    bench_finish_latency(&s, res);
+    snprintf(res->note, sizeof(res->note), "work max %.1f us of 20000, %.2f writes/frame, %llu overruns",
+             servos.max_work_ns / 1e3, (double)servos.writes / servos.frames, (unsigned long long)tick.missed);
+    servo_close(&servos);
+    return 0;
+}
@@ -0,0 +1,45 @@
+#include <stdio.h>
+#include "timing.h"
+#include "bench.h"
+
+// How late delay_us() returns: each sample is the overshoot past the
+// requested 50 us, the LCD's command execution time
+int bench_delay_us(long iterations, bench_result_t *res) {
+    bench_samples_t s;
+
+    if (bench_samples_init(&s, iterations) != 0) {
+        return -1;
+    }
+    timing_init();
+
+    for (long i = 0; i < iterations; i++) {
+        long t0 = bench_now_ns();
+        delay_us(50);
+        bench_sample(&s, bench_now_ns() - t0 - 50 * (long)TIMING_US);
+    }
+
+    bench_finish_latency(&s, res);
+    return 0;
+}
+
+// Wake-up jitter of a 1 ms periodic loop: each sample is how far past its
+// deadline the loop woke up
+int bench_period_jitter(long iterations, bench_result_t *res) {
+    bench_samples_t s;
+    timing_period_t tick;
+
+    if (bench_samples_init(&s, iterations) != 0) {
+        return -1;
+    }
+    timing_period_init(&tick, TIMING_MS);
+
+    for (long i = 0; i < iterations; i++) {
+        uint64_t deadline = tick.next_ns;
+        timing_period_wait(&tick);
+        bench_sample(&s, (long)(timing_now_ns() - deadline));
+    }
+
+    snprintf(res->note, sizeof(res->note), "%llu periods missed", (unsigned long long)tick.missed);
+    bench_finish_latency(&s, res);
+    return 0;
+}
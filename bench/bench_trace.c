@@ -0,0 +1,30 @@
+#include <stdio.h>
+#include "trace.h"
+#include "bench.h"
+
+// Cost of one enabled trace point, to keep the instrumentation honest
+int bench_trace_event(long iterations, bench_result_t *res) {
+#ifdef TRACE_ENABLE
+    bench_samples_t s;
+    int was_enabled = trace_enabled;
+
+    if (bench_samples_init(&s, iterations) != 0) {
+        return -1;
+    }
+
+    trace_init();
+    trace_set_enabled(1);
+    for (long i = 0; i < iterations; i++) {
+        long t0 = bench_now_ns();
+        TRACE_INSTANT("bench", i);
+        bench_sample(&s, bench_now_ns() - t0);
+    }
+    trace_set_enabled(was_enabled);
+
+    bench_finish(&s, 0, res);
+    return 0;
+#else
+    (void)iterations;
+    return bench_skip(res, "built without TRACE_ENABLE");
+#endif
+}
@@ -0,0 +1,694 @@
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <termios.h>
+#include <pty.h>
+#include <sys/resource.h>
+#include <sys/socket.h>
+#include <mraa/uart.h>
+#include "uart_proto.h"
+#include "uart_cfg.h"
+#include "uart_log.h"
+#include "uart_link.h"
+#include "uart_sink.h"
+#include "bench.h"
+
+#define BLOCK_SIZE 256
+
+// A pty pair stands in for the two ends of a serial cable: the program
+// under test opens the slave through mraa, the bench drives the master
+typedef struct {
+    int master;
+    int slave;
+    char path[64];
+    mraa_uart_context uart;
+    volatile int stop;
+} pty_link_t;
+
+// 'cfg' gives the settings for the slave end; NULL for 115200 8N1. Its
+// device is replaced by the pty's.
+static int link_open_cfg(pty_link_t *link, const uart_cfg_t *cfg) {
+    struct termios tio;
+    uart_cfg_t c = {NULL, 115200, -1, -1, false, false};
+
+    memset(link, 0, sizeof(*link));
+    if (openpty(&link->master, &link->slave, link->path, NULL, NULL) != 0) {
+        return -1;
+    }
+
+    // Raw on both ends so no byte is echoed or translated
+    tcgetattr(link->master, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(link->master, TCSANOW, &tio);
+
+    if (cfg != NULL) {
+        c = *cfg;
+    }
+    c.dev = link->path;
+    link->uart = uart_open(&c);
+    if (link->uart == NULL) {
+        close(link->master);
+        close(link->slave);
+        return -1;
+    }
+    return 0;
+}
+
+static int link_open(pty_link_t *link) {
+    return link_open_cfg(link, NULL);
+}
+
+static void link_close(pty_link_t *link) {
+    mraa_uart_stop(link->uart);
+    close(link->master);
+    close(link->slave);
+}
+
+static int read_full(mraa_uart_context uart, char *buf, int len) {
+    int got = 0;
+    while (got < len) {
+        int n = mraa_uart_read(uart, buf + got, len - got);
+        if (n <= 0) {
+            return -1;
+        }
+        got += n;
+    }
+    return got;
+}
+
+// Feed blocks from the master side; the timed reader drains them through mraa
+int bench_uart_throughput(long iterations, bench_result_t *res) {
+    pty_link_t link;
+    bench_samples_t s;
+    char out[BLOCK_SIZE], in[BLOCK_SIZE];
+
+    if (link_open(&link) != 0) {
+        return bench_skip(res, "pty or mraa UART not available");
+    }
+    if (bench_samples_init(&s, iterations) != 0) {
+        link_close(&link);
+        return -1;
+    }
+
+    for (int i = 0; i < BLOCK_SIZE; i++) {
+        out[i] = (char)i;
+    }
+
+    int ret = 0;
+    for (long i = 0; i < iterations; i++) {
+        long t0 = bench_now_ns();
+        if (write(link.master, out, BLOCK_SIZE) != BLOCK_SIZE ||
+            read_full(link.uart, in, BLOCK_SIZE) != BLOCK_SIZE) {
+            ret = -1;
+            break;
+        }
+        bench_sample(&s, bench_now_ns() - t0);
+    }
+
+    long blocks = s.count;
+    bench_finish(&s, blocks * BLOCK_SIZE, res);
+    snprintf(res->note, sizeof(res->note), "%d byte blocks, %s", BLOCK_SIZE, link.path);
+    link_close(&link);
+    return ret;
+}
+
+// Echo everything received on the master back to the slave
+static void *echo_thread(void *arg) {
+    pty_link_t *link = arg;
+    char buf[BLOCK_SIZE];
+
+    while (!link->stop) {
+        ssize_t n = read(link->master, buf, sizeof(buf));
+        if (n <= 0) {
+            break;
+        }
+        if (write(link->master, buf, n) != n) {
+            break;
+        }
+    }
+    return NULL;
+}
+
+int bench_uart_rtt(long iterations, bench_result_t *res) {
+    pty_link_t link;
+    bench_samples_t s;
+    pthread_t echo;
+    char c = 'x';
+
+    if (link_open(&link) != 0) {
+        return bench_skip(res, "pty or mraa UART not available");
+    }
+    if (bench_samples_init(&s, iterations) != 0) {
+        link_close(&link);
+        return -1;
+    }
+    pthread_create(&echo, NULL, echo_thread, &link);
+
+    int ret = 0;
+    for (long i = 0; i < iterations; i++) {
+        long t0 = bench_now_ns();
+        if (mraa_uart_write(link.uart, &c, 1) != 1 || read_full(link.uart, &c, 1) != 1) {
+            ret = -1;
+            break;
+        }
+        bench_sample(&s, bench_now_ns() - t0);
+    }
+
+    bench_finish(&s, 0, res);
+    snprintf(res->note, sizeof(res->note), "%s", link.path);
+
+    // Closing the slave wakes the echo thread with EIO
+    link.stop = 1;
+    mraa_uart_stop(link.uart);
+    close(link.slave);
+    pthread_join(echo, NULL);
+    close(link.master);
+    return ret;
+}
+
+// The panel end of 07_uart_led_control, without the hardware: check each
+// frame and ack it
+static void *panel_thread(void *arg) {
+    pty_link_t *link = arg;
+    proto_rx_t rx;
+    proto_cmd_t cmds[PROTO_MAX_CMDS];
+    proto_tx_t ack;
+    uint8_t buf[BLOCK_SIZE];
+    uint32_t levels = 0;
+
+    proto_rx_init(&rx);
+    while (!link->stop) {
+        ssize_t n = read(link->master, buf, sizeof(buf));
+        if (n <= 0) {
+            break;
+        }
+        for (ssize_t i = 0; i < n; i++) {
+            if (!proto_rx_push(&rx, buf[i])) {
+                continue;
+            }
+            int bad = 0;
+            int count = proto_parse(rx.payload, rx.payload_len, cmds, PROTO_MAX_CMDS, &bad);
+            for (int c = 0; c < count; c++) {
+                if (cmds[c].op == PROTO_SET) {
+                    levels = (levels & ~cmds[c].mask) | (cmds[c].levels & cmds[c].mask);
+                } else if (cmds[c].op == PROTO_TOGGLE) {
+                    levels ^= cmds[c].mask;
+                }
+            }
+            int len = proto_ack(&ack, rx.seq, count < 0 ? -count : PROTO_OK, bad, levels);
+            if (write(link->master, ack.frame, len) != len) {
+                return NULL;
+            }
+        }
+    }
+    return NULL;
+}
+
+// A whole panel update in one frame: 8 outputs, a toggle, a PWM duty and
+// both LCD rows, answered by one ack
+int bench_uart_panel(long iterations, bench_result_t *res) {
+    pty_link_t link;
+    bench_samples_t s;
+    pthread_t panel;
+    proto_tx_t tx;
+    proto_rx_t rx;
+    char text[32];
+    long bytes = 0;
+    int ret = 0, len = 0;
+
+    if (link_open(&link) != 0) {
+        return bench_skip(res, "pty or mraa UART not available");
+    }
+    if (bench_samples_init(&s, iterations) != 0) {
+        link_close(&link);
+        return -1;
+    }
+    pthread_create(&panel, NULL, panel_thread, &link);
+    proto_rx_init(&rx);
+
+    for (long i = 0; i < iterations && ret == 0; i++) {
+        proto_begin(&tx, (uint8_t)i);
+        proto_set(&tx, 0xFF, (uint32_t)i & 0xFF);
+        proto_toggle(&tx, 0x01);
+        proto_pwm(&tx, 0, i % 1001);
+        snprintf(text, sizeof(text), "frame %-10ld", i);
+        proto_lcd(&tx, 0, 0, text);
+        proto_lcd(&tx, 1, 0, "panel over UART ");
+        len = proto_end(&tx);
+
+        long t0 = bench_now_ns();
+        if (mraa_uart_write(link.uart, (const char *)tx.frame, len) != len) {
+            ret = -1;
+            break;
+        }
+        // Read until the ack is complete
+        int got = 0;
+        while (!got) {
+            char buf[PROTO_MAX_FRAME];
+            int n = mraa_uart_read(link.uart, buf, sizeof(buf));
+            if (n <= 0) {
+                ret = -1;
+                break;
+            }
+            for (int k = 0; k < n; k++) {
+                got |= proto_rx_push(&rx, buf[k]);
+            }
+        }
+        bench_sample(&s, bench_now_ns() - t0);
+        bytes += len;
+
+        proto_status_t status;
+        int index;
+        uint32_t outputs;
+        if (ret == 0 && (proto_parse_ack(rx.payload, rx.payload_len, &status, &index, &outputs) != 0 ||
+                         status != PROTO_OK || rx.seq != (uint8_t)i ||
+                         outputs != (((uint32_t)i & 0xFF) ^ 0x01))) {
+            snprintf(res->note, sizeof(res->note), "bad ack for frame %ld", i);
+            ret = -1;
+        }
+    }
+
+    bench_finish(&s, bytes, res);
+    if (ret == 0) {
+        snprintf(res->note, sizeof(res->note), "5 commands in %d byte frames, %lu CRC errors", len, rx.bad_crc);
+    }
+
+    // Closing the slave wakes the panel thread with EIO
+    link.stop = 1;
+    mraa_uart_stop(link.uart);
+    close(link.slave);
+    pthread_join(panel, NULL);
+    close(link.master);
+    return ret;
+}
+
+// One UART setting, two measurements over the pty:
+//   throughput: CFG_STREAM bytes written by the master in CFG_BURST byte
+//   pieces, as a UART FIFO hands them over, drained by the reader with 4 KB reads; the note gives MB/s and
+//   how many read() calls each KB took
+//   latency: a single byte from the master to the reader's read() return,
+//   the samples
+#define CFG_STREAM (256 * 1024)
+#define CFG_BURST  16
+
+typedef struct {
+    pty_link_t *link;
+    long sent;
+} stream_arg_t;
+
+static void *stream_thread(void *arg) {
+    stream_arg_t *st = arg;
+    char out[CFG_BURST];
+
+    memset(out, 'u', sizeof(out));
+    while (st->sent < CFG_STREAM) {
+        ssize_t n = write(st->link->master, out, sizeof(out));
+        if (n <= 0) {
+            break;
+        }
+        st->sent += n;
+    }
+    return NULL;
+}
+
+static int uart_cfg_run(const uart_cfg_t *cfg, long iterations, bench_result_t *res) {
+    pty_link_t link;
+    bench_samples_t s;
+    pthread_t writer;
+    stream_arg_t st;
+    char buf[4096];
+    long got = 0, reads = 0;
+    int ret = 0;
+
+    if (link_open_cfg(&link, cfg) != 0) {
+        return bench_skip(res, "pty or mraa UART not available");
+    }
+    if (bench_samples_init(&s, iterations) != 0) {
+        link_close(&link);
+        return -1;
+    }
+
+    st.link = &link;
+    st.sent = 0;
+    long t0 = bench_now_ns();
+    pthread_create(&writer, NULL, stream_thread, &st);
+    while (got < CFG_STREAM) {
+        int n = mraa_uart_read(link.uart, buf, sizeof(buf));
+        if (n <= 0) {
+            ret = -1;
+            break;
+        }
+        got += n;
+        reads++;
+    }
+    long stream_ns = bench_now_ns() - t0;
+    pthread_join(writer, NULL);
+
+    for (long i = 0; i < iterations && ret == 0; i++) {
+        char c = 'x';
+        t0 = bench_now_ns();
+        if (write(link.master, &c, 1) != 1 || mraa_uart_read(link.uart, buf, sizeof(buf)) != 1) {
+            ret = -1;
+            break;
+        }
+        bench_sample(&s, bench_now_ns() - t0);
+    }
+
+    bench_finish(&s, 0, res);
+    if (ret == 0) {
+        snprintf(res->note, sizeof(res->note), "stream %.1f MB/s, %.2f reads/KB",
+                 got * 1000.0 / stream_ns, reads * 1024.0 / got);
+    }
+    link_close(&link);
+    return ret;
+}
+
+// The default: every read returns as soon as one byte is in
+int bench_uart_cfg_byte(long iterations, bench_result_t *res) {
+    uart_cfg_t cfg = {NULL, 115200, 1, 0, false, false};
+    return uart_cfg_run(&cfg, iterations, res);
+}
+
+// Batched: reads wait for 64 bytes or a 100 ms gap, so a lone byte waits
+// out the gap
+int bench_uart_cfg_batch(long iterations, bench_result_t *res) {
+    uart_cfg_t cfg = {NULL, 115200, 64, 1, false, false};
+    return uart_cfg_run(&cfg, iterations, res);
+}
+
+// Low latency and RTS/CTS with the fastest custom rate; a pty takes the
+// termios2 rate but has no serial driver for the low latency flag
+int bench_uart_cfg_fast(long iterations, bench_result_t *res) {
+    uart_cfg_t cfg = {NULL, UART_MAX_BAUD, 1, 0, true, true};
+    return uart_cfg_run(&cfg, iterations, res);
+}
+
+// Recording a receiver's reads: 64 byte records into the mapped capture
+int bench_uart_log_append(long iterations, bench_result_t *res) {
+    uart_log_t log;
+    bench_samples_t s;
+    char path[64], data[64];
+    int ret = 0;
+
+    snprintf(path, sizeof(path), "/tmp/bench-uart-log.%d", (int)getpid());
+    if (uart_log_create(&log, path) != 0) {
+        return bench_skip(res, "cannot create the capture file");
+    }
+    if (bench_samples_init(&s, iterations) != 0) {
+        uart_log_close(&log);
+        unlink(path);
+        return -1;
+    }
+    memset(data, 'c', sizeof(data));
+
+    for (long i = 0; i < iterations; i++) {
+        long t0 = bench_now_ns();
+        if (uart_log_append(&log, data, sizeof(data)) != 0) {
+            ret = -1;
+            break;
+        }
+        bench_sample(&s, bench_now_ns() - t0);
+    }
+
+    bench_finish(&s, s.count * (long)sizeof(data), res);
+    snprintf(res->note, sizeof(res->note), "%llu records, %zu byte file mapping",
+             (unsigned long long)log.hdr->records, log.size);
+    uart_log_close(&log);
+    unlink(path);
+    return ret;
+}
+
+// Full-duplex link between the two ends of a pty: both send LINK_MTU byte
+// messages at once, each checks that the other's stream arrives complete
+// and in order
+typedef struct {
+    uart_link_t link;
+    long expect_bytes;
+    long got;
+    int corrupt;
+    pthread_t sender;
+    long messages;
+} duplex_end_t;
+
+static void duplex_rx(void *arg, const uint8_t *data, int len) {
+    duplex_end_t *end = arg;
+
+    for (int i = 0; i < len; i++) {
+        if (data[i] != (uint8_t)(end->got + i)) {
+            end->corrupt = 1;
+        }
+    }
+    end->got += len;
+}
+
+static void fill(uint8_t *msg, long i) {
+    for (int k = 0; k < LINK_MTU; k++) {
+        msg[k] = (uint8_t)(i * LINK_MTU + k);
+    }
+}
+
+static void *duplex_sender(void *arg) {
+    duplex_end_t *end = arg;
+    uint8_t msg[LINK_MTU];
+
+    for (long i = 0; i < end->messages; i++) {
+        fill(msg, i);
+        if (uart_link_send(&end->link, msg, sizeof(msg)) < 0) {
+            break;
+        }
+    }
+    return NULL;
+}
+
+// A line that loses bytes: one thread per direction copies between two
+// socket pairs in small chunks and drops one byte in 'drop_every'
+typedef struct {
+    int from, to;
+    unsigned drop_every;
+    uint32_t seed;
+    unsigned long dropped;
+    pthread_t thread;
+} lossy_wire_t;
+
+static void *lossy_copy(void *arg) {
+    lossy_wire_t *w = arg;
+    uint8_t buf[64];
+    ssize_t n;
+
+    while ((n = read(w->from, buf, sizeof(buf))) > 0) {
+        int len = 0;
+        for (ssize_t i = 0; i < n; i++) {
+            w->seed = w->seed * 1103515245u + 12345u;
+            if ((w->seed >> 16) % w->drop_every == 0) {
+                w->dropped++;
+            } else {
+                buf[len++] = buf[i];
+            }
+        }
+        if (len > 0 && send(w->to, buf, len, MSG_NOSIGNAL) != len) {
+            break;   // the far end stopped
+        }
+    }
+    return NULL;
+}
+
+// Once both link ends are closed, each copy sees end of file
+static void lossy_join(lossy_wire_t *ab, lossy_wire_t *ba) {
+    pthread_join(ab->thread, NULL);
+    pthread_join(ba->thread, NULL);
+    close(ab->from);
+    close(ba->from);
+}
+
+// Both ends send 'iterations' messages at once. Over a pty, or with lossy
+// set, over socket pairs with small buffers, so that writev() comes back
+// short, and a wire that drops bytes, so that frames are lost and the
+// NAK and timeout paths recover them.
+static int duplex_run(bool lossy, long iterations, bench_result_t *res) {
+    static duplex_end_t a, b;
+    lossy_wire_t ab = {0}, ba = {0};
+    bench_samples_t s;
+    uint8_t msg[LINK_MTU];
+    int fa, fb, ret = 0;
+
+    if (lossy) {
+        int sa[2], sb[2], small = 1;    // the kernel rounds it up to its minimum
+
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sa) != 0) {
+            return bench_skip(res, "socket pairs not available");
+        }
+        if (socketpair(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0, sb) != 0) {
+            close(sa[0]);
+            close(sa[1]);
+            return bench_skip(res, "socket pairs not available");
+        }
+        fa = sa[0];
+        fb = sb[0];
+        setsockopt(fa, SOL_SOCKET, SO_SNDBUF, &small, sizeof(small));
+        setsockopt(fb, SOL_SOCKET, SO_SNDBUF, &small, sizeof(small));
+        ab = (lossy_wire_t){sa[1], sb[1], 4000, 1, 0, 0};
+        ba = (lossy_wire_t){sb[1], sa[1], 4000, 2, 0, 0};
+        pthread_create(&ab.thread, NULL, lossy_copy, &ab);
+        pthread_create(&ba.thread, NULL, lossy_copy, &ba);
+    } else {
+        struct termios tio;
+
+        if (openpty(&fa, &fb, NULL, NULL, NULL) != 0) {
+            return bench_skip(res, "pty not available");
+        }
+        tcgetattr(fa, &tio);
+        cfmakeraw(&tio);
+        tcsetattr(fa, TCSANOW, &tio);
+        tcsetattr(fb, TCSANOW, &tio);
+    }
+    fcntl(fa, F_SETFL, fcntl(fa, F_GETFL) | O_NONBLOCK);
+    fcntl(fb, F_SETFL, fcntl(fb, F_GETFL) | O_NONBLOCK);
+
+    memset(&a, 0, sizeof(a));
+    memset(&b, 0, sizeof(b));
+    if (uart_link_start(&a.link, fa, UART_MAX_BAUD, duplex_rx, &a) != 0) {
+        close(fb);
+        ret = -1;
+    } else if (uart_link_start(&b.link, fb, UART_MAX_BAUD, duplex_rx, &b) != 0) {
+        uart_link_stop(&a.link);
+        ret = -1;
+    } else if (bench_samples_init(&s, iterations) != 0) {
+        uart_link_stop(&a.link);
+        uart_link_stop(&b.link);
+        ret = -1;
+    }
+    if (ret != 0) {
+        if (lossy) {
+            lossy_join(&ab, &ba);
+        }
+        return ret;
+    }
+
+    // b sends from its own thread while this one sends for a and times it
+    b.messages = iterations;
+    long t0 = bench_now_ns();
+    pthread_create(&b.sender, NULL, duplex_sender, &b);
+    for (long i = 0; i < iterations; i++) {
+        fill(msg, i);
+        long t1 = bench_now_ns();
+        if (uart_link_send(&a.link, msg, sizeof(msg)) < 0) {
+            ret = -1;
+            break;
+        }
+        bench_sample(&s, bench_now_ns() - t1);
+    }
+    pthread_join(b.sender, NULL);
+    if (uart_link_flush(&a.link, 5000) != 0 || uart_link_flush(&b.link, 5000) != 0) {
+        ret = -1;
+    }
+    double secs = (bench_now_ns() - t0) / 1e9;
+
+    long total = iterations * (long)LINK_MTU;
+    bench_finish(&s, a.got + b.got, res);
+    if (a.got != total || b.got != total || a.corrupt || b.corrupt) {
+        snprintf(res->note, sizeof(res->note), "stream broken: %ld and %ld of %ld bytes", b.got, a.got, total);
+        ret = -1;
+    } else if (ret == 0 && lossy) {
+        snprintf(res->note, sizeof(res->note),
+                 "%lu bytes dropped, %lu NAKs, %lu timeouts, %lu resent, %lu short writes",
+                 ab.dropped + ba.dropped, a.link.naks + b.link.naks, a.link.timeouts + b.link.timeouts,
+                 a.link.retransmits + b.link.retransmits, a.link.short_writes + b.link.short_writes);
+    } else if (ret == 0) {
+        snprintf(res->note, sizeof(res->note), "%.1f MB/s each way, %.1f frames/writev, %lu resent",
+                 total / secs / 1e6, (double)(a.link.tx_frames + a.link.retransmits) / a.link.writes,
+                 a.link.retransmits + b.link.retransmits);
+    }
+    uart_link_stop(&a.link);
+    uart_link_stop(&b.link);
+    if (lossy) {
+        lossy_join(&ab, &ba);
+    }
+    return ret;
+}
+
+int bench_uart_duplex(long iterations, bench_result_t *res) {
+    return duplex_run(false, iterations, res);
+}
+
+int bench_uart_lossy(long iterations, bench_result_t *res) {
+    return duplex_run(true, iterations, res);
+}
+
+// The data logging passthrough: 4 KB bursts into a pty, each moved by one
+// uart_sink_pump() to a file in /tmp, with splice or with read/write
+static int sink_run(bool copy, long iterations, bench_result_t *res) {
+    uart_sink_cfg_t cfg;
+    uart_sink_t sink;
+    bench_samples_t s;
+    struct termios tio;
+    struct rusage ru0, ru1;
+    char path[64], burst[4096];
+    int ma, sl, ret = 0;
+
+    if (openpty(&ma, &sl, NULL, NULL, NULL) != 0) {
+        return bench_skip(res, "pty not available");
+    }
+    tcgetattr(ma, &tio);
+    cfmakeraw(&tio);
+    tcsetattr(ma, TCSANOW, &tio);
+    tcsetattr(sl, TCSANOW, &tio);
+    fcntl(sl, F_SETFL, fcntl(sl, F_GETFL) | O_NONBLOCK);
+
+    snprintf(path, sizeof(path), "/tmp/bench-uart-sink.%d", (int)getpid());
+    unlink(path);
+    uart_sink_cfg_init(&cfg, path);
+    cfg.rotate_bytes = 0;
+    cfg.socket_path = NULL;
+    cfg.batch_ms = 0;
+    cfg.copy = copy;
+    if (uart_sink_open(&sink, sl, &cfg) != 0 || bench_samples_init(&s, iterations) != 0) {
+        close(ma);
+        close(sl);
+        return -1;
+    }
+    for (int i = 0; i < (int)sizeof(burst); i++) {
+        burst[i] = (char)i;   // NULs included
+    }
+
+    getrusage(RUSAGE_SELF, &ru0);
+    for (long i = 0; i < iterations && ret == 0; i++) {
+        if (write(ma, burst, sizeof(burst)) != (ssize_t)sizeof(burst)) {
+            ret = -1;
+            break;
+        }
+        long t0 = bench_now_ns();
+        long moved = 0;
+        while (moved < (long)sizeof(burst) && ret == 0) {
+            long n = uart_sink_pump(&sink, 100);
+            if (n <= 0) {
+                ret = -1;
+            }
+            moved += n;
+        }
+        bench_sample(&s, bench_now_ns() - t0);
+    }
+    getrusage(RUSAGE_SELF, &ru1);
+
+    double cpu_us = (ru1.ru_utime.tv_sec - ru0.ru_utime.tv_sec + ru1.ru_stime.tv_sec - ru0.ru_stime.tv_sec) * 1e6 +
+                    (ru1.ru_utime.tv_usec - ru0.ru_utime.tv_usec + ru1.ru_stime.tv_usec - ru0.ru_stime.tv_usec);
+    bench_finish(&s, (long)sink.bytes, res);
+    if (ret == 0) {
+        snprintf(res->note, sizeof(res->note), "%s, %.0f us CPU per MB (pty writes included)",
+                 sink.cfg.copy ? "read/write" : "splice", sink.bytes ? cpu_us * (1 << 20) / sink.bytes : 0.0);
+    }
+    uart_sink_close(&sink);
+    close(sl);
+    close(ma);
+    unlink(path);
+    return ret;
+}
+
+int bench_uart_sink_splice(long iterations, bench_result_t *res) {
+    return sink_run(false, iterations, res);
+}
+
+int bench_uart_sink_copy(long iterations, bench_result_t *res) {
+    return sink_run(true, iterations, res);
+}
@@ -0,0 +1,154 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "pinmap.h"
+#include "lcd.h"
+#include "mock.h"
+
+// Drives the LCD driver on the mock and checks what the controller saw:
+// every EN strobe, as decoded by the mock into $MOCK_LCD_CAPTURE, against
+// the sequence the HD44780 datasheet asks for, and no bus timing errors.
+// One bus per run, on a fresh mock:
+//   MOCK_LCD_CAPTURE=lcd8.capture check_lcd lcd8
+// Exits 1 on any difference, so that make check fails.
+
+#define CHECK_MAX_STROBES 128
+
+typedef struct {
+    int rs;
+    int nibble;
+    unsigned value;
+} strobe_t;
+
+static const lcd_glyph_t heart = {0, {0x00, 0x0A, 0x1F, 0x1F, 0x0E, 0x04, 0x00, 0x00}};
+
+// The bytes sent after the function set, in order: 'rs' 0 for commands
+static int expected_bytes(strobe_t *out) {
+    static const char text[] = "Hello";
+    int n = 0;
+
+    out[n++] = (strobe_t){0, 0, LCD_DISPLAY_ON};
+    out[n++] = (strobe_t){0, 0, LCD_ENTRY_MODE};
+    out[n++] = (strobe_t){0, 0, LCD_CLEAR};
+    for (const char *c = text; *c; c++) {
+        out[n++] = (strobe_t){1, 0, (uint8_t)*c};
+    }
+    out[n++] = (strobe_t){0, 0, LCD_SET_DDRAM | 0x40};     // row 1, column 0
+    out[n++] = (strobe_t){0, 0, LCD_SET_CGRAM | 0 << 3};   // glyph into slot 0
+    for (int i = 0; i < 8; i++) {
+        out[n++] = (strobe_t){1, 0, heart.rows[i]};
+    }
+    out[n++] = (strobe_t){0, 0, LCD_SET_DDRAM | 0x40};     // cursor put back
+    out[n++] = (strobe_t){1, 0, 0};                        // the glyph's code
+    out[n++] = (strobe_t){1, 0, 'o'};
+    out[n++] = (strobe_t){1, 0, 'k'};
+    return n;
+}
+
+// What the controller has to see. It powers up in 8-bit mode, so on the
+// 4-bit bus the reset nibbles arrive as whole bytes with D3-D0 low; from
+// the switch to 4-bit mode on, every byte is two nibbles, high first.
+static int expected(lcd_bus_t bus, strobe_t *out) {
+    strobe_t bytes[CHECK_MAX_STROBES];
+    int count = expected_bytes(bytes), n = 0;
+
+    if (bus == LCD_BUS_8BIT) {
+        out[n++] = (strobe_t){0, 0, 0x38};
+        memcpy(&out[n], bytes, count * sizeof(strobe_t));
+        return n + count;
+    }
+
+    static const unsigned reset[] = {0x30, 0x30, 0x30, 0x20};
+    for (int i = 0; i < 4; i++) {
+        out[n++] = (strobe_t){0, 0, reset[i]};
+    }
+    for (int i = -1; i < count; i++) {
+        strobe_t b = i < 0 ? (strobe_t){0, 0, 0x28} : bytes[i];
+        out[n++] = (strobe_t){b.rs, 1, b.value >> 4};
+        out[n++] = (strobe_t){b.rs, 1, b.value & 0x0F};
+    }
+    return n;
+}
+
+static int read_capture(const char *path, strobe_t *out, int max) {
+    FILE *f = fopen(path, "r");
+    char line[96], name[16], kind[8];
+    int n = 0;
+
+    if (f == NULL) {
+        fprintf(stderr, "check_lcd: cannot read %s\n", path);
+        return -1;
+    }
+    while (fgets(line, sizeof(line), f) != NULL) {
+        strobe_t s;
+        if (sscanf(line, "%*f %15s %d %7s %x", name, &s.rs, kind, &s.value) != 4 || strcmp(name, "lcd") != 0) {
+            continue;
+        }
+        s.nibble = strcmp(kind, "nibble") == 0;
+        if (n < max) {
+            out[n] = s;
+        }
+        n++;
+    }
+    fclose(f);
+    return n;
+}
+
+static void print_strobe(const char *label, int i, const strobe_t *s) {
+    fprintf(stderr, "  %s %3d: rs %d %-6s 0x%02X\n", label, i, s->rs, s->nibble ? "nibble" : "byte", s->value);
+}
+
+int main(int argc, char **argv) {
+    const char *section = argc > 1 ? argv[1] : "";
+    const char *path = getenv("MOCK_LCD_CAPTURE");
+    strobe_t want[CHECK_MAX_STROBES], got[CHECK_MAX_STROBES];
+    lcd_bus_t bus;
+    lcd_t lcd;
+
+    if (strcmp(section, "lcd8") == 0) {
+        bus = LCD_BUS_8BIT;
+    } else if (strcmp(section, "lcd4") == 0) {
+        bus = LCD_BUS_4BIT;
+    } else {
+        fprintf(stderr, "Usage: MOCK_LCD_CAPTURE=<file> %s lcd8|lcd4\n", argv[0]);
+        return 1;
+    }
+    if (path == NULL || *path == '\0') {
+        fprintf(stderr, "check_lcd: MOCK_LCD_CAPTURE is not set\n");
+        return 1;
+    }
+
+    if (pinmap_setup(section) != 0 || lcd_open_gpio(&lcd, bus) != 0) {
+        return 1;
+    }
+    lcd_init(&lcd);
+    lcd_write_string(&lcd, "Hello");
+    lcd_set_cursor(&lcd, 1, 0);
+    lcd_glyph_put(&lcd, &heart);
+    lcd_write_string(&lcd, "ok");
+    lcd_close(&lcd);
+    pinmap_close_all();
+
+    int nwant = expected(bus, want);
+    int ngot = read_capture(path, got, CHECK_MAX_STROBES);
+    unsigned long errors = mock_lcd_bus_errors(MOCK_LCD_GPIO);
+    int bad = ngot < 0 || ngot != nwant || errors != 0;
+
+    for (int i = 0; i < nwant && i < ngot && i < CHECK_MAX_STROBES; i++) {
+        if (memcmp(&want[i], &got[i], sizeof(strobe_t)) != 0) {
+            fprintf(stderr, "check_lcd %s: strobe %d differs\n", section, i);
+            print_strobe("want", i, &want[i]);
+            print_strobe("got ", i, &got[i]);
+            bad = 1;
+            break;
+        }
+    }
+    if (ngot >= 0 && ngot != nwant) {
+        fprintf(stderr, "check_lcd %s: %d strobes, want %d\n", section, ngot, nwant);
+    }
+    if (errors != 0) {
+        fprintf(stderr, "check_lcd %s: %lu bus errors\n", section, errors);
+    }
+    printf("check_lcd %s: %d strobes, %lu bus errors: %s\n", section, ngot, errors, bad ? "FAIL" : "ok");
+    return bad;
+}
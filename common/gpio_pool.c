@@ -0,0 +1,392 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <linux/gpio.h>
+#include "gpio_pool.h"
+#include "trace.h"
+
+// One GPIO_GET_LINEHANDLE request: every line in it shares direction and bias
+typedef struct {
+    int fd;
+    int count;
+    mraa_gpio_dir_t dir;
+    int mode;
+    int lines[GPIOHANDLES_MAX];
+    struct gpiohandle_data data;  // shadow of the line levels
+} gpio_handle_t;
+
+static gpio_line_t lines[GPIO_POOL_MAX_LINES];
+static int num_lines = 0;
+
+static gpio_handle_t handles[GPIO_POOL_MAX_HANDLES];
+static int num_handles = 0;
+
+static gpio_pool_backend_t backend = GPIO_POOL_CHARDEV;
+static int chip_fd = -1;
+static long startup_ns = 0;
+
+static long elapsed_ns(const struct timespec *start) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (now.tv_sec - start->tv_sec) * 1000000000L + (now.tv_nsec - start->tv_nsec);
+}
+
+static int is_output(mraa_gpio_dir_t dir) {
+    return dir != MRAA_GPIO_IN;
+}
+
+int gpio_pool_add(int pin, mraa_gpio_dir_t dir, int mode, int level) {
+    if (num_lines == GPIO_POOL_MAX_LINES) {
+        fprintf(stderr, "GPIO pool full (max %d lines)\n", GPIO_POOL_MAX_LINES);
+        return -1;
+    }
+
+    gpio_line_t *l = &lines[num_lines];
+    memset(l, 0, sizeof(*l));
+    l->pin = pin;
+    l->mode = mode;
+    l->value = -1;
+    l->handle = -1;
+
+    // Fold the OUT_HIGH/OUT_LOW shorthands into a plain output with a level
+    if (dir == MRAA_GPIO_OUT_HIGH || dir == MRAA_GPIO_OUT_LOW) {
+        level = (dir == MRAA_GPIO_OUT_HIGH);
+        dir = MRAA_GPIO_OUT;
+    }
+    l->dir = dir;
+    if (is_output(dir) && level >= 0) {
+        l->value = level ? 1 : 0;
+    }
+
+    return num_lines++;
+}
+
+// ---- chardev backend ----
+
+static __u32 handle_flags(const gpio_handle_t *h) {
+    __u32 flags = is_output(h->dir) ? GPIOHANDLE_REQUEST_OUTPUT : GPIOHANDLE_REQUEST_INPUT;
+#ifdef GPIOHANDLE_REQUEST_BIAS_PULL_UP
+    if (h->mode == MRAA_GPIO_PULLUP) {
+        flags |= GPIOHANDLE_REQUEST_BIAS_PULL_UP;
+    } else if (h->mode == MRAA_GPIO_PULLDOWN) {
+        flags |= GPIOHANDLE_REQUEST_BIAS_PULL_DOWN;
+    } else if (h->mode == MRAA_GPIO_HIZ) {
+        flags |= GPIOHANDLE_REQUEST_BIAS_DISABLE;
+    }
+#endif
+    return flags;
+}
+
+static void chardev_release(void) {
+    for (int i = 0; i < num_handles; i++) {
+        if (handles[i].fd >= 0) {
+            close(handles[i].fd);
+        }
+    }
+    num_handles = 0;
+}
+
+// Group the lines by (direction, mode) and request each group in one ioctl
+static int chardev_request(void) {
+    chardev_release();
+
+    for (int i = 0; i < num_lines; i++) {
+        gpio_line_t *l = &lines[i];
+        int h;
+
+        for (h = 0; h < num_handles; h++) {
+            if (handles[h].dir == l->dir && handles[h].mode == l->mode &&
+                handles[h].count < GPIOHANDLES_MAX) {
+                break;
+            }
+        }
+        if (h == num_handles) {
+            if (num_handles == GPIO_POOL_MAX_HANDLES) {
+                fprintf(stderr, "GPIO pool: too many line groups\n");
+                return -1;
+            }
+            memset(&handles[h], 0, sizeof(handles[h]));
+            handles[h].fd = -1;
+            handles[h].dir = l->dir;
+            handles[h].mode = l->mode;
+            num_handles++;
+        }
+
+        l->handle = h;
+        l->slot = handles[h].count;
+        handles[h].lines[handles[h].count++] = i;
+    }
+
+    for (int h = 0; h < num_handles; h++) {
+        gpio_handle_t *gh = &handles[h];
+        struct gpiohandle_request req;
+
+        memset(&req, 0, sizeof(req));
+        req.flags = handle_flags(gh);
+        req.lines = gh->count;
+        strncpy(req.consumer_label, "gpio_pool", sizeof(req.consumer_label) - 1);
+
+        for (int s = 0; s < gh->count; s++) {
+            const gpio_line_t *l = &lines[gh->lines[s]];
+            req.lineoffsets[s] = l->pin;
+            req.default_values[s] = l->value > 0;
+            gh->data.values[s] = l->value > 0;
+        }
+
+        if (ioctl(chip_fd, GPIO_GET_LINEHANDLE_IOCTL, &req) < 0) {
+            fprintf(stderr, "GPIO pool: line request failed: %s\n", strerror(errno));
+            return -1;
+        }
+        gh->fd = req.fd;
+
+        // Outputs requested without a level now read as 0
+        for (int s = 0; s < gh->count && is_output(gh->dir); s++) {
+            if (lines[gh->lines[s]].value < 0) {
+                lines[gh->lines[s]].value = 0;
+            }
+        }
+    }
+    return 0;
+}
+
+// ---- mraa backend ----
+
+static int mraa_open_line(gpio_line_t *l) {
+    l->gpio = mraa_gpio_init(l->pin);
+    if (l->gpio == NULL) {
+        fprintf(stderr, "Failed to initialize GPIO %d\n", l->pin);
+        return -1;
+    }
+
+    if (is_output(l->dir) && l->value >= 0) {
+        mraa_gpio_dir(l->gpio, l->value ? MRAA_GPIO_OUT_HIGH : MRAA_GPIO_OUT_LOW);
+    } else {
+        mraa_gpio_dir(l->gpio, l->dir);
+    }
+    if (l->mode >= 0) {
+        mraa_gpio_mode(l->gpio, (mraa_gpio_mode_t)l->mode);
+    }
+    return 0;
+}
+
+int gpio_pool_open(void) {
+    struct timespec start;
+    const char *forced = getenv("GPIO_POOL_BACKEND");
+    const char *chip = getenv("GPIO_CHIP");
+
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    // Against the mock the pins only exist behind the mraa API: a gpiochip
+    // on the host would be a real device, not the simulated board
+    backend = GPIO_POOL_MRAA;
+#ifdef MRAA_MOCK
+    forced = "mraa";
+#endif
+    if (forced == NULL || strcmp(forced, "mraa") != 0) {
+        chip_fd = open(chip ? chip : GPIO_POOL_DEFAULT_CHIP, O_RDWR | O_CLOEXEC);
+        if (chip_fd >= 0) {
+            backend = GPIO_POOL_CHARDEV;
+        }
+    }
+
+    if (backend == GPIO_POOL_CHARDEV) {
+        if (chardev_request() != 0) {
+            gpio_pool_close();
+            return -1;
+        }
+    } else {
+        for (int i = 0; i < num_lines; i++) {
+            if (mraa_open_line(&lines[i]) != 0) {
+                gpio_pool_close();
+                return -1;
+            }
+        }
+    }
+
+    startup_ns = elapsed_ns(&start);
+    return 0;
+}
+
+void gpio_pool_close(void) {
+    chardev_release();
+    if (chip_fd >= 0) {
+        close(chip_fd);
+        chip_fd = -1;
+    }
+
+    for (int i = 0; i < num_lines; i++) {
+        if (lines[i].gpio != NULL) {
+            mraa_gpio_close(lines[i].gpio);
+            lines[i].gpio = NULL;
+        }
+    }
+    num_lines = 0;
+}
+
+int gpio_pool_write(int line, int value) {
+    gpio_line_t *l = &lines[line];
+
+    value = value ? 1 : 0;
+    if (l->value == value) {
+        return 0;  // already at that level
+    }
+
+    int ret = 0;
+    TRACE_BEGIN("gpio_write");
+    if (backend == GPIO_POOL_CHARDEV) {
+        gpio_handle_t *gh = &handles[l->handle];
+        uint8_t old = gh->data.values[l->slot];
+        gh->data.values[l->slot] = value;
+        if (ioctl(gh->fd, GPIOHANDLE_SET_LINE_VALUES_IOCTL, &gh->data) < 0) {
+            gh->data.values[l->slot] = old;   // the line kept its old level
+            ret = -1;
+        }
+    } else if (mraa_gpio_write(l->gpio, value) != MRAA_SUCCESS) {
+        ret = -1;
+    }
+    TRACE_END("gpio_write");
+
+    if (ret == 0) {
+        l->value = value;
+    }
+    return ret;
+}
+
+int gpio_pool_write_lines(const int *ids, int n, unsigned levels) {
+    unsigned touched = 0;   // chardev handles with a new level to send
+    struct gpiohandle_data saved[GPIO_POOL_MAX_HANDLES];
+    int ret = 0;
+
+    TRACE_BEGIN("gpio_write_lines");
+    for (int i = 0; i < n; i++) {
+        gpio_line_t *l = &lines[ids[i]];
+        int value = (levels >> i) & 0x01;
+
+        if (l->value == value) {
+            continue;
+        }
+        if (backend == GPIO_POOL_CHARDEV) {
+            if (!(touched & (1u << l->handle))) {
+                saved[l->handle] = handles[l->handle].data;
+            }
+            handles[l->handle].data.values[l->slot] = value;
+            touched |= 1u << l->handle;
+            l->value = value;
+        } else if (mraa_gpio_write(l->gpio, value) != MRAA_SUCCESS) {
+            ret = -1;
+        } else {
+            l->value = value;
+        }
+    }
+    for (int h = 0; touched != 0; h++, touched >>= 1) {
+        if (!(touched & 0x01)) {
+            continue;
+        }
+        if (ioctl(handles[h].fd, GPIOHANDLE_SET_LINE_VALUES_IOCTL, &handles[h].data) < 0) {
+            // Nothing of this handle was written: put the shadow back and
+            // forget the cached levels
+            handles[h].data = saved[h];
+            for (int s = 0; s < handles[h].count; s++) {
+                lines[handles[h].lines[s]].value = -1;
+            }
+            ret = -1;
+        }
+    }
+    TRACE_END("gpio_write_lines");
+    return ret;
+}
+
+int gpio_pool_read(int line) {
+    gpio_line_t *l = &lines[line];
+    int value = -1;
+
+    TRACE_BEGIN("gpio_read");
+    if (backend == GPIO_POOL_CHARDEV) {
+        gpio_handle_t *gh = &handles[l->handle];
+        if (ioctl(gh->fd, GPIOHANDLE_GET_LINE_VALUES_IOCTL, &gh->data) == 0) {
+            value = gh->data.values[l->slot];
+        }
+    } else {
+        value = mraa_gpio_read(l->gpio);
+    }
+    TRACE_END("gpio_read");
+
+    if (value >= 0) {
+        l->value = value;
+    }
+    return value;
+}
+
+int gpio_pool_dir(int line, mraa_gpio_dir_t dir) {
+    gpio_line_t *l = &lines[line];
+    int level = -1;
+
+    if (dir == MRAA_GPIO_OUT_HIGH || dir == MRAA_GPIO_OUT_LOW) {
+        level = (dir == MRAA_GPIO_OUT_HIGH);
+        dir = MRAA_GPIO_OUT;
+    }
+    if (l->dir == dir && (level < 0 || l->value == level)) {
+        return 0;
+    }
+
+    l->dir = dir;
+    if (level >= 0) {
+        l->value = level;
+    } else if (!is_output(dir)) {
+        l->value = -1;
+    }
+
+    if (backend == GPIO_POOL_CHARDEV) {
+        // A line handle has one direction for all its lines, so regroup
+        return chardev_request();
+    }
+    if (is_output(dir) && l->value >= 0) {
+        dir = l->value ? MRAA_GPIO_OUT_HIGH : MRAA_GPIO_OUT_LOW;
+    }
+    return mraa_gpio_dir(l->gpio, dir) == MRAA_SUCCESS ? 0 : -1;
+}
+
+int gpio_pool_mode(int line, mraa_gpio_mode_t mode) {
+    gpio_line_t *l = &lines[line];
+
+    if (l->mode == (int)mode) {
+        return 0;
+    }
+    l->mode = mode;
+
+    if (backend == GPIO_POOL_CHARDEV) {
+        return chardev_request();
+    }
+    return mraa_gpio_mode(l->gpio, mode) == MRAA_SUCCESS ? 0 : -1;
+}
+
+int gpio_pool_count(void) {
+    return num_lines;
+}
+
+const gpio_line_t *gpio_pool_line(int line) {
+    return (line >= 0 && line < num_lines) ? &lines[line] : NULL;
+}
+
+gpio_pool_backend_t gpio_pool_backend(void) {
+    return backend;
+}
+
+long gpio_pool_startup_ns(void) {
+    return startup_ns;
+}
+
+void gpio_pool_report(FILE *out) {
+    if (backend == GPIO_POOL_CHARDEV) {
+        fprintf(out, "GPIO pool: %d lines in %d chardev request(s), opened in %.3f ms\n",
+                num_lines, num_handles, startup_ns / 1e6);
+    } else {
+        fprintf(out, "GPIO pool: %d lines via mraa, opened in %.3f ms\n",
+                num_lines, startup_ns / 1e6);
+    }
+}
@@ -0,0 +1,71 @@
+#ifndef GPIO_POOL_H
+#define GPIO_POOL_H
+
+#include <stdio.h>
+#include <mraa/gpio.h>
+
+// Pool of pre-opened GPIO lines.
+//
+// Lines are registered with gpio_pool_add() and then opened together by
+// gpio_pool_open(). On the board this goes through the GPIO character
+// device: all lines sharing a direction and pull mode are requested with a
+// single GPIO_GET_LINEHANDLE_IOCTL, so startup costs a handful of ioctls
+// instead of a sysfs export/open per pin. Where no gpiochip is available
+// (or GPIO_POOL_BACKEND=mraa) every line falls back to mraa_gpio_init().
+// Built against the mock (host profile) the mraa backend is always used,
+// since the simulated board is only reachable through it.
+//
+// Direction, pull mode and output level are cached per line, so calling
+// gpio_pool_dir()/gpio_pool_mode() with the current setting or writing the
+// level a line already has costs nothing.
+
+#define GPIO_POOL_MAX_LINES   64
+#define GPIO_POOL_MAX_HANDLES 8
+#define GPIO_POOL_DEFAULT_CHIP "/dev/gpiochip0"
+
+typedef enum {
+    GPIO_POOL_CHARDEV = 0,
+    GPIO_POOL_MRAA
+} gpio_pool_backend_t;
+
+typedef struct {
+    int pin;
+    mraa_gpio_dir_t dir;
+    int mode;             // mraa_gpio_mode_t, or -1 for the pin default
+    int value;            // last level written/read, -1 if unknown
+    mraa_gpio_context gpio;  // mraa backend only
+    int handle;           // chardev backend: owning handle
+    int slot;             // chardev backend: index inside that handle
+} gpio_line_t;
+
+// Register a line before gpio_pool_open(). 'level' is the initial output
+// level (-1 to leave it). Returns the line index used by the other calls.
+int gpio_pool_add(int pin, mraa_gpio_dir_t dir, int mode, int level);
+
+// Open every registered line. Returns 0 on success, -1 otherwise.
+int gpio_pool_open(void);
+void gpio_pool_close(void);
+
+int gpio_pool_write(int line, int value);
+
+// Write several lines at once: bit i of 'levels' goes to lines[i]. On the
+// chardev backend the lines that change are set with one ioctl per handle,
+// so a bus whose lines share direction and pull mode (an LCD's RS and data
+// lines, say) costs one ioctl however many lines change; the mraa backend
+// writes them one by one, in order. Lines already at their level are skipped.
+int gpio_pool_write_lines(const int *lines, int n, unsigned levels);
+int gpio_pool_read(int line);
+
+// Cached configuration changes; a no-op if the line is already set up so
+int gpio_pool_dir(int line, mraa_gpio_dir_t dir);
+int gpio_pool_mode(int line, mraa_gpio_mode_t mode);
+
+int gpio_pool_count(void);
+const gpio_line_t *gpio_pool_line(int line);
+gpio_pool_backend_t gpio_pool_backend(void);
+
+// Wall time spent in gpio_pool_open(), and a one line summary of it
+long gpio_pool_startup_ns(void);
+void gpio_pool_report(FILE *out);
+
+#endif
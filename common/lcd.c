@@ -0,0 +1,278 @@
+#include <stdio.h>
+#include <string.h>
+#include "gpio_pool.h"
+#include "pinmap.h"
+#include "lcd.h"
+#include "trace.h"
+#include "metrics.h"
+#include "timing.h"
+#include "lcd_fmt.h"
+
+static METRIC_DEFINE(lcd_cells, METRIC_COUNTER, "lcd_cells_written_total", "Characters written to the LCD")
+static METRIC_DEFINE(lcd_commands, METRIC_COUNTER, "lcd_commands_total", "Commands sent to the LCD")
+static METRIC_DEFINE(lcd_send_ns, METRIC_HISTOGRAM, "lcd_send_latency_ns", "Time to send one byte to the LCD")
+
+// PCF8574 backpack bits
+#define I2C_RS 0x01
+#define I2C_EN 0x04
+#define I2C_BL 0x08
+
+// HD44780 timings, with margin for a slow (190 kHz) controller clock
+#define LCD_PULSE_NS   1000   // EN high and low time, covers the data setup time
+#define LCD_EXEC_US    50     // most commands and data writes (37 us nominal)
+#define LCD_CLEAR_US   2000   // clear display and return home (1.52 ms)
+
+static const uint8_t row_offsets[4] = {0x00, 0x40, 0x14, 0x54};
+
+int lcd_open_gpio(lcd_t *lcd, lcd_bus_t bus) {
+    memset(lcd, 0, sizeof(*lcd));
+    lcd->bus = bus;
+    lcd->rows = 2;
+    lcd->cols = 16;
+
+    lcd->rs = pinmap_line("lcd.rs");
+    lcd->en = pinmap_line("lcd.en");
+    lcd->rw = -1;
+
+    int ret;
+    if (bus == LCD_BUS_8BIT) {
+        lcd->rw = pinmap_line("lcd.rw");
+        ret = pinmap_line_array("lcd.d", 0, lcd->d, 8);
+    } else {
+        ret = pinmap_line_array("lcd.d", 4, lcd->d, 4);
+    }
+
+    if (lcd->rs < 0 || lcd->en < 0 || ret != 0) {
+        fprintf(stderr, "LCD pins missing from the pin map\n");
+        return -1;
+    }
+
+    lcd->bus_width = bus == LCD_BUS_8BIT ? 8 : 4;
+    memcpy(lcd->bus_lines, lcd->d, lcd->bus_width * sizeof(int));
+    lcd->bus_count = lcd->bus_width;
+    lcd->bus_lines[lcd->bus_count++] = lcd->rs;
+    if (lcd->rw >= 0) {
+        lcd->bus_lines[lcd->bus_count++] = lcd->rw;  // always written low
+    }
+    return 0;
+}
+
+int lcd_open_i2c(lcd_t *lcd, int i2c_bus, uint8_t addr) {
+    memset(lcd, 0, sizeof(*lcd));
+    lcd->bus = LCD_BUS_I2C;
+    lcd->rows = 2;
+    lcd->cols = 16;
+    lcd->backlight = I2C_BL;
+
+    lcd->i2c = mraa_i2c_init(i2c_bus);
+    if (lcd->i2c == NULL) {
+        fprintf(stderr, "Failed to initialize I2C bus %d\n", i2c_bus);
+        return -1;
+    }
+    if (mraa_i2c_address(lcd->i2c, addr) != MRAA_SUCCESS) {
+        fprintf(stderr, "Failed to set LCD I2C address 0x%02X\n", addr);
+        mraa_i2c_stop(lcd->i2c);
+        lcd->i2c = NULL;
+        return -1;
+    }
+    return 0;
+}
+
+void lcd_close(lcd_t *lcd) {
+    if (lcd->i2c != NULL) {
+        mraa_i2c_stop(lcd->i2c);
+        lcd->i2c = NULL;
+    }
+}
+
+// Put the data lines and RS on the bus in one write, then latch them with
+// a high-to-low pulse on EN. The low time that follows keeps the EN cycle
+// long enough for the next nibble. Both are timed on the clock from after
+// the write, not in calibrated loops, which come out short when the CPU
+// clock steps up and would break the 450 ns minimum.
+static void strobe(lcd_t *lcd, uint8_t bits, uint8_t mode) {
+    gpio_pool_write_lines(lcd->bus_lines, lcd->bus_count, bits | (unsigned)mode << lcd->bus_width);
+    gpio_pool_write(lcd->en, 1);
+    timing_wait_until(timing_now_ns() + LCD_PULSE_NS);
+    gpio_pool_write(lcd->en, 0);
+    timing_wait_until(timing_now_ns() + LCD_PULSE_NS);
+}
+
+// One transfer of the 4-bit buses. The controller only executes once it
+// has both halves of a byte, so there is no wait in between.
+static void send_nibble(lcd_t *lcd, uint8_t nibble, uint8_t mode) {
+    if (lcd->bus == LCD_BUS_I2C) {
+        uint8_t data = (nibble << 4) | (mode ? I2C_RS : 0) | lcd->backlight;
+        // Each I2C write takes longer than the EN pulse needs
+        mraa_i2c_write_byte(lcd->i2c, data | I2C_EN);
+        mraa_i2c_write_byte(lcd->i2c, data & ~I2C_EN);
+        return;
+    }
+    strobe(lcd, nibble, mode);
+}
+
+static void send(lcd_t *lcd, uint8_t value, uint8_t mode) {
+    uint64_t t0 = metrics_now_ns();
+
+    TRACE_BEGIN("lcd_send");
+    if (lcd->bus != LCD_BUS_8BIT) {
+        send_nibble(lcd, value >> 4, mode);
+        send_nibble(lcd, value & 0x0F, mode);
+    } else {
+        strobe(lcd, value, mode);
+    }
+    delay_us(LCD_EXEC_US);
+    TRACE_END("lcd_send");
+
+    metric_observe(&lcd_send_ns, metrics_now_ns() - t0);
+    metric_inc(mode ? &lcd_cells : &lcd_commands);
+}
+
+void lcd_init(lcd_t *lcd) {
+    delay_ms(lcd->bus == LCD_BUS_I2C ? 50 : 15); // Wait for the LCD to power up
+
+    if (lcd->bus == LCD_BUS_8BIT) {
+        lcd_command(lcd, 0x38); // Function set: 8-bit mode, 2-line display
+    } else {
+        // Reset sequence, then switch to 4-bit mode; until then each
+        // nibble is a whole 8-bit instruction and has to be waited for
+        send_nibble(lcd, 0x03, 0);
+        delay_us(4100);
+        send_nibble(lcd, 0x03, 0);
+        delay_us(100);
+        send_nibble(lcd, 0x03, 0);
+        delay_us(LCD_EXEC_US);
+        send_nibble(lcd, 0x02, 0);
+        delay_us(LCD_EXEC_US);
+        lcd_command(lcd, 0x28); // Function set: 4-bit mode, 2-line display
+    }
+
+    // CGRAM holds garbage after power-up
+    memset(lcd->glyphs.slot, 0, sizeof(lcd->glyphs.slot));
+
+    lcd_command(lcd, LCD_DISPLAY_ON); // Display ON, cursor OFF, blink OFF
+    lcd_command(lcd, LCD_ENTRY_MODE); // Entry mode set: Auto-increment, no shift
+    lcd_clear(lcd);
+}
+
+// The visible cell behind a DDRAM address, NULL when off screen
+static uint8_t *cell_at(lcd_t *lcd, uint8_t addr) {
+    for (int r = 0; r < lcd->rows && r < LCD_MAX_ROWS; r++) {
+        if (addr >= row_offsets[r] && addr < row_offsets[r] + lcd->cols) {
+            return &lcd->shown[r][addr - row_offsets[r]];
+        }
+    }
+    return NULL;
+}
+
+void lcd_command(lcd_t *lcd, uint8_t cmd) {
+    send(lcd, cmd, 0);
+    if (cmd == LCD_CLEAR || cmd == LCD_HOME) {
+        delay_us(LCD_CLEAR_US); // These take much longer than other commands
+        lcd->addr = 0;
+        lcd->in_cgram = 0;
+        if (cmd == LCD_CLEAR) {
+            memset(lcd->shown, ' ', sizeof(lcd->shown));
+            lcd_glyph_frame(lcd); // No glyph is on screen any more
+        }
+    } else if (cmd & LCD_SET_DDRAM) {
+        lcd->addr = cmd & 0x7F;
+        lcd->in_cgram = 0;
+    } else if (cmd & LCD_SET_CGRAM) {
+        lcd->in_cgram = 1;
+    }
+}
+
+void lcd_data(lcd_t *lcd, uint8_t data) {
+    send(lcd, data, 1);
+    if (!lcd->in_cgram) {
+        uint8_t *cell = cell_at(lcd, lcd->addr);
+        if (cell != NULL) {
+            *cell = data;
+        }
+        // The address counter runs 0x00-0x27 on line 1, 0x40-0x67 on line 2
+        lcd->addr++;
+        if (lcd->addr == 0x28) {
+            lcd->addr = 0x40;
+        } else if (lcd->addr == 0x68) {
+            lcd->addr = 0x00;
+        }
+    }
+}
+
+void lcd_write_string(lcd_t *lcd, const char *str) {
+    while (*str) {
+        lcd_data(lcd, *str++);
+    }
+}
+
+void lcd_clear(lcd_t *lcd) {
+    TRACE_BEGIN("lcd_clear");
+    lcd_command(lcd, LCD_CLEAR);
+    TRACE_END("lcd_clear");
+}
+
+void lcd_set_cursor(lcd_t *lcd, int row, int col) {
+    if (row < 0 || row >= lcd->rows || row >= 4) {
+        return; // Invalid row
+    }
+    lcd_command(lcd, LCD_SET_DDRAM | (row_offsets[row] + col));
+}
+
+int lcd_put_cells(lcd_t *lcd, int row, int col, const char *text, int len) {
+    int sent = 0, next = -1;
+
+    if (row < 0 || row >= lcd->rows || row >= LCD_MAX_ROWS || col < 0) {
+        return 0;
+    }
+    for (int i = 0; i < len && col + i < lcd->cols; i++) {
+        if (lcd->shown[row][col + i] == (uint8_t)text[i]) {
+            continue;
+        }
+        if (next != col + i) {
+            lcd_set_cursor(lcd, row, col + i);
+        }
+        lcd_data(lcd, text[i]);
+        next = col + i + 1;
+        sent++;
+    }
+    return sent;
+}
+
+// Formatter sink that lands each character on its cell, if it changed
+typedef struct {
+    lcd_sink_t sink;
+    lcd_t *lcd;
+    int row, col, next, sent;
+} cell_sink_t;
+
+static void cell_put(lcd_sink_t *sink, char c) {
+    cell_sink_t *s = (cell_sink_t *)sink;
+    lcd_t *lcd = s->lcd;
+    int col = s->col++;
+
+    if (col >= lcd->cols || lcd->shown[s->row][col] == (uint8_t)c) {
+        return;
+    }
+    if (s->next != col) {
+        lcd_set_cursor(lcd, s->row, col);
+    }
+    lcd_data(lcd, c);
+    s->next = col + 1;
+    s->sent++;
+}
+
+int lcd_printf(lcd_t *lcd, int row, int col, const char *fmt, ...) {
+    cell_sink_t s = {{cell_put}, lcd, row, col, -1, 0};
+    va_list ap;
+
+    if (row < 0 || row >= lcd->rows || row >= LCD_MAX_ROWS || col < 0) {
+        return 0;
+    }
+    TRACE_BEGIN("lcd_printf");
+    va_start(ap, fmt);
+    lcd_vformat(&s.sink, fmt, ap);
+    va_end(ap);
+    TRACE_END("lcd_printf");
+    return s.sent;
+}
@@ -0,0 +1,118 @@
+#ifndef LCD_H
+#define LCD_H
+
+#include <stdint.h>
+#include <mraa/i2c.h>
+
+// HD44780 character LCD driver shared by the LCD exercises.
+//
+// The same command set is sent over one of three buses:
+//   LCD_BUS_8BIT  RS, RW, EN and D0-D7 on GPIO ([lcd8] in pins.conf)
+//   LCD_BUS_4BIT  RS, EN and D4-D7 on GPIO    ([lcd4] in pins.conf)
+//   LCD_BUS_I2C   PCF8574 backpack, D4-D7 on P4-P7, RS/EN/BL on P0/P2/P3
+
+#define LCD_CLEAR        0x01
+#define LCD_HOME         0x02
+#define LCD_ENTRY_MODE   0x06
+#define LCD_DISPLAY_ON   0x0C
+#define LCD_SET_CGRAM    0x40
+#define LCD_SET_DDRAM    0x80
+
+#define LCD_I2C_DEFAULT_ADDR 0x27
+
+#define LCD_CGRAM_SLOTS  8
+#define LCD_MAX_ROWS     4
+#define LCD_MAX_COLS     40
+
+// A custom 5x8 character: rows top first, pixels in bits 4-0. 'code' is the
+// Unicode code point it stands for in lcd_glyph_write(), 0 for icons that
+// are only drawn with lcd_glyph_put().
+typedef struct {
+    uint32_t code;
+    uint8_t rows[8];
+} lcd_glyph_t;
+
+// Which glyph each CGRAM slot holds, so a glyph is uploaded only when it is
+// missing. Glyphs are told apart by address: keep them in static storage.
+typedef struct {
+    const lcd_glyph_t *slot[LCD_CGRAM_SLOTS];
+    uint32_t last_used[LCD_CGRAM_SLOTS];
+    uint32_t tick;
+    uint32_t frame_start;     // tick of the last lcd_glyph_frame()
+    const lcd_glyph_t *set;   // looked up by code point in lcd_glyph_write()
+    int set_size;
+    unsigned long hits, uploads;
+} lcd_glyph_cache_t;
+
+typedef enum {
+    LCD_BUS_8BIT = 0,
+    LCD_BUS_4BIT,
+    LCD_BUS_I2C
+} lcd_bus_t;
+
+typedef struct {
+    lcd_bus_t bus;
+    int rows, cols;
+
+    // GPIO buses: GPIO pool lines, rw is -1 when tied to ground.
+    // d[] holds D0-D7 for the 8-bit bus and D4-D7 in d[0..3] for 4-bit.
+    int rs, rw, en;
+    int d[8];
+
+    // The same lines as one group for gpio_pool_write_lines(): the data
+    // lines in bit order, then RS and RW, so a whole byte (or nibble) and
+    // its mode go out in one write. EN is pulsed on its own.
+    int bus_lines[10];
+    int bus_width;            // data lines in bus_lines
+    int bus_count;
+
+    // I2C backpack
+    mraa_i2c_context i2c;
+    uint8_t backlight;
+
+    // Where the next data byte goes, tracked so a glyph upload can put the
+    // cursor back, and what each visible cell shows
+    uint8_t addr;
+    uint8_t in_cgram;
+    uint8_t shown[LCD_MAX_ROWS][LCD_MAX_COLS];
+    lcd_glyph_cache_t glyphs;
+} lcd_t;
+
+// Bind to the lcd.* pins of an already set up pin map (see pinmap.h)
+int lcd_open_gpio(lcd_t *lcd, lcd_bus_t bus);
+int lcd_open_i2c(lcd_t *lcd, int i2c_bus, uint8_t addr);
+void lcd_close(lcd_t *lcd);
+
+void lcd_init(lcd_t *lcd);
+void lcd_command(lcd_t *lcd, uint8_t cmd);
+void lcd_data(lcd_t *lcd, uint8_t data);
+void lcd_write_string(lcd_t *lcd, const char *str);
+void lcd_clear(lcd_t *lcd);
+void lcd_set_cursor(lcd_t *lcd, int row, int col);
+
+// Write cells at row, col sending only those that differ from the screen
+// (cut at the end of the row). Returns the number of cells sent.
+int lcd_put_cells(lcd_t *lcd, int row, int col, const char *text, int len);
+
+// printf-style (see lcd_fmt.h) straight onto row, col, comparing each
+// character with the screen as it is formatted: with fixed field widths,
+// updating a number sends only the digits that changed. Returns the number
+// of cells sent.
+int lcd_printf(lcd_t *lcd, int row, int col, const char *fmt, ...) __attribute__((format(printf, 4, 5)));
+
+// Custom characters (lcd_glyph.c). The 8 CGRAM slots are shared by every
+// glyph the program uses; a glyph that is not loaded replaces the least
+// recently used one. A slot is never replaced while its code is shown in a
+// visible cell (lcd->shown), nor when its glyph was handed out since the
+// last lcd_glyph_frame() (or lcd_clear()) and may not be written yet: when
+// all 8 are in use, the glyph is drawn as '?' instead.
+void lcd_glyph_set(lcd_t *lcd, const lcd_glyph_t *set, int n);
+void lcd_glyph_frame(lcd_t *lcd);
+int lcd_glyph_slot(lcd_t *lcd, const lcd_glyph_t *glyph);  // slot, or -1 if none is free
+void lcd_glyph_put(lcd_t *lcd, const lcd_glyph_t *glyph);
+
+// Like lcd_write_string(), for UTF-8 text: characters outside ASCII are
+// drawn with the glyph of the same code point from lcd_glyph_set(), or '?'
+void lcd_glyph_write(lcd_t *lcd, const char *utf8);
+
+#endif
@@ -0,0 +1,380 @@
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include "lcd_async.h"
+#include "lcd_fmt.h"
+#include "timing.h"
+#include "trace.h"
+#include "metrics.h"
+
+static METRIC_DEFINE(async_posted, METRIC_COUNTER, "lcd_async_posted_total", "LCD operations queued")
+static METRIC_DEFINE(async_coalesced, METRIC_COUNTER, "lcd_async_coalesced_total", "LCD operations applied by the producer, queue full")
+static METRIC_DEFINE(async_frames, METRIC_COUNTER, "lcd_async_frames_total", "Frames flushed to the LCD")
+static METRIC_DEFINE(async_flush_ns, METRIC_HISTOGRAM, "lcd_async_flush_ns", "Time to flush one frame to the LCD")
+
+#define LCD_ASYNC_POLL_MS 100   // render thread wakeup when nobody kicks it
+
+static void kick(lcd_async_t *a) {
+    if (!__atomic_exchange_n(&a->kicked, 1, __ATOMIC_ACQ_REL)) {
+        char c = 0;
+        if (write(a->wake_pipe[1], &c, 1) < 0) {
+            // The render thread polls anyway
+        }
+    }
+}
+
+#define NO_SLOT UINT64_MAX
+
+static void drain(lcd_async_t *a);
+static void apply(lcd_async_t *a, const lcd_op_t *op);
+
+// Same bounded MPMC queue as the log ring, except that producers must not
+// wait for the display: when the queue is full the operation is built in
+// 'spare' (*ppos = NO_SLOT) and publish() applies it directly. Returns the
+// op to fill in.
+static lcd_op_t *claim(lcd_async_t *a, uint64_t *ppos, lcd_op_t *spare) {
+    uint64_t pos = __atomic_load_n(&a->head, __ATOMIC_RELAXED);
+    lcd_op_t *op;
+
+    while (1) {
+        op = &a->queue[pos & (LCD_ASYNC_QUEUE - 1)];
+        uint64_t seq = __atomic_load_n(&op->seq, __ATOMIC_ACQUIRE);
+
+        if (seq == pos) {
+            if (__atomic_compare_exchange_n(&a->head, &pos, pos + 1, 1,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (seq < pos) {
+            *ppos = NO_SLOT;
+            return spare;
+        } else {
+            pos = __atomic_load_n(&a->head, __ATOMIC_RELAXED);
+        }
+    }
+    *ppos = pos;
+    return op;
+}
+
+static void publish(lcd_async_t *a, lcd_op_t *op, uint64_t pos) {
+    __atomic_add_fetch(&a->posted, 1, __ATOMIC_RELAXED);
+    metric_inc(&async_posted);
+
+    // Full queue: everything published so far, then this, into the frame.
+    // Only memory work, the render thread draws it.
+    if (pos == NO_SLOT) {
+        pthread_mutex_lock(&a->lock);
+        drain(a);
+        apply(a, op);
+        pthread_mutex_unlock(&a->lock);
+        __atomic_add_fetch(&a->coalesced, 1, __ATOMIC_RELAXED);
+        metric_inc(&async_coalesced);
+        kick(a);
+        return;
+    }
+    __atomic_store_n(&op->seq, pos + 1, __ATOMIC_RELEASE);
+
+    // Wake the render thread only if it sleeps with nothing to draw, or
+    // if the queue is filling up while it waits for the next frame
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (__atomic_load_n(&a->idle, __ATOMIC_RELAXED) ||
+        pos + 1 - __atomic_load_n(&a->tail, __ATOMIC_RELAXED) >= LCD_ASYNC_QUEUE / 2) {
+        kick(a);
+    }
+}
+
+static int post(lcd_async_t *a, int type, int row, int col, const char *text, int len) {
+    uint64_t pos;
+    lcd_op_t spare;
+    lcd_op_t *op = claim(a, &pos, &spare);
+
+    op->type = type;
+    op->row = row;
+    op->col = col;
+    op->len = len;
+    memcpy(op->text, text, len);
+    publish(a, op, pos);
+    return 0;
+}
+
+int lcd_async_clear(lcd_async_t *a) {
+    return post(a, LCD_OP_CLEAR, 0, 0, NULL, 0);
+}
+
+int lcd_async_cursor(lcd_async_t *a, int row, int col) {
+    if (row < 0 || row >= a->lcd->rows || col < 0 || col >= a->lcd->cols) {
+        return -1;
+    }
+    return post(a, LCD_OP_CURSOR, row, col, NULL, 0);
+}
+
+int lcd_async_write(lcd_async_t *a, const char *str) {
+    int len = strlen(str);
+
+    do {
+        int n = len < LCD_ASYNC_TEXT ? len : LCD_ASYNC_TEXT;
+        if (post(a, LCD_OP_TEXT, 0, 0, str, n) != 0) {
+            return -1;
+        }
+        str += n;
+        len -= n;
+    } while (len > 0);
+    return 0;
+}
+
+int lcd_async_stream(lcd_async_t *a, const char *data, int len) {
+    while (len > 0) {
+        int n = len < LCD_ASYNC_TEXT ? len : LCD_ASYNC_TEXT;
+        if (post(a, LCD_OP_STREAM, 0, 0, data, n) != 0) {
+            return -1;
+        }
+        data += n;
+        len -= n;
+    }
+    return 0;
+}
+
+int lcd_async_scroll(lcd_async_t *a, int lines) {
+    uint64_t pos;
+    lcd_op_t spare;
+    lcd_op_t *op = claim(a, &pos, &spare);
+
+    op->type = LCD_OP_SCROLL;
+    op->len = 0;
+    op->lines = lines < INT16_MIN ? INT16_MIN : (lines > INT16_MAX ? INT16_MAX : lines);
+    publish(a, op, pos);
+    return 0;
+}
+
+int lcd_async_show(lcd_async_t *a, const char *str) {
+    int len = strlen(str);
+
+    return post(a, LCD_OP_SHOW, 0, 0, str, len < LCD_ASYNC_TEXT ? len : LCD_ASYNC_TEXT);
+}
+
+typedef struct {
+    lcd_sink_t sink;
+    lcd_op_t *op;
+} op_sink_t;
+
+static void op_put(lcd_sink_t *sink, char c) {
+    lcd_op_t *op = ((op_sink_t *)sink)->op;
+
+    if (op->len < LCD_ASYNC_TEXT) {
+        op->text[op->len++] = c;
+    }
+}
+
+int lcd_async_printf(lcd_async_t *a, int row, int col, const char *fmt, ...) {
+    uint64_t pos;
+    lcd_op_t spare, *op;
+    va_list ap;
+
+    if (row < 0 || row >= a->lcd->rows || col < 0 || col >= a->lcd->cols) {
+        return -1;
+    }
+    op = claim(a, &pos, &spare);
+    op->type = LCD_OP_AT;
+    op->row = row;
+    op->col = col;
+    op->len = 0;
+
+    op_sink_t s = {{op_put}, op};
+    va_start(ap, fmt);
+    lcd_vformat(&s.sink, fmt, ap);
+    va_end(ap);
+
+    publish(a, op, pos);
+    return 0;
+}
+
+// ---- render thread ----
+
+static void put_text(lcd_async_t *a, const char *text, int len) {
+    int rows = a->lcd->rows, cols = a->lcd->cols;
+
+    for (int i = 0; i < len && a->row < rows; i++) {
+        if (text[i] == '\n') {
+            a->row++;
+            a->col = 0;
+            continue;
+        }
+        a->fb[a->row][a->col] = text[i];
+        if (++a->col == cols) {
+            a->row++;
+            a->col = 0;
+        }
+    }
+}
+
+static void apply(lcd_async_t *a, const lcd_op_t *op) {
+    switch (op->type) {
+    case LCD_OP_SHOW:
+    case LCD_OP_CLEAR:
+        memset(a->fb, ' ', sizeof(a->fb));
+        a->row = 0;
+        a->col = 0;
+        if (op->type == LCD_OP_SHOW) {
+            put_text(a, op->text, op->len);
+        }
+        break;
+    case LCD_OP_CURSOR:
+    case LCD_OP_AT:
+        a->row = op->row;
+        a->col = op->col;
+        if (op->type == LCD_OP_AT) {
+            put_text(a, op->text, op->len);
+        }
+        break;
+    case LCD_OP_TEXT:
+        put_text(a, op->text, op->len);
+        break;
+    case LCD_OP_STREAM:
+        lcd_term_feed(&a->term, op->text, op->len);
+        a->term_dirty = 1;
+        break;
+    case LCD_OP_SCROLL:
+        lcd_term_scroll(&a->term, op->lines);
+        a->term_dirty = 1;
+        break;
+    }
+    __atomic_store_n(&a->dirty, 1, __ATOMIC_RELAXED);
+}
+
+// Apply the published operations in order; called with a->lock held
+static void drain(lcd_async_t *a) {
+    while (1) {
+        lcd_op_t *op = &a->queue[a->tail & (LCD_ASYNC_QUEUE - 1)];
+        if (__atomic_load_n(&op->seq, __ATOMIC_ACQUIRE) != a->tail + 1) {
+            break;
+        }
+        apply(a, op);
+        __atomic_store_n(&op->seq, a->tail + LCD_ASYNC_QUEUE, __ATOMIC_RELEASE);
+        __atomic_store_n(&a->tail, a->tail + 1, __ATOMIC_RELEASE);
+    }
+}
+
+static void drain_locked(lcd_async_t *a) {
+    pthread_mutex_lock(&a->lock);
+    drain(a);
+    pthread_mutex_unlock(&a->lock);
+}
+
+// Send the cells that changed, moving the cursor only across gaps. The
+// frame is copied out under the lock, the bus is driven without it.
+static void flush(lcd_async_t *a) {
+    uint8_t frame[LCD_ASYNC_ROWS][LCD_ASYNC_COLS];
+    uint64_t t0 = timing_now_ns();
+
+    TRACE_BEGIN("lcd_flush");
+    pthread_mutex_lock(&a->lock);
+    // However much was streamed since the last frame, only the viewport
+    // is copied, once
+    if (a->term_dirty) {
+        for (int r = 0; r < a->term.rows; r++) {
+            memcpy(a->fb[r], lcd_term_row(&a->term, r), a->term.cols);
+        }
+        a->term_dirty = 0;
+    }
+    memcpy(frame, a->fb, sizeof(frame));
+    __atomic_store_n(&a->dirty, 0, __ATOMIC_RELAXED);
+    pthread_mutex_unlock(&a->lock);
+
+    for (int r = 0; r < a->lcd->rows; r++) {
+        a->cells += lcd_put_cells(a->lcd, r, 0, (const char *)frame[r], a->lcd->cols);
+    }
+    TRACE_END("lcd_flush");
+
+    a->frames++;
+    metric_inc(&async_frames);
+    metric_observe(&async_flush_ns, timing_now_ns() - t0);
+}
+
+static void *render_thread(void *arg) {
+    lcd_async_t *a = arg;
+    struct pollfd pfd = {a->wake_pipe[0], POLLIN, 0};
+    uint64_t next_flush = 0;
+    char buf[64];
+
+    while (!__atomic_load_n(&a->stopping, __ATOMIC_ACQUIRE)) {
+        // Nothing to draw: say so, then look once more for operations
+        // posted before the producers could see it
+        if (!__atomic_load_n(&a->dirty, __ATOMIC_RELAXED)) {
+            __atomic_store_n(&a->idle, 1, __ATOMIC_RELAXED);
+            __atomic_thread_fence(__ATOMIC_SEQ_CST);
+            drain_locked(a);
+        }
+
+        // Keep draining the queue while waiting for the next frame, so a
+        // fast producer fills the framebuffer and not the queue
+        int timeout = LCD_ASYNC_POLL_MS;
+        if (__atomic_load_n(&a->dirty, __ATOMIC_RELAXED)) {
+            uint64_t now = timing_now_ns();
+            timeout = now >= next_flush ? 0 : (int)((next_flush - now + TIMING_MS - 1) / TIMING_MS);
+        }
+        if (poll(&pfd, 1, timeout) > 0) {
+            while (read(a->wake_pipe[0], buf, sizeof(buf)) == sizeof(buf)) {
+            }
+        }
+        __atomic_store_n(&a->idle, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&a->kicked, 0, __ATOMIC_RELEASE);
+        drain_locked(a);
+
+        if (__atomic_load_n(&a->dirty, __ATOMIC_RELAXED) && timing_now_ns() >= next_flush) {
+            flush(a);
+            next_flush = timing_now_ns() + a->interval_ns;
+        }
+    }
+
+    drain_locked(a);
+    if (__atomic_load_n(&a->dirty, __ATOMIC_RELAXED)) {
+        flush(a);
+    }
+    return NULL;
+}
+
+int lcd_async_start(lcd_async_t *a, lcd_t *lcd, int max_fps) {
+    memset(a, 0, sizeof(*a));
+    if (lcd->rows > LCD_ASYNC_ROWS || lcd->cols > LCD_ASYNC_COLS) {
+        fprintf(stderr, "LCD of %dx%d is too large for the async renderer\n", lcd->cols, lcd->rows);
+        return -1;
+    }
+    a->lcd = lcd;
+    a->interval_ns = max_fps > 0 ? TIMING_S / max_fps : 0;
+    for (uint64_t i = 0; i < LCD_ASYNC_QUEUE; i++) {
+        a->queue[i].seq = i;
+    }
+
+    // The screen starts blank, and so do the framebuffer and the terminal
+    lcd_clear(lcd);
+    memset(a->fb, ' ', sizeof(a->fb));
+    lcd_term_init(&a->term, lcd->rows, lcd->cols);
+    pthread_mutex_init(&a->lock, NULL);
+
+    if (pipe(a->wake_pipe) != 0) {
+        fprintf(stderr, "lcd_async: pipe failed: %s\n", strerror(errno));
+        return -1;
+    }
+    fcntl(a->wake_pipe[0], F_SETFL, O_NONBLOCK);
+    fcntl(a->wake_pipe[1], F_SETFL, O_NONBLOCK);
+    if (pthread_create(&a->thread, NULL, render_thread, a) != 0) {
+        fprintf(stderr, "lcd_async: cannot start the render thread\n");
+        close(a->wake_pipe[0]);
+        close(a->wake_pipe[1]);
+        return -1;
+    }
+    return 0;
+}
+
+void lcd_async_stop(lcd_async_t *a) {
+    __atomic_store_n(&a->stopping, 1, __ATOMIC_RELEASE);
+    __atomic_store_n(&a->kicked, 0, __ATOMIC_RELEASE);
+    kick(a);
+    pthread_join(a->thread, NULL);
+    close(a->wake_pipe[0]);
+    close(a->wake_pipe[1]);
+    pthread_mutex_destroy(&a->lock);
+}
@@ -0,0 +1,101 @@
+#ifndef LCD_ASYNC_H
+#define LCD_ASYNC_H
+
+#include <stdint.h>
+#include <pthread.h>
+#include "lcd.h"
+#include "lcd_term.h"
+
+// Non-blocking front end for the LCD.
+//
+// Producers post clear, cursor and text operations to a bounded lock-free
+// queue and return; a render thread applies them to a framebuffer and
+// copies to the display only the cells that differ from what it shows,
+// at most max_fps times a second. Whatever was posted between two flushes
+// is coalesced: intermediate frames are never drawn, and a clear costs no
+// 1.5 ms clear command, only the cells it blanks.
+//
+// Posting copies at most LCD_ASYNC_TEXT bytes and makes one write() to
+// wake the render thread when it sleeps; it never waits for the bus. When
+// the queue is full nothing is dropped: the producer applies what is queued
+// and its own operation to the pending frame itself (under a lock the
+// render thread only holds for memory work, never across the bus), so the
+// latest state is always drawn.
+//
+// Text wraps onto the next row at the right edge (the controller itself
+// would carry on into its off-screen memory) and stops at the bottom right
+// corner. Bytes 0-7 are the CGRAM characters, '\n' moves to the next row.
+//
+// For a stream such as a UART, lcd_async_stream() runs the display as a
+// terminal instead (see lcd_term.h): the bytes are fed to a scrollback ring
+// in the render thread, and each frame shows its viewport. Stream and
+// screen operations are not meant to be mixed.
+
+#define LCD_ASYNC_QUEUE 64     // operations, power of two
+#define LCD_ASYNC_TEXT  32     // bytes per operation, a whole 16x2 screen
+#define LCD_ASYNC_ROWS  4
+#define LCD_ASYNC_COLS  40
+
+typedef enum {
+    LCD_OP_CLEAR = 0,
+    LCD_OP_CURSOR,
+    LCD_OP_TEXT,
+    LCD_OP_SHOW,               // clear, home and text in one operation
+    LCD_OP_AT,                 // cursor and text in one operation
+    LCD_OP_STREAM,             // bytes for the terminal
+    LCD_OP_SCROLL              // move the terminal viewport
+} lcd_op_type_t;
+
+typedef struct {
+    uint64_t seq;              // queue position this slot is ready for
+    uint8_t type;
+    uint8_t row, col, len;
+    int16_t lines;             // LCD_OP_SCROLL
+    char text[LCD_ASYNC_TEXT];
+} lcd_op_t;
+
+typedef struct {
+    lcd_t *lcd;
+    uint64_t interval_ns;
+
+    lcd_op_t queue[LCD_ASYNC_QUEUE];
+    uint64_t head, tail;
+    int kicked, idle, stopping;
+    int wake_pipe[2];
+    pthread_t thread;
+
+    // The frame being built (the LCD keeps what it shows): the render
+    // thread applies the queue to it, and a producer facing a full queue
+    pthread_mutex_t lock;
+    uint8_t fb[LCD_ASYNC_ROWS][LCD_ASYNC_COLS];
+    int row, col, dirty;
+    lcd_term_t term;
+    int term_dirty;            // the viewport changed since the last frame
+
+    unsigned long posted, coalesced, frames, cells;   // coalesced: posted into a full queue
+} lcd_async_t;
+
+// Clears the (initialised) display and starts the render thread
+int lcd_async_start(lcd_async_t *a, lcd_t *lcd, int max_fps);
+
+// Draws what is still queued, then stops the render thread
+void lcd_async_stop(lcd_async_t *a);
+
+int lcd_async_clear(lcd_async_t *a);
+int lcd_async_cursor(lcd_async_t *a, int row, int col);
+int lcd_async_write(lcd_async_t *a, const char *str);   // split into several operations if long
+
+// The usual "clear and write": replaces the whole screen, atomically.
+// Text beyond LCD_ASYNC_TEXT bytes is cut.
+int lcd_async_show(lcd_async_t *a, const char *str);
+
+// lcd_printf() for the render thread: formatted straight into the queue
+// slot, at most LCD_ASYNC_TEXT characters
+int lcd_async_printf(lcd_async_t *a, int row, int col, const char *fmt, ...) __attribute__((format(printf, 4, 5)));
+
+// Terminal mode: queue raw bytes (split into several operations if long),
+// and scroll the viewport back (lines > 0) or forward
+int lcd_async_stream(lcd_async_t *a, const char *data, int len);
+int lcd_async_scroll(lcd_async_t *a, int lines);
+
+#endif
@@ -0,0 +1,98 @@
+#include <stdio.h>
+#include <string.h>
+#include "lcd_bar.h"
+#include "timing.h"
+#include "trace.h"
+#include "metrics.h"
+
+static METRIC_DEFINE(bar_cells, METRIC_COUNTER, "lcd_bar_cells_total", "Bar graph cells sent to the LCD")
+static METRIC_DEFINE(bar_frames, METRIC_COUNTER, "lcd_bar_frames_total", "Bar graph frames drawn")
+
+#define LCD_BLOCK 0xFF   // solid 5x8 block in the HD44780 A00 and A02 ROMs
+
+// 1 to 4 pixel columns lit from the left
+static const lcd_glyph_t partial[4] = {
+    {0, {0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10, 0x10}},
+    {0, {0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18, 0x18}},
+    {0, {0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C, 0x1C}},
+    {0, {0x1E, 0x1E, 0x1E, 0x1E, 0x1E, 0x1E, 0x1E, 0x1E}},
+};
+
+int lcd_bar_init(lcd_bar_t *bar, lcd_t *lcd, int row, int col, int cells, int max_fps) {
+    memset(bar, 0, sizeof(*bar));
+    if (row < 0 || row >= lcd->rows || col < 0 || cells <= 0 ||
+        cells > LCD_BAR_MAX_CELLS || col + cells > lcd->cols) {
+        fprintf(stderr, "LCD bar of %d cells does not fit at %d,%d\n", cells, row, col);
+        return -1;
+    }
+    bar->lcd = lcd;
+    bar->row = row;
+    bar->col = col;
+    bar->cells = cells;
+    bar->interval_ns = max_fps > 0 ? TIMING_S / max_fps : 0;
+    bar->max = 1;
+
+    lcd_set_cursor(lcd, row, col);
+    for (int i = 0; i < cells; i++) {
+        lcd_data(lcd, ' ');
+    }
+    return 0;
+}
+
+static int draw(lcd_bar_t *bar) {
+    int steps = bar->cells * 5;
+    int lit = (int)((int64_t)bar->value * steps / bar->max);
+    char cells[LCD_BAR_MAX_CELLS];
+    int sent;
+
+    TRACE_BEGIN("lcd_bar");
+    lcd_glyph_frame(bar->lcd);   // the partial glyph below must stay until it is sent
+    for (int i = 0; i < bar->cells; i++) {
+        int fill = lit - i * 5;
+        uint8_t code;
+
+        if (fill >= 5) {
+            code = LCD_BLOCK;
+        } else if (fill <= 0) {
+            code = ' ';
+        } else {
+            int slot = lcd_glyph_slot(bar->lcd, &partial[fill - 1]);
+            code = slot >= 0 ? (uint8_t)slot : ' ';
+        }
+        cells[i] = (char)code;
+    }
+    sent = lcd_put_cells(bar->lcd, bar->row, bar->col, cells, bar->cells);
+    TRACE_END("lcd_bar");
+
+    bar->pending = 0;
+    bar->frames++;
+    bar->cells_written += sent;
+    metric_inc(&bar_frames);
+    metric_add(&bar_cells, sent);
+    return sent;
+}
+
+int lcd_bar_update(lcd_bar_t *bar, int value, int max) {
+    uint64_t now = timing_now_ns();
+
+    if (max <= 0) {
+        max = 1;
+    }
+    bar->value = value < 0 ? 0 : (value > max ? max : value);
+    bar->max = max;
+    bar->pending = 1;
+
+    if (bar->interval_ns && now - bar->last_ns < bar->interval_ns) {
+        return 0;
+    }
+    bar->last_ns = now;
+    return draw(bar);
+}
+
+int lcd_bar_flush(lcd_bar_t *bar) {
+    if (!bar->pending) {
+        return 0;
+    }
+    bar->last_ns = timing_now_ns();
+    return draw(bar);
+}
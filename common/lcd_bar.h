@@ -0,0 +1,39 @@
+#ifndef LCD_BAR_H
+#define LCD_BAR_H
+
+#include <stdint.h>
+#include "lcd.h"
+
+// Horizontal bar graph on one row of the LCD, for live levels.
+//
+// Each cell is 5 pixel columns wide, so a 16 cell bar has 80 steps: full
+// cells use the ROM's solid block (0xFF), the one partly filled cell a
+// custom glyph with 1-4 columns lit (through the glyph cache, so at most 4
+// CGRAM slots, each uploaded once). Each frame is compared with the
+// driver's copy of the screen (lcd->shown) and only the cells that differ
+// are sent, typically one or two bytes per frame.
+//
+// lcd_bar_update() may be called at any rate; frames are drawn at most
+// max_fps times a second, with the latest value.
+
+#define LCD_BAR_MAX_CELLS 40
+
+typedef struct {
+    lcd_t *lcd;
+    int row, col, cells;
+    uint64_t interval_ns, last_ns;
+    int value, max, pending;
+    unsigned long frames, cells_written;
+} lcd_bar_t;
+
+// Draws an empty bar. Returns -1 if the bar does not fit on the display.
+int lcd_bar_init(lcd_bar_t *bar, lcd_t *lcd, int row, int col, int cells, int max_fps);
+
+// Show value out of max (clamped). Returns the number of cells sent, 0 when
+// nothing changed or the frame was deferred by the rate limit.
+int lcd_bar_update(lcd_bar_t *bar, int value, int max);
+
+// Draw a deferred value now, regardless of the rate limit
+int lcd_bar_flush(lcd_bar_t *bar);
+
+#endif
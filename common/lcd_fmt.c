@@ -0,0 +1,315 @@
+#include <stdint.h>
+#include <stddef.h>
+#include "lcd_fmt.h"
+
+#define FLAG_LEFT  0x01
+#define FLAG_ZERO  0x02
+#define FLAG_PLUS  0x04
+#define FLAG_SPACE 0x08
+
+typedef struct {
+    int flags, width, prec;     // prec -1 when not given
+} spec_t;
+
+static void pad(lcd_sink_t *sink, char c, int n, int *count) {
+    for (int i = 0; i < n; i++) {
+        sink->put(sink, c);
+    }
+    *count += n > 0 ? n : 0;
+}
+
+// Sign, then digits[] (most significant first) laid out in the field
+static void emit_number(lcd_sink_t *sink, const spec_t *sp, char sign,
+                        const char *digits, int ndigits, int *count) {
+    int len = ndigits + (sign != 0);
+    int fill = sp->width - len;
+
+    if (!(sp->flags & FLAG_LEFT) && !(sp->flags & FLAG_ZERO)) {
+        pad(sink, ' ', fill, count);
+    }
+    if (sign) {
+        sink->put(sink, sign);
+        (*count)++;
+    }
+    if (!(sp->flags & FLAG_LEFT) && (sp->flags & FLAG_ZERO)) {
+        pad(sink, '0', fill, count);
+    }
+    for (int i = 0; i < ndigits; i++) {
+        sink->put(sink, digits[i]);
+    }
+    *count += ndigits;
+    if (sp->flags & FLAG_LEFT) {
+        pad(sink, ' ', fill, count);
+    }
+}
+
+static char sign_of(const spec_t *sp, int negative) {
+    if (negative) {
+        return '-';
+    }
+    return (sp->flags & FLAG_PLUS) ? '+' : ((sp->flags & FLAG_SPACE) ? ' ' : 0);
+}
+
+// Digits of v in 'base', most significant first; returns how many
+static int to_digits(uint64_t v, unsigned base, int upper, int min_digits, char *out) {
+    const char *set = upper ? "0123456789ABCDEF" : "0123456789abcdef";
+    char rev[24];
+    int n = 0;
+
+    do {
+        rev[n++] = set[v % base];
+        v /= base;
+    } while (v != 0);
+    while (n < min_digits && n < (int)sizeof(rev)) {
+        rev[n++] = '0';
+    }
+    for (int i = 0; i < n; i++) {
+        out[i] = rev[n - 1 - i];
+    }
+    return n;
+}
+
+static void format_int(lcd_sink_t *sink, const spec_t *sp, uint64_t v, int negative,
+                       unsigned base, int upper, int *count) {
+    char digits[24];
+    int n;
+
+    if (sp->prec == 0 && v == 0) {
+        n = 0;   // as printf: "%.0d" of 0 prints nothing
+    } else {
+        n = to_digits(v, base, upper, sp->prec, digits);
+    }
+    spec_t s = *sp;
+    if (sp->prec >= 0) {
+        s.flags &= ~FLAG_ZERO;
+    }
+    emit_number(sink, &s, sign_of(sp, negative), digits, n, count);
+}
+
+// Fixed point: split into whole part and fraction, scale and round the
+// fraction in double, then print both as integers with a '.' between
+static void format_fixed(lcd_sink_t *sink, const spec_t *sp, double v, int *count) {
+    static const uint64_t pow10[10] = {1, 10, 100, 1000, 10000, 100000, 1000000,
+                                       10000000, 100000000, 1000000000};
+    int prec = sp->prec < 0 ? 6 : (sp->prec > 9 ? 9 : sp->prec);
+    int negative = v < 0;
+    char digits[32];
+    int n;
+
+    if (v != v) {
+        emit_number(sink, sp, 0, "nan", 3, count);
+        return;
+    }
+    if (negative) {
+        v = -v;
+    }
+    if (v >= 1e18) {
+        emit_number(sink, sp, sign_of(sp, negative), "inf", 3, count);
+        return;
+    }
+
+    uint64_t whole = (uint64_t)v;
+    uint64_t frac = (uint64_t)((v - (double)whole) * pow10[prec] + 0.5);
+    if (frac >= pow10[prec]) {
+        whole++;
+        frac -= pow10[prec];
+    }
+
+    n = to_digits(whole, 10, 0, 1, digits);
+    if (prec > 0) {
+        digits[n++] = '.';
+        n += to_digits(frac, 10, 0, prec, digits + n);
+    }
+    emit_number(sink, sp, sign_of(sp, negative && (whole || frac)), digits, n, count);
+}
+
+static void format_str(lcd_sink_t *sink, const spec_t *sp, const char *s, int *count) {
+    int len = 0;
+
+    if (s == NULL) {
+        s = "(null)";
+    }
+    while (s[len] && (sp->prec < 0 || len < sp->prec)) {
+        len++;
+    }
+    if (!(sp->flags & FLAG_LEFT)) {
+        pad(sink, ' ', sp->width - len, count);
+    }
+    for (int i = 0; i < len; i++) {
+        sink->put(sink, s[i]);
+    }
+    *count += len;
+    if (sp->flags & FLAG_LEFT) {
+        pad(sink, ' ', sp->width - len, count);
+    }
+}
+
+int lcd_vformat(lcd_sink_t *sink, const char *fmt, va_list ap) {
+    int count = 0;
+
+    for (const char *p = fmt; *p; p++) {
+        if (*p != '%') {
+            sink->put(sink, *p);
+            count++;
+            continue;
+        }
+
+        spec_t sp = {0, 0, -1};
+        for (p++; ; p++) {
+            if (*p == '-') {
+                sp.flags |= FLAG_LEFT;
+            } else if (*p == '0') {
+                sp.flags |= FLAG_ZERO;
+            } else if (*p == '+') {
+                sp.flags |= FLAG_PLUS;
+            } else if (*p == ' ') {
+                sp.flags |= FLAG_SPACE;
+            } else {
+                break;
+            }
+        }
+        if (*p == '*') {
+            sp.width = va_arg(ap, int);
+            if (sp.width < 0) {
+                sp.flags |= FLAG_LEFT;
+                sp.width = -sp.width;
+            }
+            p++;
+        } else {
+            while (*p >= '0' && *p <= '9') {
+                sp.width = sp.width * 10 + (*p++ - '0');
+            }
+        }
+        if (*p == '.') {
+            p++;
+            sp.prec = 0;
+            if (*p == '*') {
+                sp.prec = va_arg(ap, int);
+                p++;
+            } else {
+                while (*p >= '0' && *p <= '9') {
+                    sp.prec = sp.prec * 10 + (*p++ - '0');
+                }
+            }
+        }
+
+        // Length modifiers: how wide the integer argument is
+        int size = 0;   // 0 int, 1 long, 2 long long, 3 size_t, 4 intmax_t, 5 ptrdiff_t
+        while (*p == 'h') {
+            p++;        // promoted to int anyway
+        }
+        if (*p == 'l') {
+            size = 1;
+            if (*++p == 'l') {
+                size = 2;
+                p++;
+            }
+        } else if (*p == 'z') {
+            size = 3;
+            p++;
+        } else if (*p == 'j') {
+            size = 4;
+            p++;
+        } else if (*p == 't') {
+            size = 5;
+            p++;
+        }
+        if (*p == '\0') {
+            break;
+        }
+
+        switch (*p) {
+        case 'd':
+        case 'i': {
+            int64_t v;
+            switch (size) {
+            case 1: v = va_arg(ap, long); break;
+            case 2: v = va_arg(ap, long long); break;
+            case 3: v = va_arg(ap, ptrdiff_t); break;
+            case 4: v = va_arg(ap, intmax_t); break;
+            case 5: v = va_arg(ap, ptrdiff_t); break;
+            default: v = va_arg(ap, int); break;
+            }
+            format_int(sink, &sp, v < 0 ? -(uint64_t)v : (uint64_t)v, v < 0, 10, 0, &count);
+            break;
+        }
+        case 'u':
+        case 'x':
+        case 'X':
+        case 'o': {
+            uint64_t v;
+            switch (size) {
+            case 1: v = va_arg(ap, unsigned long); break;
+            case 2: v = va_arg(ap, unsigned long long); break;
+            case 3: v = va_arg(ap, size_t); break;
+            case 4: v = va_arg(ap, uintmax_t); break;
+            case 5: v = va_arg(ap, ptrdiff_t); break;
+            default: v = va_arg(ap, unsigned int); break;
+            }
+            unsigned base = *p == 'u' ? 10 : (*p == 'o' ? 8 : 16);
+            spec_t s = sp;
+            s.flags &= ~(FLAG_PLUS | FLAG_SPACE);
+            format_int(sink, &s, v, 0, base, *p == 'X', &count);
+            break;
+        }
+        case 'c': {
+            char c = (char)va_arg(ap, int);
+            spec_t s = sp;
+            s.prec = -1;
+            if (!(s.flags & FLAG_LEFT)) {
+                pad(sink, ' ', s.width - 1, &count);
+            }
+            sink->put(sink, c);
+            count++;
+            if (s.flags & FLAG_LEFT) {
+                pad(sink, ' ', s.width - 1, &count);
+            }
+            break;
+        }
+        case 's':
+            format_str(sink, &sp, va_arg(ap, const char *), &count);
+            break;
+        case 'f':
+        case 'F':
+            format_fixed(sink, &sp, va_arg(ap, double), &count);
+            break;
+        case '%':
+            sink->put(sink, '%');
+            count++;
+            break;
+        default:
+            sink->put(sink, '?');
+            count++;
+            break;
+        }
+    }
+    return count;
+}
+
+typedef struct {
+    lcd_sink_t sink;
+    char *buf;
+    int size, len;
+} buf_sink_t;
+
+static void buf_put(lcd_sink_t *sink, char c) {
+    buf_sink_t *b = (buf_sink_t *)sink;
+
+    if (b->len < b->size - 1) {
+        b->buf[b->len++] = c;
+    }
+}
+
+int lcd_snprintf(char *buf, int size, const char *fmt, ...) {
+    buf_sink_t b = {{buf_put}, buf, size, 0};
+    va_list ap;
+
+    if (size <= 0) {
+        return 0;
+    }
+    va_start(ap, fmt);
+    lcd_vformat(&b.sink, fmt, ap);
+    va_end(ap);
+    buf[b.len] = '\0';
+    return b.len;
+}
@@ -0,0 +1,33 @@
+#ifndef LCD_FMT_H
+#define LCD_FMT_H
+
+#include <stdarg.h>
+
+// printf-style formatting without buffers, for the LCD.
+//
+// lcd_vformat() hands each character to a sink as it is produced, so
+// lcd_printf() can compare it with the cell on screen and lcd_async_printf()
+// can write it into the queue slot; nothing is allocated or copied.
+//
+// Supported: %d %i %u %x %X %o %c %s %f %%, the flags - 0 + and space,
+// width and precision (also as *), and the h hh l ll z j t length
+// modifiers. %f takes a double and prints it in fixed point: the whole
+// part and the fraction, scaled to 'precision' digits and rounded in
+// double, are printed as integers, without libc's float formatting
+// (precision 0-9, default 6). Halves round away from zero, give or take
+// the double's own error, and "-0.0" is never shown; use it with a width, e.g. "%6.2f", so the field
+// keeps its size as the value changes. Anything else prints as '?'.
+
+typedef struct lcd_sink lcd_sink_t;
+
+struct lcd_sink {
+    void (*put)(lcd_sink_t *sink, char c);
+};
+
+// Returns the number of characters produced
+int lcd_vformat(lcd_sink_t *sink, const char *fmt, va_list ap);
+
+// Into a buffer, always NUL terminated; returns the length written
+int lcd_snprintf(char *buf, int size, const char *fmt, ...) __attribute__((format(printf, 3, 4)));
+
+#endif
@@ -0,0 +1,142 @@
+#include <stdio.h>
+#include "lcd.h"
+#include "metrics.h"
+
+static METRIC_DEFINE(glyph_uploads, METRIC_COUNTER, "lcd_glyph_uploads_total", "Custom characters written to CGRAM")
+static METRIC_DEFINE(glyph_misses, METRIC_COUNTER, "lcd_glyph_unavailable_total", "Custom characters drawn as '?' for lack of a CGRAM slot")
+
+void lcd_glyph_set(lcd_t *lcd, const lcd_glyph_t *set, int n) {
+    lcd->glyphs.set = set;
+    lcd->glyphs.set_size = n;
+}
+
+void lcd_glyph_frame(lcd_t *lcd) {
+    lcd->glyphs.frame_start = ++lcd->glyphs.tick;
+}
+
+// Write the pattern into a slot: 1 + 8 bytes, plus one to put the cursor back
+static void upload(lcd_t *lcd, int slot, const lcd_glyph_t *glyph) {
+    int was_cgram = lcd->in_cgram;
+    uint8_t addr = lcd->addr;
+
+    lcd_command(lcd, LCD_SET_CGRAM | (slot << 3));
+    for (int i = 0; i < 8; i++) {
+        lcd_data(lcd, glyph->rows[i] & 0x1F);
+    }
+    if (!was_cgram) {
+        lcd_command(lcd, LCD_SET_DDRAM | addr);
+    }
+    lcd->glyphs.uploads++;
+    metric_inc(&glyph_uploads);
+}
+
+// Slots whose character code (0-7, or its alias 8-15) is in a visible cell
+static unsigned on_screen(const lcd_t *lcd) {
+    unsigned mask = 0;
+
+    for (int r = 0; r < lcd->rows && r < LCD_MAX_ROWS; r++) {
+        for (int col = 0; col < lcd->cols && col < LCD_MAX_COLS; col++) {
+            if (lcd->shown[r][col] < 2 * LCD_CGRAM_SLOTS) {
+                mask |= 1u << (lcd->shown[r][col] & (LCD_CGRAM_SLOTS - 1));
+            }
+        }
+    }
+    return mask;
+}
+
+int lcd_glyph_slot(lcd_t *lcd, const lcd_glyph_t *glyph) {
+    lcd_glyph_cache_t *c = &lcd->glyphs;
+    int victim = -1;
+    unsigned busy;
+
+    for (int i = 0; i < LCD_CGRAM_SLOTS; i++) {
+        if (c->slot[i] == glyph) {
+            c->last_used[i] = ++c->tick;
+            c->hits++;
+            return i;
+        }
+    }
+
+    // Prefer an empty slot, then the least recently used one that is
+    // neither on screen nor handed out in the current frame (and maybe not
+    // written yet)
+    busy = on_screen(lcd);
+    for (int i = 0; i < LCD_CGRAM_SLOTS; i++) {
+        if (c->slot[i] == NULL) {
+            victim = i;
+            break;
+        }
+        if (!(busy & (1u << i)) && c->last_used[i] < c->frame_start &&
+            (victim < 0 || c->last_used[i] < c->last_used[victim])) {
+            victim = i;
+        }
+    }
+    if (victim < 0) {
+        metric_inc(&glyph_misses);
+        return -1;
+    }
+
+    upload(lcd, victim, glyph);
+    c->slot[victim] = glyph;
+    c->last_used[victim] = ++c->tick;
+    return victim;
+}
+
+void lcd_glyph_put(lcd_t *lcd, const lcd_glyph_t *glyph) {
+    int slot = lcd_glyph_slot(lcd, glyph);
+
+    lcd_data(lcd, slot >= 0 ? (uint8_t)slot : '?');
+}
+
+static const lcd_glyph_t *find(const lcd_glyph_cache_t *c, uint32_t code) {
+    for (int i = 0; i < c->set_size; i++) {
+        if (c->set[i].code == code) {
+            return &c->set[i];
+        }
+    }
+    return NULL;
+}
+
+// Next code point of a UTF-8 string; malformed bytes come out as themselves
+static uint32_t next_code(const char **s) {
+    const uint8_t *p = (const uint8_t *)*s;
+    uint32_t code = p[0];
+    int extra = 0;
+
+    if (code >= 0xF0) {
+        code &= 0x07;
+        extra = 3;
+    } else if (code >= 0xE0) {
+        code &= 0x0F;
+        extra = 2;
+    } else if (code >= 0xC0) {
+        code &= 0x1F;
+        extra = 1;
+    }
+    for (int i = 1; i <= extra; i++) {
+        if ((p[i] & 0xC0) != 0x80) {
+            *s += 1;
+            return p[0];
+        }
+        code = (code << 6) | (p[i] & 0x3F);
+    }
+    *s += 1 + extra;
+    return code;
+}
+
+void lcd_glyph_write(lcd_t *lcd, const char *utf8) {
+    while (*utf8) {
+        uint32_t code = next_code(&utf8);
+
+        if (code < 0x80) {
+            lcd_data(lcd, (uint8_t)code);
+            continue;
+        }
+        const lcd_glyph_t *glyph = find(&lcd->glyphs, code);
+        if (glyph != NULL) {
+            lcd_glyph_put(lcd, glyph);
+        } else {
+            lcd_data(lcd, '?');
+        }
+    }
+}
@@ -0,0 +1,117 @@
+#include <string.h>
+#include "lcd_term.h"
+
+#define TAB_WIDTH 4
+
+static const char blank[LCD_MAX_COLS] = "                                        ";
+
+static char *line(lcd_term_t *t, uint32_t n) {
+    return t->lines[n & (LCD_TERM_LINES - 1)];
+}
+
+void lcd_term_init(lcd_term_t *t, int rows, int cols) {
+    memset(t, 0, sizeof(*t));
+    t->rows = rows > LCD_MAX_ROWS ? LCD_MAX_ROWS : rows;
+    t->cols = cols > LCD_MAX_COLS ? LCD_MAX_COLS : cols;
+    memset(t->lines, ' ', sizeof(t->lines));
+}
+
+// The oldest line still in the ring limits how far back we can look
+static int max_back(const lcd_term_t *t) {
+    int back = (int)t->last - (t->rows - 1);
+    int ring = LCD_TERM_LINES - t->rows;
+
+    if (back < 0) {
+        return 0;
+    }
+    return back < ring ? back : ring;
+}
+
+static void new_line(lcd_term_t *t) {
+    t->last++;
+    t->col = 0;
+    t->pending = 0;
+    t->new_lines++;
+    memset(line(t, t->last), ' ', LCD_MAX_COLS);
+
+    // Keep a scrolled back viewport on the text it shows
+    if (t->back > 0) {
+        t->back++;
+        if (t->back > max_back(t)) {
+            t->back = max_back(t);
+        }
+    }
+}
+
+static void put(lcd_term_t *t, char c) {
+    if (t->pending || t->col == t->cols) {
+        new_line(t);
+    }
+    line(t, t->last)[t->col++] = c;
+}
+
+void lcd_term_feed(lcd_term_t *t, const char *data, int len) {
+    t->bytes += len;
+    for (int i = 0; i < len; i++) {
+        uint8_t c = data[i];
+
+        switch (c) {
+        case '\n':
+            if (t->pending) {
+                new_line(t);   // an empty line
+            }
+            t->pending = 1;
+            break;
+        case '\r':
+            t->col = 0;
+            break;
+        case '\b':
+            if (t->col > 0) {
+                t->col--;
+            }
+            break;
+        case '\t':
+            do {
+                put(t, ' ');
+            } while (t->col % TAB_WIDTH != 0 && t->col < t->cols);
+            break;
+        case '\f':
+            memset(t->lines, ' ', sizeof(t->lines));
+            t->last = 0;
+            t->col = 0;
+            t->pending = 0;
+            t->back = 0;
+            break;
+        default:
+            if (c >= 0x20 && c != 0x7F) {
+                put(t, c);
+            }
+            break;
+        }
+    }
+}
+
+int lcd_term_scroll(lcd_term_t *t, int lines) {
+    int back = t->back + lines;
+
+    if (back < 0) {
+        back = 0;
+    } else if (back > max_back(t)) {
+        back = max_back(t);
+    }
+    t->back = back;
+    return back;
+}
+
+const char *lcd_term_row(const lcd_term_t *t, int row) {
+    // Until the screen is full the text starts on the top row
+    int32_t top = (int32_t)t->last - t->back - (t->rows - 1);
+
+    if (top < 0) {
+        top = 0;
+    }
+    if (row < 0 || row >= t->rows || (uint32_t)(top + row) > t->last) {
+        return blank;
+    }
+    return t->lines[(top + row) & (LCD_TERM_LINES - 1)];
+}
@@ -0,0 +1,45 @@
+#ifndef LCD_TERM_H
+#define LCD_TERM_H
+
+#include <stdint.h>
+#include "lcd.h"
+
+// Text terminal over a scrollback ring, for streams such as a UART.
+//
+// Bytes are taken as they come: printable characters go at the cursor and
+// wrap onto a new line past the last column, '\n' starts a new line ('\r\n'
+// too, as does a bare '\n'), '\r' goes back to the start of the line,
+// '\b' moves back one column, '\t' moves to the next multiple of 4 and
+// '\f' clears everything. Other control bytes are dropped. New lines are
+// only started once there is something to put on them, so exactly 'cols'
+// characters followed by '\n' take one line, and a stream of "...\r\n"
+// lines keeps the latest one on the bottom row rather than an empty row.
+//
+// The LCD shows a viewport of 'rows' lines. It follows the newest line
+// unless scrolled back with lcd_term_scroll(); a scrolled back viewport
+// stays on the same text while more arrives, until it drops out of the
+// ring. Nothing here touches the bus: see lcd_async_stream() for that.
+
+#define LCD_TERM_LINES 64      // scrollback, power of two
+
+typedef struct {
+    int rows, cols;
+    char lines[LCD_TERM_LINES][LCD_MAX_COLS];
+    uint32_t last;             // number of the line the cursor is on
+    int col;
+    int pending;               // a '\n' waits for the next character
+    int back;                  // viewport distance from the newest line
+    unsigned long bytes, new_lines;
+} lcd_term_t;
+
+void lcd_term_init(lcd_term_t *t, int rows, int cols);
+void lcd_term_feed(lcd_term_t *t, const char *data, int len);
+
+// Move the viewport 'lines' back in time (negative: towards the newest
+// line), clamped to the scrollback; returns how far back it now is
+int lcd_term_scroll(lcd_term_t *t, int lines);
+
+// Row 0 to rows-1 of the viewport, 'cols' characters, not NUL terminated
+const char *lcd_term_row(const lcd_term_t *t, int row);
+
+#endif
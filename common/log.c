@@ -0,0 +1,395 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <time.h>
+#include <unistd.h>
+#include "log.h"
+#include "rt.h"
+
+#define LOG_POLL_MS 10   // writer wakeup when nobody kicks it
+
+typedef struct {
+    uint64_t seq;             // ring position this slot is ready for
+    uint32_t suppressed;      // nonzero: "lines suppressed" note for site
+    int nargs;
+    uint64_t ts_ns;
+    const log_site_t *site;
+    log_arg_t args[LOG_MAX_ARGS];  // strings hold an offset into text
+    char text[LOG_TEXT_SIZE];
+} log_record_t;
+
+volatile int log_level = LOG_LVL_INFO;
+
+static log_record_t ring[LOG_RING_SIZE];
+static uint64_t head = 0;     // next position producers claim
+static uint64_t tail = 0;     // next position the writer formats
+static int started = 0;
+static int kicked = 0;
+static uint32_t rate_limit = 0;
+static log_site_t *limited = NULL;    // sites that have suppressed lines
+static int show_time = 0;
+static int wake_pipe[2] = {-1, -1};
+static pthread_mutex_t sync_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// ---- formatting (writer side) ----
+
+static int64_t arg_int(const log_arg_t *a) {
+    return a->type == 'f' ? (int64_t)a->v.f : a->v.i;
+}
+
+static double arg_double(const log_arg_t *a) {
+    return a->type == 'f' ? a->v.f : (double)a->v.i;
+}
+
+// printf() the format of the call site, one conversion at a time with the
+// recorded argument cast to what the conversion expects
+static void format(FILE *out, const char *fmt, const log_arg_t *args, int nargs, const char *text) {
+    char spec[32];
+    int next = 0;
+
+    for (const char *p = fmt; *p; p++) {
+        if (*p != '%') {
+            fputc(*p, out);
+            continue;
+        }
+        if (p[1] == '%') {
+            fputc('%', out);
+            p++;
+            continue;
+        }
+
+        int n = 0;
+        spec[n++] = '%';
+        for (p++; *p && strchr("-+ #0123456789.", *p) && n < 24; p++) {
+            spec[n++] = *p;
+        }
+        while (*p && strchr("hlLqjzt", *p)) {
+            p++;  // every integer is recorded as 64 bits
+        }
+        if (*p == '\0') {
+            break;
+        }
+
+        char conv = *p;
+        if (next == nargs) {
+            fputs("<?>", out);
+            continue;
+        }
+        const log_arg_t *a = &args[next++];
+
+        switch (conv) {
+        case 'd':
+        case 'i':
+            memcpy(spec + n, "ll", 2);
+            spec[n + 2] = conv;
+            spec[n + 3] = '\0';
+            fprintf(out, spec, (long long)arg_int(a));
+            break;
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X':
+            memcpy(spec + n, "ll", 2);
+            spec[n + 2] = conv;
+            spec[n + 3] = '\0';
+            fprintf(out, spec, (unsigned long long)arg_int(a));
+            break;
+        case 'c':
+            spec[n] = conv;
+            spec[n + 1] = '\0';
+            fprintf(out, spec, (int)arg_int(a));
+            break;
+        case 'e':
+        case 'E':
+        case 'f':
+        case 'F':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            spec[n] = conv;
+            spec[n + 1] = '\0';
+            fprintf(out, spec, arg_double(a));
+            break;
+        case 's':
+            spec[n] = conv;
+            spec[n + 1] = '\0';
+            fprintf(out, spec, a->type == 's' ? text + a->v.i : "<?>");
+            break;
+        case 'p':
+            spec[n] = conv;
+            spec[n + 1] = '\0';
+            fprintf(out, spec, (void *)(intptr_t)arg_int(a));
+            break;
+        default:
+            fwrite(spec, 1, n, out);
+            fputc(conv, out);
+            break;
+        }
+    }
+}
+
+static void emit(const log_record_t *r) {
+    FILE *out = r->site->level <= LOG_LVL_WARN ? stderr : stdout;
+
+    if (show_time) {
+        fprintf(out, "[%5llu.%06llu] ", (unsigned long long)(r->ts_ns / 1000000000ULL),
+                (unsigned long long)(r->ts_ns % 1000000000ULL / 1000));
+    }
+    if (r->suppressed) {
+        fprintf(out, "(%u similar lines suppressed)\n", r->suppressed);
+        return;
+    }
+    format(out, r->site->fmt, r->args, r->nargs, r->text);
+}
+
+// ---- ring ----
+
+// Copy the arguments into a record; strings go into its text area
+static void fill(log_record_t *r, const log_site_t *site, const log_arg_t *args, int nargs,
+                 uint64_t ts, uint32_t suppressed) {
+    int used = 0;
+
+    r->site = site;
+    r->ts_ns = ts;
+    r->suppressed = suppressed;
+    r->nargs = nargs < LOG_MAX_ARGS ? nargs : LOG_MAX_ARGS;
+
+    for (int i = 0; i < r->nargs; i++) {
+        r->args[i] = args[i];
+        if (args[i].type != 's') {
+            continue;
+        }
+        const char *s = args[i].v.s ? args[i].v.s : "(null)";
+        int len = strnlen(s, LOG_TEXT_SIZE - 1 - used);
+        memcpy(r->text + used, s, len);
+        r->text[used + len] = '\0';
+        r->args[i].v.i = used;
+        used += len + (used + len < LOG_TEXT_SIZE - 1);
+    }
+}
+
+static void kick(void) {
+    if (!__atomic_exchange_n(&kicked, 1, __ATOMIC_ACQ_REL)) {
+        char c = 0;
+        if (write(wake_pipe[1], &c, 1) < 0) {
+            // The writer polls anyway
+        }
+    }
+}
+
+static void push(const log_site_t *site, const log_arg_t *args, int nargs, uint64_t ts, uint32_t suppressed) {
+    uint64_t pos = __atomic_load_n(&head, __ATOMIC_RELAXED);
+    log_record_t *r;
+
+    // Bounded MPMC queue in the style of D. Vyukov: a slot's seq says whose
+    // turn it is, so producers only contend on the head counter
+    while (1) {
+        r = &ring[pos & (LOG_RING_SIZE - 1)];
+        uint64_t seq = __atomic_load_n(&r->seq, __ATOMIC_ACQUIRE);
+
+        if (seq == pos) {
+            if (__atomic_compare_exchange_n(&head, &pos, pos + 1, 1,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (seq < pos) {
+            // Full: wait for the writer rather than lose the line
+            kick();
+            sched_yield();
+            pos = __atomic_load_n(&head, __ATOMIC_RELAXED);
+        } else {
+            pos = __atomic_load_n(&head, __ATOMIC_RELAXED);
+        }
+    }
+
+    fill(r, site, args, nargs, ts, suppressed);
+    __atomic_store_n(&r->seq, pos + 1, __ATOMIC_RELEASE);
+
+    // Bursts get drained straight away instead of at the next poll
+    if (pos + 1 - __atomic_load_n(&tail, __ATOMIC_RELAXED) >= LOG_RING_SIZE / 2) {
+        kick();
+    }
+}
+
+static int drain(void) {
+    int n = 0;
+
+    while (1) {
+        log_record_t *r = &ring[tail & (LOG_RING_SIZE - 1)];
+        if (__atomic_load_n(&r->seq, __ATOMIC_ACQUIRE) != tail + 1) {
+            break;
+        }
+        emit(r);
+        __atomic_store_n(&r->seq, tail + LOG_RING_SIZE, __ATOMIC_RELEASE);
+        __atomic_store_n(&tail, tail + 1, __ATOMIC_RELEASE);
+        n++;
+    }
+    if (n > 0) {
+        fflush(stdout);
+        fflush(stderr);
+    }
+    return n;
+}
+
+// Take a site's count of suppressed lines once its second is over (or
+// always, at exit); 0 if there is none
+static uint32_t take_suppressed(log_site_t *site, uint64_t sec, int all) {
+    if (__atomic_load_n(&site->suppressed, __ATOMIC_RELAXED) == 0 ||
+        (!all && __atomic_load_n(&site->window, __ATOMIC_RELAXED) == sec)) {
+        return 0;
+    }
+    return __atomic_exchange_n(&site->suppressed, 0, __ATOMIC_RELAXED);
+}
+
+// Write the notes of sites that went quiet after suppressing lines; the
+// writer formats them itself, it must not wait on its own ring
+static void flush_suppressed(void) {
+    uint64_t ts = now_ns();
+
+    for (log_site_t *s = __atomic_load_n(&limited, __ATOMIC_ACQUIRE); s; s = s->next) {
+        uint32_t n = take_suppressed(s, ts / 1000000000ULL, 0);
+        if (n) {
+            log_record_t r;
+            fill(&r, s, NULL, 0, ts, n);
+            emit(&r);
+            fflush(s->level <= LOG_LVL_WARN ? stderr : stdout);
+        }
+    }
+}
+
+static void *writer_thread(void *arg) {
+    struct pollfd pfd = {wake_pipe[0], POLLIN, 0};
+    char buf[64];
+
+    rt_background();
+    (void)arg;
+    while (1) {
+        if (poll(&pfd, 1, LOG_POLL_MS) > 0) {
+            if (read(wake_pipe[0], buf, sizeof(buf)) < 0) {
+                // Nothing to do, the pipe only wakes us up
+            }
+        }
+        __atomic_store_n(&kicked, 0, __ATOMIC_RELEASE);
+        drain();
+        flush_suppressed();
+    }
+    return NULL;
+}
+
+static void record(const log_site_t *site, const log_arg_t *args, int nargs, uint64_t ts, uint32_t suppressed) {
+    if (__atomic_load_n(&started, __ATOMIC_ACQUIRE)) {
+        push(site, args, nargs, ts, suppressed);
+        return;
+    }
+
+    // Not initialized: format in the caller, like printf would
+    log_record_t r;
+    fill(&r, site, args, nargs, ts, suppressed);
+    pthread_mutex_lock(&sync_lock);
+    emit(&r);
+    fflush(site->level <= LOG_LVL_WARN ? stderr : stdout);
+    pthread_mutex_unlock(&sync_lock);
+}
+
+// ---- public ----
+
+void log_write(log_site_t *site, const log_arg_t *args, int nargs) {
+    uint64_t ts = now_ns();
+
+    if (rate_limit > 0) {
+        uint64_t sec = ts / 1000000000ULL;
+        if (__atomic_load_n(&site->window, __ATOMIC_RELAXED) != sec) {
+            __atomic_store_n(&site->window, sec, __ATOMIC_RELAXED);
+            __atomic_store_n(&site->count, 0, __ATOMIC_RELAXED);
+            uint32_t suppressed = __atomic_exchange_n(&site->suppressed, 0, __ATOMIC_RELAXED);
+            if (suppressed) {
+                record(site, NULL, 0, ts, suppressed);
+            }
+        }
+        if (__atomic_add_fetch(&site->count, 1, __ATOMIC_RELAXED) > rate_limit) {
+            __atomic_add_fetch(&site->suppressed, 1, __ATOMIC_RELAXED);
+            if (!__atomic_exchange_n(&site->listed, 1, __ATOMIC_ACQ_REL)) {
+                log_site_t *old = __atomic_load_n(&limited, __ATOMIC_ACQUIRE);
+                do {
+                    site->next = old;
+                } while (!__atomic_compare_exchange_n(&limited, &old, site, 1, __ATOMIC_RELEASE,
+                                                      __ATOMIC_ACQUIRE));
+            }
+            return;
+        }
+    }
+
+    record(site, args, nargs, ts, 0);
+}
+
+void log_flush(void) {
+    uint64_t ts = now_ns();
+
+    for (log_site_t *s = __atomic_load_n(&limited, __ATOMIC_ACQUIRE); s; s = s->next) {
+        uint32_t n = take_suppressed(s, 0, 1);
+        if (n) {
+            record(s, NULL, 0, ts, n);
+        }
+    }
+    if (!__atomic_load_n(&started, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+    uint64_t end = __atomic_load_n(&head, __ATOMIC_ACQUIRE);
+    while (__atomic_load_n(&tail, __ATOMIC_ACQUIRE) < end) {
+        kick();
+        usleep(1000);
+    }
+}
+
+void log_set_rate(uint32_t per_sec) {
+    rate_limit = per_sec;
+}
+
+void log_init(void) {
+    static const char *names[] = {"error", "warn", "info", "debug"};
+    const char *level = getenv("LOG_LEVEL");
+    const char *rate = getenv("LOG_RATE");
+    const char *time = getenv("LOG_TIME");
+    pthread_t tid;
+
+    if (started) {
+        return;
+    }
+    for (int i = 0; level && i < 4; i++) {
+        if (strcmp(level, names[i]) == 0) {
+            log_level = i;
+        }
+    }
+    if (rate != NULL) {
+        rate_limit = strtoul(rate, NULL, 0);
+    }
+    show_time = time != NULL && *time != '0';
+
+    for (uint64_t i = 0; i < LOG_RING_SIZE; i++) {
+        ring[i].seq = i;
+    }
+    if (pipe(wake_pipe) != 0) {
+        return;
+    }
+    fcntl(wake_pipe[1], F_SETFL, O_NONBLOCK);
+    if (pthread_create(&tid, NULL, writer_thread, NULL) != 0) {
+        close(wake_pipe[0]);
+        close(wake_pipe[1]);
+        return;
+    }
+    pthread_detach(tid);
+
+    __atomic_store_n(&started, 1, __ATOMIC_RELEASE);
+    atexit(log_flush);
+}
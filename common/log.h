@@ -0,0 +1,127 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include <stdint.h>
+
+// Asynchronous binary logging.
+//
+// LOG_INFO("Analog Sound Level: %d\n", v) does not format anything: it
+// stores a fixed-size record (timestamp, call site, up to LOG_MAX_ARGS
+// integer, double or string arguments) into a lock-free ring and returns.
+// A background thread formats the records with the printf format of the
+// call site and writes them out, INFO and DEBUG to stdout, WARN and ERROR
+// to stderr, so a slow console never stalls the loop that logs.
+//
+// Nothing is lost under bursts: the ring holds LOG_RING_SIZE records, and
+// when it is full the caller waits for the writer instead of dropping.
+// Lines are dropped on purpose in two places only:
+//   - level filtering: $LOG_LEVEL (error, warn, info, debug; default info)
+//     decides which levels are recorded; a filtered call is one compare.
+//   - rate limiting, off by default: with $LOG_RATE set each call site
+//     records at most that many lines per second; the rest are counted and
+//     a "(N similar lines suppressed)" line is written once the second is
+//     over (by the writer thread if the site does not log again), or at
+//     exit at the latest.
+//
+// Format strings must be literals. String arguments are copied into the
+// record, up to LOG_TEXT_SIZE bytes for all of them together. %n and
+// positional arguments are not supported; the length modifiers of integer
+// conversions are ignored since every integer is recorded as 64 bits.
+
+#define LOG_RING_SIZE 1024   // records, power of two
+#define LOG_MAX_ARGS  6
+#define LOG_TEXT_SIZE 64
+
+typedef enum {
+    LOG_LVL_ERROR = 0,
+    LOG_LVL_WARN,
+    LOG_LVL_INFO,
+    LOG_LVL_DEBUG
+} log_level_t;
+
+typedef struct {
+    char type;                // 'i' integer, 'f' double, 's' string
+    union {
+        int64_t i;
+        double f;
+        const char *s;
+    } v;
+} log_arg_t;
+
+// Per call site state, a static in each LOG_* expansion
+typedef struct log_site {
+    const char *fmt;
+    log_level_t level;
+    uint64_t window;          // second the counters below belong to
+    uint32_t count;
+    uint32_t suppressed;
+    int listed;               // on the list the writer checks for suppressed lines
+    struct log_site *next;
+} log_site_t;
+
+extern volatile int log_level;
+
+// Starts the writer thread and reads $LOG_LEVEL and $LOG_RATE. Logging
+// before log_init() formats synchronously.
+void log_init(void);
+
+// Wait until every record logged so far, and every count of suppressed
+// lines, has been written
+void log_flush(void);
+
+// Lines per second per call site, 0 for no limit; overrides $LOG_RATE
+void log_set_rate(uint32_t per_sec);
+
+// Slow path of the macros below
+void log_write(log_site_t *site, const log_arg_t *args, int nargs);
+
+static inline log_arg_t log_arg_i(int64_t v) {
+    log_arg_t a = {'i', {.i = v}};
+    return a;
+}
+
+static inline log_arg_t log_arg_f(double v) {
+    log_arg_t a = {'f', {.f = v}};
+    return a;
+}
+
+static inline log_arg_t log_arg_s(const char *v) {
+    log_arg_t a = {'s', {.s = v}};
+    return a;
+}
+
+#define LOG_ARG(x) _Generic((x), \
+        float: log_arg_f, double: log_arg_f, \
+        char *: log_arg_s, const char *: log_arg_s, \
+        default: log_arg_i)(x)
+
+#define LOG_NARGS(...) LOG_NARGS_(0, ##__VA_ARGS__, 6, 5, 4, 3, 2, 1, 0)
+#define LOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, n, ...) n
+#define LOG_CAT(a, b)  LOG_CAT_(a, b)
+#define LOG_CAT_(a, b) a##b
+
+#define LOG_MAP_0()
+#define LOG_MAP_1(a)                LOG_ARG(a)
+#define LOG_MAP_2(a, b)             LOG_ARG(a), LOG_ARG(b)
+#define LOG_MAP_3(a, b, c)          LOG_MAP_2(a, b), LOG_ARG(c)
+#define LOG_MAP_4(a, b, c, d)       LOG_MAP_3(a, b, c), LOG_ARG(d)
+#define LOG_MAP_5(a, b, c, d, e)    LOG_MAP_4(a, b, c, d), LOG_ARG(e)
+#define LOG_MAP_6(a, b, c, d, e, f) LOG_MAP_5(a, b, c, d, e), LOG_ARG(f)
+#define LOG_MAP(...) LOG_CAT(LOG_MAP_, LOG_NARGS(__VA_ARGS__))(__VA_ARGS__)
+
+// The leading dummy keeps the array non-empty for argument-less calls
+#define LOG_AT(lvl, fmt, ...) do { \
+        static log_site_t log_site_ = {fmt, lvl, 0, 0, 0, 0, NULL}; \
+        if ((int)(lvl) <= log_level) { \
+            const log_arg_t log_args_[] = {{0, {0}}, LOG_MAP(__VA_ARGS__)}; \
+            log_write(&log_site_, log_args_ + 1, \
+                      (int)(sizeof(log_args_) / sizeof(log_args_[0])) - 1); \
+        } \
+    } while (0)
+
+#define LOG_ERROR(fmt, ...) LOG_AT(LOG_LVL_ERROR, fmt, ##__VA_ARGS__)
+#define LOG_WARN(fmt, ...)  LOG_AT(LOG_LVL_WARN, fmt, ##__VA_ARGS__)
+#define LOG_INFO(fmt, ...)  LOG_AT(LOG_LVL_INFO, fmt, ##__VA_ARGS__)
+#define LOG_DEBUG(fmt, ...) LOG_AT(LOG_LVL_DEBUG, fmt, ##__VA_ARGS__)
+
+#endif
@@ -0,0 +1,187 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "metrics.h"
+#include "rt.h"
+
+#define METRICS_BUF_SIZE 65536
+
+static metric_t *registry = NULL;
+static int listen_fd = -1;
+
+void metrics_register(metric_t *m) {
+    // Constructors run single threaded, but keep the push safe anyway
+    metric_t *old = __atomic_load_n(&registry, __ATOMIC_ACQUIRE);
+    do {
+        m->next = old;
+    } while (!__atomic_compare_exchange_n(&registry, &old, m, 1, __ATOMIC_RELEASE, __ATOMIC_ACQUIRE));
+}
+
+uint64_t metrics_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// Largest value that falls into bucket 'idx' (the Prometheus "le" bound)
+static uint64_t bucket_upper(int idx) {
+    if (idx < METRIC_HIST_SUB) {
+        return idx;
+    }
+    int msb = idx / METRIC_HIST_SUB + METRIC_HIST_SUB_BITS - 1;
+    int sub = idx % METRIC_HIST_SUB;
+    int shift = msb - METRIC_HIST_SUB_BITS;
+    uint64_t lower = (uint64_t)(METRIC_HIST_SUB + sub) << shift;
+    return lower + (1ULL << shift) - 1;
+}
+
+static const char *type_name(metric_type_t t) {
+    switch (t) {
+    case METRIC_COUNTER:
+        return "counter";
+    case METRIC_GAUGE:
+        return "gauge";
+    default:
+        return "histogram";
+    }
+}
+
+int metrics_format(char *buf, int size) {
+    int len = 0;
+
+#define OUT(...) do { \
+        if (len < size) len += snprintf(buf + len, size - len, __VA_ARGS__); \
+    } while (0)
+
+    for (metric_t *m = __atomic_load_n(&registry, __ATOMIC_ACQUIRE); m; m = m->next) {
+        OUT("# HELP %s %s\n# TYPE %s %s\n", m->name, m->help, m->name, type_name(m->type));
+
+        if (m->type != METRIC_HISTOGRAM) {
+            OUT("%s %lld\n", m->name, (long long)__atomic_load_n(&m->value, __ATOMIC_RELAXED));
+            continue;
+        }
+
+        // Cumulative buckets, printed only where the count changes
+        uint64_t count = __atomic_load_n(&m->count, __ATOMIC_RELAXED);
+        uint64_t cumulative = 0;
+        for (int i = 0; i < METRIC_HIST_BUCKETS && cumulative < count; i++) {
+            uint64_t n = __atomic_load_n(&m->buckets[i], __ATOMIC_RELAXED);
+            if (n == 0) {
+                continue;
+            }
+            cumulative += n;
+            OUT("%s_bucket{le=\"%llu\"} %llu\n", m->name,
+                (unsigned long long)bucket_upper(i), (unsigned long long)cumulative);
+        }
+        OUT("%s_bucket{le=\"+Inf\"} %llu\n", m->name, (unsigned long long)count);
+        OUT("%s_sum %llu\n%s_count %llu\n", m->name,
+            (unsigned long long)__atomic_load_n(&m->sum, __ATOMIC_RELAXED),
+            m->name, (unsigned long long)count);
+    }
+
+#undef OUT
+    return len < size ? len : size - 1;
+}
+
+static void write_all(int fd, const char *p, int len) {
+    while (len > 0) {
+        ssize_t n = write(fd, p, len);
+        if (n <= 0) {
+            return;
+        }
+        p += n;
+        len -= n;
+    }
+}
+
+static void serve_client(int fd, char *body) {
+    char req[256];
+    struct pollfd pfd = {fd, POLLIN, 0};
+    int http = 0;
+
+    // HTTP clients send a request line first; bare readers send nothing
+    if (poll(&pfd, 1, 100) > 0) {
+        ssize_t n = read(fd, req, sizeof(req) - 1);
+        http = (n >= 4 && strncmp(req, "GET ", 4) == 0);
+    }
+
+    int len = metrics_format(body, METRICS_BUF_SIZE);
+    if (http) {
+        char hdr[128];
+        int hlen = snprintf(hdr, sizeof(hdr),
+                            "HTTP/1.0 200 OK\r\nContent-Type: text/plain; version=0.0.4\r\n"
+                            "Content-Length: %d\r\n\r\n", len);
+        write_all(fd, hdr, hlen);
+    }
+    write_all(fd, body, len);
+}
+
+static void *server_thread(void *arg) {
+    char *body = arg;
+
+    rt_background();
+    while (1) {
+        int fd = accept(listen_fd, NULL, NULL);
+        if (fd < 0) {
+            if (errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        serve_client(fd, body);
+        close(fd);
+    }
+    free(body);
+    return NULL;
+}
+
+int metrics_serve(const char *path) {
+    extern char *program_invocation_short_name;
+    struct sockaddr_un addr;
+    char def[sizeof(addr.sun_path)];
+    pthread_t tid;
+
+    if (path == NULL) {
+        path = getenv("METRICS_SOCKET");
+    }
+    if (path == NULL) {
+        snprintf(def, sizeof(def), "/tmp/%s.metrics.sock", program_invocation_short_name);
+        path = def;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", path);
+
+    listen_fd = socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+    if (listen_fd < 0) {
+        return -1;
+    }
+    unlink(path);
+    if (bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 || listen(listen_fd, 4) != 0) {
+        fprintf(stderr, "metrics: cannot listen on %s: %s\n", path, strerror(errno));
+        close(listen_fd);
+        listen_fd = -1;
+        return -1;
+    }
+
+    // The formatting buffer is allocated once, never on the update path
+    char *body = malloc(METRICS_BUF_SIZE);
+    if (body == NULL || pthread_create(&tid, NULL, server_thread, body) != 0) {
+        free(body);
+        close(listen_fd);
+        listen_fd = -1;
+        return -1;
+    }
+    pthread_detach(tid);
+
+    printf("Metrics served on %s\n", path);
+    return 0;
+}
@@ -0,0 +1,84 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <stdint.h>
+
+// Metrics registry with a Prometheus text exporter on a Unix socket.
+//
+// Metrics are plain globals defined with METRIC_DEFINE(); a constructor
+// links them into the registry before main() runs, so updating one is a
+// single relaxed atomic operation and never takes a lock or allocates.
+// metrics_serve() starts a thread that answers every connection on the
+// socket with the current values, either as an HTTP response (when the
+// client sends "GET ...", e.g. curl --unix-socket) or as bare text
+// (e.g. socat - UNIX-CONNECT:<path>).
+//
+// Histograms are log-linear in the style of HDR histograms: each power of
+// two is split into METRIC_HIST_SUB buckets, giving about 25% resolution
+// from 1 ns up to many seconds with a fixed 256-entry array.
+
+#define METRIC_HIST_SUB_BITS 2
+#define METRIC_HIST_SUB      (1 << METRIC_HIST_SUB_BITS)
+#define METRIC_HIST_BUCKETS  (64 * METRIC_HIST_SUB)
+
+typedef enum {
+    METRIC_COUNTER = 0,
+    METRIC_GAUGE,
+    METRIC_HISTOGRAM
+} metric_type_t;
+
+typedef struct metric {
+    const char *name;
+    const char *help;
+    metric_type_t type;
+    int64_t value;                      // counter total or gauge level
+    uint64_t count, sum;                // histogram observations
+    uint64_t buckets[METRIC_HIST_BUCKETS];
+    struct metric *next;
+} metric_t;
+
+#define METRIC_DEFINE(var, type, name, help) \
+    metric_t var = {name, help, type, 0, 0, 0, {0}, 0}; \
+    static void __attribute__((constructor)) var##_register(void) { metrics_register(&var); }
+
+void metrics_register(metric_t *m);
+
+static inline void metric_add(metric_t *m, int64_t n) {
+    __atomic_fetch_add(&m->value, n, __ATOMIC_RELAXED);
+}
+
+static inline void metric_inc(metric_t *m) {
+    metric_add(m, 1);
+}
+
+static inline void metric_set(metric_t *m, int64_t v) {
+    __atomic_store_n(&m->value, v, __ATOMIC_RELAXED);
+}
+
+static inline int metric_bucket(uint64_t v) {
+    if (v < METRIC_HIST_SUB) {
+        return (int)v;
+    }
+    int msb = 63 - __builtin_clzll(v);
+    int sub = (int)(v >> (msb - METRIC_HIST_SUB_BITS)) & (METRIC_HIST_SUB - 1);
+    return (msb - METRIC_HIST_SUB_BITS + 1) * METRIC_HIST_SUB + sub;
+}
+
+static inline void metric_observe(metric_t *m, uint64_t v) {
+    __atomic_fetch_add(&m->buckets[metric_bucket(v)], 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&m->sum, v, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&m->count, 1, __ATOMIC_RELAXED);
+}
+
+// Monotonic nanoseconds, for timing histogram observations
+uint64_t metrics_now_ns(void);
+
+// Write every registered metric in Prometheus text format into buf.
+// Returns the length written (truncated to size - 1).
+int metrics_format(char *buf, int size);
+
+// Serve on the given socket path; NULL means $METRICS_SOCKET or
+// /tmp/<program>.metrics.sock. Returns 0 once the thread is running.
+int metrics_serve(const char *path);
+
+#endif
@@ -0,0 +1,334 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <unistd.h>
+#include <limits.h>
+#include "pinmap.h"
+
+static pinmap_entry_t entries[PINMAP_MAX_ENTRIES];
+static int num_entries = 0;
+
+// Return 1 if 'name' appears in the comma separated 'list'
+static int section_wanted(const char *list, const char *name) {
+    size_t len = strlen(name);
+    const char *p = list;
+
+    while (*p) {
+        const char *end = strchr(p, ',');
+        size_t n = end ? (size_t)(end - p) : strlen(p);
+        if (n == len && strncmp(p, name, len) == 0) {
+            return 1;
+        }
+        if (!end) {
+            break;
+        }
+        p = end + 1;
+    }
+    return 0;
+}
+
+static int parse_dir(const char *s, pinmap_entry_t *e) {
+    if (strcmp(s, "out") == 0) {
+        e->dir = MRAA_GPIO_OUT;
+    } else if (strcmp(s, "in") == 0) {
+        e->dir = MRAA_GPIO_IN;
+    } else if (strcmp(s, "pwm") == 0) {
+        e->dir = MRAA_GPIO_OUT;
+        e->pwm = 1;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+// Optional trailing words: a pull mode and/or an initial output level
+static int parse_option(const char *s, pinmap_entry_t *e) {
+    if (strcmp(s, "pullup") == 0) {
+        e->mode = MRAA_GPIO_PULLUP;
+    } else if (strcmp(s, "pulldown") == 0) {
+        e->mode = MRAA_GPIO_PULLDOWN;
+    } else if (strcmp(s, "strong") == 0) {
+        e->mode = MRAA_GPIO_STRONG;
+    } else if (strcmp(s, "hiz") == 0) {
+        e->mode = MRAA_GPIO_HIZ;
+    } else if (strcmp(s, "high") == 0) {
+        e->level = 1;
+    } else if (strcmp(s, "low") == 0) {
+        e->level = 0;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+// Reject a pin or a name that is already taken by another loaded entry
+static int check_conflict(const pinmap_entry_t *e, const char *path, int line) {
+    for (int i = 0; i < num_entries; i++) {
+        if (entries[i].pin == e->pin) {
+            fprintf(stderr, "%s:%d: pin %d for '%s' [%s] already used by '%s' [%s]\n",
+                    path, line, e->pin, e->name, e->section,
+                    entries[i].name, entries[i].section);
+            return -1;
+        }
+        if (strcmp(entries[i].name, e->name) == 0) {
+            fprintf(stderr, "%s:%d: '%s' defined twice ([%s] and [%s])\n",
+                    path, line, e->name, entries[i].section, e->section);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// PINMAP_DEFAULT_FILE in the current directory, next to the executable or
+// in one of the directories above it, then PINMAP_INSTALL_FILE. Falls back
+// to PINMAP_DEFAULT_FILE so that the error names the file expected.
+static const char *find_default(char *buf, size_t size) {
+    char exe[PATH_MAX - sizeof(PINMAP_DEFAULT_FILE) - 1];   // room for "/pins.conf"
+    ssize_t len;
+
+    if (access(PINMAP_DEFAULT_FILE, R_OK) == 0) {
+        return PINMAP_DEFAULT_FILE;
+    }
+
+    len = readlink("/proc/self/exe", exe, sizeof(exe) - 1);
+    if (len > 0) {
+        exe[len] = '\0';
+        for (int level = 0; level <= PINMAP_EXE_LEVELS; level++) {
+            char *slash = strrchr(exe, '/');
+            if (slash == NULL) {
+                break;
+            }
+            *slash = '\0';
+            snprintf(buf, size, "%s/%s", exe, PINMAP_DEFAULT_FILE);
+            if (access(buf, R_OK) == 0) {
+                return buf;
+            }
+        }
+    }
+
+    if (access(PINMAP_INSTALL_FILE, R_OK) == 0) {
+        return PINMAP_INSTALL_FILE;
+    }
+    return PINMAP_DEFAULT_FILE;
+}
+
+int pinmap_load(const char *path, const char *sections) {
+    char found[PATH_MAX];
+    char line[128];
+    char section[PINMAP_NAME_LEN] = "";
+    int lineno = 0;
+    int errors = 0;
+
+    if (path == NULL) {
+        path = getenv("PINMAP_FILE");
+    }
+    if (path == NULL) {
+        path = find_default(found, sizeof(found));
+    }
+
+    FILE *fp = fopen(path, "r");
+    if (fp == NULL) {
+        fprintf(stderr, "Failed to open pin map %s\n", path);
+        return -1;
+    }
+
+    num_entries = 0;
+
+    while (fgets(line, sizeof(line), fp) != NULL) {
+        char *p = line;
+        lineno++;
+
+        // Strip comments and leading blanks
+        char *hash = strchr(p, '#');
+        if (hash) {
+            *hash = '\0';
+        }
+        while (isspace((unsigned char)*p)) {
+            p++;
+        }
+        if (*p == '\0') {
+            continue;
+        }
+
+        if (*p == '[') {
+            char *end = strchr(p, ']');
+            if (end == NULL || end - p - 1 >= PINMAP_NAME_LEN) {
+                fprintf(stderr, "%s:%d: bad section header\n", path, lineno);
+                errors++;
+                section[0] = '\0';
+                continue;
+            }
+            *end = '\0';
+            strcpy(section, p + 1);
+            continue;
+        }
+
+        if (!section_wanted(sections, section)) {
+            continue;
+        }
+
+        char name[PINMAP_NAME_LEN], dir[8], opt1[16], opt2[16];
+        int pin;
+        int n = sscanf(p, "%23s %d %7s %15s %15s", name, &pin, dir, opt1, opt2);
+        if (n < 3) {
+            fprintf(stderr, "%s:%d: expected 'name pin dir'\n", path, lineno);
+            errors++;
+            continue;
+        }
+
+        if (num_entries == PINMAP_MAX_ENTRIES) {
+            fprintf(stderr, "%s:%d: too many pins (max %d)\n", path, lineno, PINMAP_MAX_ENTRIES);
+            errors++;
+            break;
+        }
+
+        pinmap_entry_t *e = &entries[num_entries];
+        memset(e, 0, sizeof(*e));
+        strcpy(e->name, name);
+        strcpy(e->section, section);
+        e->pin = pin;
+        e->mode = -1;
+        e->level = -1;
+        e->line = -1;
+
+        if (parse_dir(dir, e) != 0 ||
+            (n >= 4 && parse_option(opt1, e) != 0) ||
+            (n >= 5 && parse_option(opt2, e) != 0)) {
+            fprintf(stderr, "%s:%d: bad direction or option for '%s'\n", path, lineno, name);
+            errors++;
+            continue;
+        }
+
+        if (check_conflict(e, path, lineno) != 0) {
+            errors++;
+            continue;
+        }
+
+        num_entries++;
+    }
+
+    fclose(fp);
+
+    // Every requested section must exist, otherwise a typo silently
+    // leaves pins unmapped
+    const char *p = sections;
+    while (*p) {
+        const char *end = strchr(p, ',');
+        size_t n = end ? (size_t)(end - p) : strlen(p);
+        int found = 0;
+        for (int i = 0; i < num_entries; i++) {
+            if (strlen(entries[i].section) == n && strncmp(entries[i].section, p, n) == 0) {
+                found = 1;
+                break;
+            }
+        }
+        if (!found) {
+            fprintf(stderr, "%s: section [%.*s] missing or empty\n", path, (int)n, p);
+            errors++;
+        }
+        if (!end) {
+            break;
+        }
+        p = end + 1;
+    }
+
+    return errors ? -1 : 0;
+}
+
+int pinmap_open_all(void) {
+    for (int i = 0; i < num_entries; i++) {
+        pinmap_entry_t *e = &entries[i];
+        if (e->pwm) {
+            continue;   // opened by the PWM code
+        }
+        e->line = gpio_pool_add(e->pin, e->dir, e->mode, e->level);
+        if (e->line < 0) {
+            return -1;
+        }
+    }
+
+    // All lines are requested together rather than pin by pin
+    if (gpio_pool_open() != 0) {
+        fprintf(stderr, "Failed to open GPIO lines\n");
+        for (int i = 0; i < num_entries; i++) {
+            entries[i].line = -1;
+        }
+        return -1;
+    }
+    return 0;
+}
+
+int pinmap_setup(const char *sections) {
+    if (pinmap_load(NULL, sections) != 0 || pinmap_open_all() != 0) {
+        return -1;
+    }
+    gpio_pool_report(stdout);
+    return 0;
+}
+
+void pinmap_close_all(void) {
+    gpio_pool_close();
+    for (int i = 0; i < num_entries; i++) {
+        entries[i].line = -1;
+    }
+}
+
+const pinmap_entry_t *pinmap_find(const char *name) {
+    for (int i = 0; i < num_entries; i++) {
+        if (strcmp(entries[i].name, name) == 0) {
+            return &entries[i];
+        }
+    }
+    return NULL;
+}
+
+int pinmap_line(const char *name) {
+    const pinmap_entry_t *e = pinmap_find(name);
+    if (e == NULL) {
+        fprintf(stderr, "Pin '%s' is not in the pin map\n", name);
+        return -1;
+    }
+    return e->line;
+}
+
+int pinmap_pin(const char *name) {
+    const pinmap_entry_t *e = pinmap_find(name);
+    return e ? e->pin : -1;
+}
+
+int pinmap_line_array(const char *prefix, int first, int *out, int count) {
+    char name[PINMAP_NAME_LEN];
+    int missing = 0;
+
+    for (int i = 0; i < count; i++) {
+        snprintf(name, sizeof(name), "%s%d", prefix, first + i);
+        out[i] = pinmap_line(name);
+        if (out[i] < 0) {
+            missing++;
+        }
+    }
+    return missing ? -1 : 0;
+}
+
+int pinmap_pin_array(const char *prefix, int *out, int max) {
+    char name[PINMAP_NAME_LEN];
+    int n = 0;
+
+    while (n < max) {
+        snprintf(name, sizeof(name), "%s%d", prefix, n);
+        if ((out[n] = pinmap_pin(name)) < 0) {
+            break;
+        }
+        n++;
+    }
+    return n;
+}
+
+int pinmap_count(void) {
+    return num_entries;
+}
+
+const pinmap_entry_t *pinmap_entry(int index) {
+    return (index >= 0 && index < num_entries) ? &entries[index] : NULL;
+}
@@ -0,0 +1,76 @@
+#ifndef PINMAP_H
+#define PINMAP_H
+
+#include <mraa/gpio.h>
+#include "gpio_pool.h"
+
+// Runtime pin map for the RuggedBoard exercises.
+//
+// The wiring of every exercise lives in a text file (pins.conf by default,
+// or the file named by $PINMAP_FILE) instead of #defines in each program.
+// pins.conf is looked for in the current directory, then next to the
+// executable and in the directories above it (so build/<profile>/<dir>/<prog>
+// finds the one at the top of the tree), then at PINMAP_INSTALL_FILE.
+// The file is split into [sections], one per group of wiring:
+//
+//     [lcd4]
+//     # name     pin  dir  [pullup|pulldown|strong|hiz]  [high|low]
+//     lcd.rs     12   out
+//     lcd.en     13   out  strong  low
+//
+// dir is in, out, or pwm: a PWM channel is listed for its pin number
+// (pinmap_pin_array()) and left alone by pinmap_open_all().
+//
+// A program loads the sections it needs ("lcd4,led"), the loader checks
+// that no pin is claimed twice across them, and every line is opened and
+// configured in one batch through the GPIO pool before the main loop starts.
+// Programs then drive the pins with gpio_pool_write()/gpio_pool_read() on
+// the line numbers returned by pinmap_line().
+
+#define PINMAP_DEFAULT_FILE "pins.conf"
+#define PINMAP_INSTALL_FILE "/etc/ruggedboard/pins.conf"
+#define PINMAP_EXE_LEVELS   4    // directories above the executable searched
+#define PINMAP_MAX_ENTRIES  64
+#define PINMAP_NAME_LEN     24
+
+typedef struct {
+    char name[PINMAP_NAME_LEN];
+    char section[PINMAP_NAME_LEN];
+    int pin;
+    mraa_gpio_dir_t dir;
+    int mode;   // mraa_gpio_mode_t, or -1 to leave the pin default
+    int level;  // initial output level, or -1 to leave it untouched
+    int line;   // GPIO pool line once opened, -1 before
+    int pwm;    // a PWM channel, not a GPIO
+} pinmap_entry_t;
+
+// Parse the sections named in the comma separated list from the given file
+// (NULL means $PINMAP_FILE or the search above). Returns 0 on success,
+// -1 on a parse error or a pin conflict.
+int pinmap_load(const char *path, const char *sections);
+
+// Open and configure every loaded pin. Returns 0 on success, -1 otherwise.
+int pinmap_open_all(void);
+
+// pinmap_load() followed by pinmap_open_all(), reporting the startup time.
+int pinmap_setup(const char *sections);
+
+void pinmap_close_all(void);
+
+// Lookups by logical name, meant to be done once at startup.
+const pinmap_entry_t *pinmap_find(const char *name);
+int pinmap_line(const char *name);
+int pinmap_pin(const char *name);
+
+// Fill out[] with the lines of "<prefix><first>" .. "<prefix><first + count - 1>",
+// e.g. pinmap_line_array("lcd.d", 4, d, 4) for D4-D7. Returns 0 if all were found.
+int pinmap_line_array(const char *prefix, int first, int *out, int count);
+
+// Pin numbers of "<prefix>0", "<prefix>1", ... up to 'max' of them, e.g. the
+// PWM channels of a section. Returns how many there are.
+int pinmap_pin_array(const char *prefix, int *out, int max);
+
+int pinmap_count(void);
+const pinmap_entry_t *pinmap_entry(int index);
+
+#endif
@@ -0,0 +1,215 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "timing.h"
+#include "pwm_bank.h"
+
+// One attribute of a sysfs channel (or chip), written once at setup
+static int sysfs_write(const char *dir, const char *name, unsigned long value) {
+    char path[128], text[24];
+    int len = snprintf(text, sizeof(text), "%lu", value);
+
+    snprintf(path, sizeof(path), "%s/%s", dir, name);
+    int fd = open(path, O_WRONLY | O_CLOEXEC);
+    if (fd < 0) {
+        return -1;
+    }
+    int ret = write(fd, text, len) == len ? 0 : -1;
+    close(fd);
+    return ret;
+}
+
+// Decimal text without printf: this runs for every staged duty
+static int format_ns(char *out, uint32_t v) {
+    char tmp[10];
+    int n = 0, len = 0;
+
+    do {
+        tmp[n++] = '0' + v % 10;
+        v /= 10;
+    } while (v > 0);
+    while (n > 0) {
+        out[len++] = tmp[--n];
+    }
+    return len;
+}
+
+static int sysfs_open_channel(pwm_bank_t *b, pwm_channel_t *c, const char *root, int chip, int channel) {
+    char chip_dir[80];
+
+    snprintf(chip_dir, sizeof(chip_dir), "%s/pwmchip%d", root, chip);
+    snprintf(c->dir, sizeof(c->dir), "%s/pwm%d", chip_dir, channel);
+    if (access(c->dir, F_OK) != 0 && sysfs_write(chip_dir, "export", channel) != 0) {
+        fprintf(stderr, "PWM bank: cannot export %s\n", c->dir);
+        return -1;
+    }
+
+    // Duty first: the kernel refuses a period shorter than the current duty
+    if (sysfs_write(c->dir, "duty_cycle", 0) != 0 || sysfs_write(c->dir, "period", b->period_ns) != 0 ||
+        sysfs_write(c->dir, "enable", 1) != 0) {
+        fprintf(stderr, "PWM bank: cannot set up %s: %s\n", c->dir, strerror(errno));
+        return -1;
+    }
+
+    char path[128];
+    snprintf(path, sizeof(path), "%s/duty_cycle", c->dir);
+    c->fd = open(path, O_WRONLY | O_CLOEXEC);
+    if (c->fd < 0) {
+        fprintf(stderr, "PWM bank: cannot open %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    return 0;
+}
+
+static int mraa_open_channel(pwm_bank_t *b, pwm_channel_t *c) {
+    c->pwm = mraa_pwm_init(c->pin);
+    if (c->pwm == NULL) {
+        fprintf(stderr, "PWM bank: cannot open PWM on pin %d\n", c->pin);
+        return -1;
+    }
+    if (mraa_pwm_period_us(c->pwm, b->period_ns / TIMING_US) != MRAA_SUCCESS ||
+        mraa_pwm_write(c->pwm, 0.0f) != MRAA_SUCCESS || mraa_pwm_enable(c->pwm, 1) != MRAA_SUCCESS) {
+        fprintf(stderr, "PWM bank: cannot set up PWM on pin %d\n", c->pin);
+        return -1;
+    }
+    return 0;
+}
+
+int pwm_bank_open(pwm_bank_t *b, const int *pins, int count, uint32_t period_ns) {
+    const char *list = getenv("PWM_SYSFS");
+    const char *root = getenv("PWM_SYSFS_ROOT");
+
+    if (count < 1 || count > PWM_BANK_MAX_CHANNELS || period_ns < TIMING_US) {
+        fprintf(stderr, "PWM bank: %d channels, %u ns period out of range\n", count, period_ns);
+        return -1;
+    }
+
+    memset(b, 0, sizeof(*b));
+    b->period_ns = period_ns;
+    b->backend = (list != NULL && *list != '\0') ? PWM_BANK_SYSFS : PWM_BANK_MRAA;
+    for (int i = 0; i < count; i++) {
+        b->ch[i].pin = pins[i];
+        b->ch[i].fd = -1;
+    }
+
+    for (int i = 0; i < count; i++, b->count++) {
+        pwm_channel_t *c = &b->ch[i];
+        int ret;
+
+        if (b->backend == PWM_BANK_SYSFS) {
+            char *end;
+            int chip = strtol(list, &end, 10);
+            int channel = *end == ':' ? strtol(end + 1, &end, 10) : -1;
+            if (channel < 0 || (*end != ',' && *end != '\0') || (*end == '\0' && i < count - 1)) {
+                fprintf(stderr, "PWM bank: PWM_SYSFS needs %d chip:channel entries\n", count);
+                pwm_bank_close(b);
+                return -1;
+            }
+            list = end + (*end == ',');
+            ret = sysfs_open_channel(b, c, root ? root : PWM_BANK_SYSFS_ROOT, chip, channel);
+        } else {
+            ret = mraa_open_channel(b, c);
+        }
+        if (ret != 0) {
+            b->count++;     // close what was half set up too
+            pwm_bank_close(b);
+            return -1;
+        }
+        c->text_len = format_ns(c->text, 0);
+    }
+    return 0;
+}
+
+void pwm_bank_close(pwm_bank_t *b) {
+    for (int i = 0; i < b->count; i++) {
+        pwm_channel_t *c = &b->ch[i];
+        if (c->fd >= 0) {
+            pwrite(c->fd, "0", 1, 0);
+            close(c->fd);
+            sysfs_write(c->dir, "enable", 0);
+            c->fd = -1;
+        }
+        if (c->pwm != NULL) {
+            mraa_pwm_write(c->pwm, 0.0f);
+            mraa_pwm_enable(c->pwm, 0);
+            mraa_pwm_close(c->pwm);
+            c->pwm = NULL;
+        }
+    }
+    b->count = 0;
+}
+
+uint32_t pwm_bank_fraction_ns(const pwm_bank_t *b, uint32_t num, uint32_t den) {
+    return den ? (uint32_t)((uint64_t)b->period_ns * num / den) : 0;
+}
+
+void pwm_bank_stage(pwm_bank_t *b, int channel, uint32_t duty_ns) {
+    if (channel < 0 || channel >= b->count) {
+        return;
+    }
+
+    pwm_channel_t *c = &b->ch[channel];
+    if (duty_ns > b->period_ns) {
+        duty_ns = b->period_ns;
+    }
+    if (duty_ns == c->duty_ns) {
+        return;     // nothing to write
+    }
+    c->duty_ns = duty_ns;
+    c->dirty = 1;
+    if (b->backend == PWM_BANK_SYSFS) {
+        c->text_len = format_ns(c->text, duty_ns);
+    } else {
+        c->duty = (float)duty_ns / b->period_ns;
+    }
+}
+
+int pwm_bank_commit(pwm_bank_t *b) {
+    uint64_t first = 0;
+    int written = 0, ret = 0;
+
+    for (int i = 0; i < b->count; i++) {
+        pwm_channel_t *c = &b->ch[i];
+        if (!c->dirty) {
+            continue;
+        }
+        if (written == 0) {
+            first = timing_now_ns();
+        }
+        int ok = b->backend == PWM_BANK_SYSFS ? pwrite(c->fd, c->text, c->text_len, 0) == c->text_len
+                                              : mraa_pwm_write(c->pwm, c->duty) == MRAA_SUCCESS;
+        if (ok) {
+            c->dirty = 0;
+        } else {
+            ret = -1;   // left dirty: written again by the next commit
+        }
+        written++;
+    }
+    if (written == 0) {
+        return 0;
+    }
+
+    b->last_skew_ns = timing_now_ns() - first;
+    if (b->last_skew_ns > b->max_skew_ns) {
+        b->max_skew_ns = b->last_skew_ns;
+    }
+    b->commits++;
+    b->writes += written;
+    return ret < 0 ? -1 : written;
+}
+
+int pwm_bank_update(pwm_bank_t *b, const uint32_t *duty_ns) {
+    for (int i = 0; i < b->count; i++) {
+        pwm_bank_stage(b, i, duty_ns[i]);
+    }
+    return pwm_bank_commit(b);
+}
+
+void pwm_bank_report(const pwm_bank_t *b, FILE *out) {
+    fprintf(out, "PWM bank: %d channels via %s, %u ns period, %lu commits (%lu writes), skew max %.1f us\n",
+            b->count, b->backend == PWM_BANK_SYSFS ? "sysfs" : "mraa", b->period_ns, b->commits, b->writes,
+            b->max_skew_ns / 1e3);
+}
@@ -0,0 +1,84 @@
+#ifndef PWM_BANK_H
+#define PWM_BANK_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <mraa/pwm.h>
+
+// Several hardware PWM channels driven as one, for RGB and multi-LED
+// fixtures.
+//
+// The channels are opened once, with one period, and stay open until
+// pwm_bank_close(). Duties are integer nanoseconds of high time. Staging a
+// duty does no I/O: it converts the value once into what the backend
+// writes. pwm_bank_commit() then writes every changed channel back to back,
+// so the channels change within a few microseconds of each other rather
+// than a printf or an ADC read apart. The time from the first write to the
+// last is the skew, kept in last_skew_ns/max_skew_ns.
+//
+// Backends:
+//   - sysfs: the duty_cycle file of each channel is kept open and the
+//     staged decimal text is written with one pwrite(). Used when
+//     PWM_SYSFS lists the channels as chip:channel, e.g. "0:0,0:1,0:2" for
+//     pwmchip0/pwm0-2 ($PWM_SYSFS_ROOT, default /sys/class/pwm).
+//   - mraa: mraa_pwm_write() with the duty precomputed as a fraction of
+//     the period. Used otherwise, with the mraa pin numbers.
+// Either way each channel latches its new duty at its next period
+// boundary; the PWM units have no shared update strobe through these
+// interfaces.
+
+#define PWM_BANK_MAX_CHANNELS 8
+#define PWM_BANK_SYSFS_ROOT   "/sys/class/pwm"
+
+typedef enum {
+    PWM_BANK_SYSFS = 0,
+    PWM_BANK_MRAA
+} pwm_bank_backend_t;
+
+typedef struct {
+    int pin;
+    uint32_t duty_ns;          // last staged
+    int dirty;
+    int fd;                    // sysfs: duty_cycle, kept open
+    char dir[96];              // sysfs: .../pwmchipN/pwmM
+    char text[12];             // sysfs: duty_ns in decimal
+    int text_len;
+    mraa_pwm_context pwm;      // mraa
+    float duty;                // mraa: duty_ns / period_ns
+} pwm_channel_t;
+
+typedef struct {
+    pwm_channel_t ch[PWM_BANK_MAX_CHANNELS];
+    int count;
+    uint32_t period_ns;
+    pwm_bank_backend_t backend;
+    unsigned long commits, writes;
+    uint64_t last_skew_ns, max_skew_ns;
+} pwm_bank_t;
+
+// Open 'count' channels on the given pins with 'period_ns', all at duty 0
+// and enabled. -1 if any of them cannot be set up.
+int pwm_bank_open(pwm_bank_t *b, const int *pins, int count, uint32_t period_ns);
+
+// Duty 0, outputs disabled, handles closed
+void pwm_bank_close(pwm_bank_t *b);
+
+// num/den of the period in ns, for precomputing tables
+uint32_t pwm_bank_fraction_ns(const pwm_bank_t *b, uint32_t num, uint32_t den);
+
+// Stage one channel's duty (clamped to the period); no I/O
+void pwm_bank_stage(pwm_bank_t *b, int channel, uint32_t duty_ns);
+
+// Write every channel staged with a new duty, back to back. Returns the
+// number written, -1 if a write failed; a channel whose write failed stays
+// staged and is tried again by the next commit.
+int pwm_bank_commit(pwm_bank_t *b);
+
+// Stage duty_ns[0 .. count-1] and commit them
+int pwm_bank_update(pwm_bank_t *b, const uint32_t *duty_ns);
+
+// "PWM bank: 3 channels via sysfs, 20000000 ns period, 1200 commits (3600 writes),
+//  skew max 4.1 us"
+void pwm_bank_report(const pwm_bank_t *b, FILE *out);
+
+#endif
@@ -0,0 +1,109 @@
+#include <math.h>
+#include <string.h>
+#include "pwm_dither.h"
+
+#define GAMMA_ONE (1u << 24)
+
+// x^2.2 at evenly spaced points
+static void build_gamma(uint32_t *table) {
+    for (int i = 0; i < PWM_DITHER_GAMMA_POINTS; i++) {
+        double x = (double)i / (PWM_DITHER_GAMMA_POINTS - 1);
+        table[i] = (uint32_t)(pow(x, 2.2) * GAMMA_ONE + 0.5);
+    }
+}
+
+int pwm_dither_max_frac_bits(uint32_t period_ns) {
+    // One tick per period: the slowest pattern runs at period_hz / 2^bits
+    double bits = floor(log2((double)TIMING_S / period_ns / PWM_DITHER_MIN_HZ));
+
+    return bits < 0 ? 0 : bits > PWM_DITHER_MAX_FRAC_BITS ? PWM_DITHER_MAX_FRAC_BITS : (int)bits;
+}
+
+int pwm_dither_init(pwm_dither_t *d, pwm_bank_t *bank, uint32_t step_ns, int frac_bits) {
+    uint32_t steps = step_ns ? bank->period_ns / step_ns : 0;
+    int cap = pwm_dither_max_frac_bits(bank->period_ns);
+
+    if (frac_bits > cap) {
+        frac_bits = cap;
+    }
+    if (steps < 2 || frac_bits < 0 || ((uint64_t)steps << frac_bits) >= (1u << 31)) {
+        fprintf(stderr, "PWM dither: %u ns steps and %d bits do not fit a %u ns period\n",
+                step_ns, frac_bits, bank->period_ns);
+        return -1;
+    }
+
+    memset(d, 0, sizeof(*d));
+    d->bank = bank;
+    d->step_ns = step_ns;
+    d->frac_bits = frac_bits;
+    d->full = steps << frac_bits;
+    build_gamma(d->gamma);
+    return 0;
+}
+
+double pwm_dither_bits(const pwm_dither_t *d) {
+    return log2(d->full >> d->frac_bits) + d->frac_bits;
+}
+
+void pwm_dither_set(pwm_dither_t *d, int channel, uint32_t fine) {
+    if (channel < 0 || channel >= d->bank->count) {
+        return;
+    }
+    __atomic_store_n(&d->target[channel], fine < d->full ? fine : d->full, __ATOMIC_RELAXED);
+}
+
+void pwm_dither_brightness(pwm_dither_t *d, int channel, uint16_t level) {
+    int i = level >> 8, rem = level & 0xff;
+    uint32_t g = d->gamma[i] + (uint32_t)(((uint64_t)(d->gamma[i + 1] - d->gamma[i]) * rem) >> 8);
+    uint32_t fine = (uint32_t)(((uint64_t)g * d->full + GAMMA_ONE / 2) >> 24);
+
+    pwm_dither_set(d, channel, level > 0 && fine == 0 ? 1 : fine);
+}
+
+int pwm_dither_tick(pwm_dither_t *d) {
+    uint32_t one = 1u << d->frac_bits;
+
+    for (int ch = 0; ch < d->bank->count; ch++) {
+        uint32_t fine = __atomic_load_n(&d->target[ch], __ATOMIC_RELAXED);
+        uint32_t step = fine >> d->frac_bits;
+
+        d->acc[ch] += fine & (one - 1);
+        if (d->acc[ch] >= one) {
+            d->acc[ch] -= one;
+            step++;
+        }
+        pwm_bank_stage(d->bank, ch, step * d->step_ns);   // no-op if unchanged
+    }
+    d->ticks++;
+    return pwm_bank_commit(d->bank);
+}
+
+static void step(void *arg) {
+    pwm_dither_t *d = arg;
+
+    pwm_dither_tick(d);
+    timing_period_wait(&d->tick);
+}
+
+int pwm_dither_start(pwm_dither_t *d) {
+    timing_period_init(&d->tick, d->bank->period_ns);
+    return worker_start(&d->worker, "PWM dither", step, d);
+}
+
+void pwm_dither_stop(pwm_dither_t *d) {
+    worker_stop(&d->worker);
+}
+
+void pwm_dither_report(const pwm_dither_t *d, FILE *out) {
+    double bits = pwm_dither_bits(d);
+
+    fprintf(out, "PWM dither: %.1f bits (%.1f + %d)", bits, bits - d->frac_bits, d->frac_bits);
+    const worker_t *w = &d->worker;
+
+    if (w->run_ns > 0) {
+        fprintf(out, ", %.0f ticks/s, %.0f writes/s, CPU %.1f%%, %llu ticks missed",
+                d->ticks * (double)TIMING_S / w->run_ns, d->bank->writes * (double)TIMING_S / w->run_ns,
+                100.0 * w->cpu_ns / w->run_ns, (unsigned long long)d->tick.missed);
+    }
+    fprintf(out, "\n");
+}
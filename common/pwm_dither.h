@@ -0,0 +1,86 @@
+#ifndef PWM_DITHER_H
+#define PWM_DITHER_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include "pwm_bank.h"
+#include "timing.h"
+#include "worker.h"
+
+// Brightness control for LEDs on a PWM bank running at kHz periods, with
+// more resolution than the PWM unit has.
+//
+// A short period keeps the LED from flickering, on camera too, but leaves
+// few duty steps: at 4 kHz a unit that counts in 1 us steps has 250 of
+// them, under 8 bits, and the dimmest of them is already clearly lit.
+// pwm_dither keeps each duty in finer units, 2^frac_bits of them per step,
+// and on every tick writes the step just below or just above it, chosen by
+// a first order sigma-delta: the error of one tick is carried into the
+// next, so over 2^frac_bits ticks the mean duty is the fine value exactly.
+// The pattern only ever flips between neighbouring steps, so what is left
+// of it is a one step ripple.
+//
+// There is one tick per PWM period: the unit latches a new duty at the end
+// of a period, so ticking faster only overwrites values never shown, and
+// slower holds each for several periods and slows the pattern down with
+// it. The slowest pattern, one step in 2^frac_bits periods, is what shows
+// as flicker, so frac_bits is capped to keep it at PWM_DITHER_MIN_HZ or
+// above: 5 bits at 4 kHz, which with 250 steps of 1 us makes 13 bits.
+//
+// pwm_dither_brightness() takes perceived brightness, 0-65535, and maps it
+// through a gamma 2.2 curve, which is where the fine low end is needed.
+//
+// The ticks run on a thread of their own (pwm_dither_start()) or from the
+// caller's loop (pwm_dither_tick()). A tick writes only the channels whose
+// step changed; pwm_dither_report() gives the CPU it costs.
+
+#define PWM_DITHER_MAX_FRAC_BITS 12
+#define PWM_DITHER_MIN_HZ        100     // slowest dither pattern allowed
+#define PWM_DITHER_GAMMA_POINTS  257     // gamma curve, interpolated between
+
+typedef struct {
+    pwm_bank_t *bank;
+    uint32_t step_ns;
+    int frac_bits;
+    uint32_t full;                       // fine units in a period
+    uint32_t gamma[PWM_DITHER_GAMMA_POINTS];   // fraction of full, 1 << 24 = all
+
+    uint32_t target[PWM_BANK_MAX_CHANNELS];    // fine units, set from any thread
+    uint32_t acc[PWM_BANK_MAX_CHANNELS];       // sigma-delta error
+
+    timing_period_t tick;
+    uint64_t ticks;
+    worker_t worker;
+} pwm_dither_t;
+
+// Dither an open bank whose unit has a duty resolution of step_ns, with up
+// to frac_bits of dithering below it: fewer if the bank's period would
+// make the slowest pattern flicker (d->frac_bits has what is used). -1 if
+// the numbers do not fit.
+int pwm_dither_init(pwm_dither_t *d, pwm_bank_t *bank, uint32_t step_ns, int frac_bits);
+
+// Most dither bits a period_ns PWM takes with no pattern below PWM_DITHER_MIN_HZ
+int pwm_dither_max_frac_bits(uint32_t period_ns);
+
+// Resolution in bits: log2(period / step_ns) + frac_bits
+double pwm_dither_bits(const pwm_dither_t *d);
+
+// Duty in fine units, 0 .. d->full
+void pwm_dither_set(pwm_dither_t *d, int channel, uint32_t fine);
+
+// Perceived brightness 0-65535, gamma corrected; above 0 is never off
+void pwm_dither_brightness(pwm_dither_t *d, int channel, uint16_t level);
+
+// One tick: pick and write each channel's step. Returns the channels
+// written, or -1 if a write failed, as pwm_bank_commit(); a channel whose
+// write failed is written again on the next tick.
+int pwm_dither_tick(pwm_dither_t *d);
+
+// Tick once per PWM period on a thread of its own, until stopped
+int pwm_dither_start(pwm_dither_t *d);
+void pwm_dither_stop(pwm_dither_t *d);
+
+// "PWM dither: 13.0 bits (8.0 + 5), 4000 ticks/s, 1240 writes/s, CPU 1.6%"
+void pwm_dither_report(const pwm_dither_t *d, FILE *out);
+
+#endif
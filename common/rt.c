@@ -0,0 +1,300 @@
+#define _GNU_SOURCE
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#ifdef __GLIBC__
+#include <malloc.h>
+#endif
+#include "rt.h"
+
+#define RT_HEAP_PREFAULT (1024 * 1024)  // bytes of heap touched up front
+
+static int rt_on = 0;
+static int rt_prio = 0;
+static int rt_cpu = -1;
+static int report = 0;
+
+static int exit_pipe[2] = {-1, -1};
+
+static rt_latency_t *loops[RT_MAX_LOOPS];
+static int loop_tids[RT_MAX_LOOPS];
+static int num_loops = 0;
+static pthread_mutex_t loops_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// stdio allocates its buffer on first use; give it one now
+static char stdout_buf[BUFSIZ];
+
+// Touch the stack the loop will use, so those pages are mapped (and, with
+// mlockall, locked) before the first deadline
+static void __attribute__((noinline)) prefault_stack(void) {
+    volatile char stack[RT_STACK_PREFAULT];
+    long page = sysconf(_SC_PAGESIZE);
+
+    for (size_t i = 0; i < sizeof(stack); i += page) {
+        stack[i] = 0;
+    }
+}
+
+// With glibc, keep freed memory in the heap instead of returning it to the
+// kernel, and serve large blocks from the heap rather than fresh mmaps.
+// Then touch a block so a later malloc does not fault.
+static void prefault_heap(void) {
+#ifdef __GLIBC__
+    mallopt(M_TRIM_THRESHOLD, -1);
+    mallopt(M_MMAP_MAX, 0);
+#endif
+    char *p = malloc(RT_HEAP_PREFAULT);
+    if (p != NULL) {
+        long page = sysconf(_SC_PAGESIZE);
+        for (size_t i = 0; i < RT_HEAP_PREFAULT; i += page) {
+            ((volatile char *)p)[i] = 0;
+        }
+        free(p);
+    }
+}
+
+static void report_at_exit(void) {
+    pthread_mutex_lock(&loops_lock);
+    for (int i = 0; i < num_loops; i++) {
+        fprintf(stderr, "T:%2d (%5d) ", i, loop_tids[i]);
+        rt_latency_report(stderr, loops[i]);
+    }
+    pthread_mutex_unlock(&loops_lock);
+}
+
+// The exercises loop until Ctrl-C; make that an exit so the report runs.
+// exit() is not async-signal-safe, so the handler only passes the signal
+// on to a thread that exits on its behalf.
+static void on_signal(int sig) {
+    unsigned char c = sig;
+    int saved = errno;
+
+    if (write(exit_pipe[1], &c, 1) != 1) {
+        _exit(128 + sig);
+    }
+    errno = saved;
+}
+
+static void *exit_thread(void *arg) {
+    unsigned char c;
+    ssize_t n;
+
+    (void)arg;
+    rt_background();
+    while ((n = read(exit_pipe[0], &c, 1)) < 0 && errno == EINTR) {
+    }
+    exit(n == 1 ? 128 + c : 1);
+    return NULL;
+}
+
+static void catch_signal(int sig) {
+    struct sigaction sa, old;
+    pthread_t tid;
+
+    if (sigaction(sig, NULL, &old) != 0 || old.sa_handler != SIG_DFL) {
+        return;    // someone else handles it already
+    }
+    if (exit_pipe[0] < 0) {
+        if (pipe(exit_pipe) != 0) {
+            return;
+        }
+        if (pthread_create(&tid, NULL, exit_thread, NULL) != 0) {
+            close(exit_pipe[0]);
+            close(exit_pipe[1]);
+            exit_pipe[0] = exit_pipe[1] = -1;
+            return;
+        }
+        pthread_detach(tid);
+    }
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;
+    sa.sa_flags = SA_RESTART;
+    sigaction(sig, &sa, NULL);
+}
+
+static volatile sig_atomic_t *stop_flag;
+
+static void set_stop(int sig) {
+    (void)sig;
+    *stop_flag = 1;
+}
+
+void rt_stop_on_signal(volatile sig_atomic_t *flag) {
+    struct sigaction sa;
+
+    stop_flag = flag;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = set_stop;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+}
+
+int rt_setup(void) {
+    const char *prio = getenv("RT_PRIO");
+    const char *cpu = getenv("RT_CPU");
+    const char *rep = getenv("RT_REPORT");
+    struct sched_param sp;
+
+    report = rep != NULL && *rep != '0';
+    if (prio == NULL && !report) {
+        return 1;
+    }
+    timing_init();
+    atexit(report_at_exit);
+    catch_signal(SIGINT);
+    catch_signal(SIGTERM);
+    if (prio == NULL) {
+        return 1;
+    }
+
+    setvbuf(stdout, stdout_buf, _IOLBF, sizeof(stdout_buf));
+
+    rt_prio = atoi(prio);
+    if (rt_prio < sched_get_priority_min(SCHED_FIFO) || rt_prio > sched_get_priority_max(SCHED_FIFO)) {
+        fprintf(stderr, "rt: RT_PRIO must be between %d and %d\n",
+                sched_get_priority_min(SCHED_FIFO), sched_get_priority_max(SCHED_FIFO));
+        return -1;
+    }
+
+    if (cpu != NULL) {
+        cpu_set_t set;
+        rt_cpu = atoi(cpu);
+        CPU_ZERO(&set);
+        CPU_SET(rt_cpu, &set);
+        // Before anything else changes, so a failure leaves the thread as it was
+        if (sched_setaffinity(0, sizeof(set), &set) != 0) {
+            fprintf(stderr, "rt: cannot pin to CPU %d: %s\n", rt_cpu, strerror(errno));
+            rt_cpu = -1;
+            return -1;
+        }
+    }
+
+#ifdef MCL_ONFAULT
+    // Lock pages as they are touched, so helper thread stacks only lock
+    // what they use; the real-time thread's own pages are prefaulted below
+    int locked = mlockall(MCL_CURRENT | MCL_FUTURE | MCL_ONFAULT);
+    if (locked != 0 && errno == EINVAL) {
+        locked = mlockall(MCL_CURRENT | MCL_FUTURE);
+    }
+#else
+    int locked = mlockall(MCL_CURRENT | MCL_FUTURE);
+#endif
+    if (locked != 0) {
+        fprintf(stderr, "rt: mlockall failed: %s\n", strerror(errno));
+    }
+    prefault_stack();
+    prefault_heap();
+
+    memset(&sp, 0, sizeof(sp));
+    sp.sched_priority = rt_prio;
+    int err = pthread_setschedparam(pthread_self(), SCHED_FIFO, &sp);
+    if (err != 0) {
+        fprintf(stderr, "rt: cannot switch to SCHED_FIFO %d: %s\n", rt_prio, strerror(err));
+        if (locked == 0) {
+            munlockall();
+        }
+        return -1;
+    }
+
+    rt_on = 1;
+    fprintf(stderr, "rt: SCHED_FIFO %d%s", rt_prio, locked == 0 ? ", memory locked" : "");
+    if (rt_cpu >= 0) {
+        fprintf(stderr, ", CPU %d", rt_cpu);
+    }
+    fprintf(stderr, "\n");
+    return 0;
+}
+
+int rt_enabled(void) {
+    return rt_on;
+}
+
+void rt_background(void) {
+    struct sched_param sp;
+
+    if (!rt_on) {
+        return;
+    }
+    memset(&sp, 0, sizeof(sp));
+    pthread_setschedparam(pthread_self(), SCHED_OTHER, &sp);
+
+    // Leave the real-time CPU alone, if there is another one to go to
+    long ncpu = sysconf(_SC_NPROCESSORS_ONLN);
+    if (rt_cpu >= 0 && ncpu > 1) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        for (int i = 0; i < ncpu && i < CPU_SETSIZE; i++) {
+            if (i != rt_cpu) {
+                CPU_SET(i, &set);
+            }
+        }
+        sched_setaffinity(0, sizeof(set), &set);
+    }
+}
+
+void rt_latency_record(rt_latency_t *lat, uint64_t late_ns) {
+    uint64_t us = late_ns / TIMING_US;
+
+    lat->count++;
+    lat->sum_ns += late_ns;
+    lat->last_ns = late_ns;
+    if (late_ns < lat->min_ns) {
+        lat->min_ns = late_ns;
+    }
+    if (late_ns > lat->max_ns) {
+        lat->max_ns = late_ns;
+    }
+    lat->hist[us < RT_HIST_US ? us : RT_HIST_US]++;
+}
+
+int rt_period_wait(timing_period_t *p, rt_latency_t *lat) {
+    if (!lat->registered) {
+        lat->registered = 1;
+        lat->period_ns = p->period_ns;
+        pthread_mutex_lock(&loops_lock);
+        if (num_loops < RT_MAX_LOOPS) {
+            loop_tids[num_loops] = (int)syscall(SYS_gettid);
+            loops[num_loops++] = lat;
+        }
+        pthread_mutex_unlock(&loops_lock);
+    }
+
+    int missed = timing_period_wait(p);
+    uint64_t now = timing_now_ns();
+    uint64_t deadline = p->next_ns - p->period_ns;
+
+    rt_latency_record(lat, now > deadline ? now - deadline : 0);
+    return missed;
+}
+
+void rt_latency_report(FILE *out, const rt_latency_t *lat) {
+    uint64_t p99 = 0, seen = 0;
+
+    if (lat->count == 0) {
+        fprintf(out, "%s: no samples\n", lat->name);
+        return;
+    }
+    for (int i = 0; i <= RT_HIST_US; i++) {
+        seen += lat->hist[i];
+        if (seen * 100 >= lat->count * 99) {
+            p99 = i;
+            break;
+        }
+    }
+    fprintf(out, "P:%2d I:%llu C:%7llu Min:%6llu Act:%6llu Avg:%6llu Max:%6llu P99:%s%5llu  %s\n",
+            rt_on ? rt_prio : 0,
+            (unsigned long long)(lat->period_ns / TIMING_US),
+            (unsigned long long)lat->count,
+            (unsigned long long)(lat->min_ns / TIMING_US),
+            (unsigned long long)(lat->last_ns / TIMING_US),
+            (unsigned long long)(lat->sum_ns / lat->count / TIMING_US),
+            (unsigned long long)(lat->max_ns / TIMING_US),
+            p99 == RT_HIST_US ? ">" : " ", (unsigned long long)p99,
+            lat->name);
+}
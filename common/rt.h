@@ -0,0 +1,68 @@
+#ifndef RT_H
+#define RT_H
+
+#include <signal.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "timing.h"
+
+// Opt-in real-time mode for the thread that drives the display, keypad or
+// LCD bus.
+//
+// rt_setup() does nothing unless $RT_PRIO is set (1-99). With it, the
+// calling thread:
+//   - runs SCHED_FIFO at that priority, pinned to $RT_CPU if given;
+//   - has all memory locked (mlockall), its stack prefaulted and, with
+//     glibc, the heap kept from shrinking, so the loop takes no page faults;
+//   - gets a static stdout buffer, so printf never allocates.
+// Call it at the top of main(), before any output. Threads created later
+// inherit the policy; the helper threads (log writer, metrics server, trace
+// dump) drop back to SCHED_OTHER on the other CPUs with rt_background().
+//
+// Without CAP_SYS_NICE (or an rtprio limit) the setup fails with a warning
+// and the program carries on as SCHED_OTHER, unpinned and unlocked. Memory
+// that cannot be locked is only a warning.
+//
+// rt_latency_t measures how late a periodic loop wakes up, like cyclictest.
+// A loop on rt_period_wait() is reported at exit (also on Ctrl-C):
+//
+//     T: 0 ( 1234) P:80 I:100000 C:    600 Min:     9 Act:    14 Avg:    12 Max:    41 P99:   23  keypad scan
+//
+// times in microseconds, I the period, P99 from a 1 us histogram.
+// RT_REPORT=1 reports without $RT_PRIO.
+
+#define RT_STACK_PREFAULT (256 * 1024)  // bytes of stack touched up front
+#define RT_HIST_US        1000          // histogram buckets, 1 us each
+#define RT_MAX_LOOPS      8             // rt_latency_t reported at exit
+
+typedef struct {
+    const char *name;
+    uint64_t period_ns;
+    uint64_t count;
+    uint64_t min_ns, max_ns, sum_ns, last_ns;
+    uint32_t hist[RT_HIST_US + 1];      // last bucket counts the overflows
+    int registered;
+} rt_latency_t;
+
+#define RT_LATENCY_INIT(n) { .name = (n), .min_ns = UINT64_MAX }
+
+// Returns 0 when real-time mode is on, 1 when it was not asked for and -1
+// when it could not be set up
+int rt_setup(void);
+int rt_enabled(void);
+
+// For helper threads: SCHED_OTHER, kept off the real-time CPU
+void rt_background(void);
+
+// For loops that stop and report on Ctrl-C rather than exit: SIGINT and
+// SIGTERM set *flag to 1. Call it after rt_setup() and before starting
+// the threads, which then inherit the real-time policy and leave the
+// signals to the main thread's loop.
+void rt_stop_on_signal(volatile sig_atomic_t *flag);
+
+// timing_period_wait() that also records the wake-up latency
+int rt_period_wait(timing_period_t *p, rt_latency_t *lat);
+void rt_latency_record(rt_latency_t *lat, uint64_t late_ns);
+void rt_latency_report(FILE *out, const rt_latency_t *lat);
+
+#endif
@@ -0,0 +1,168 @@
+#include <math.h>
+#include <string.h>
+#include "servo.h"
+
+// Profile shapes over u = 0..1, with their peak speed and acceleration
+// for a move of 1 in a time of 1
+#define TRAP_F        (1.0 / 3.0)      // share of the move spent accelerating
+#define TRAP_SPEED    (1.0 / (1.0 - TRAP_F))
+#define TRAP_ACCEL    (1.0 / (TRAP_F * (1.0 - TRAP_F)))
+#define SCURVE_SPEED  1.875
+#define SCURVE_ACCEL  5.7735           // 10 / sqrt(3)
+
+static double shape(servo_profile_t profile, double u) {
+    if (profile == SERVO_SCURVE) {
+        return u * u * u * (10.0 + u * (-15.0 + 6.0 * u));
+    }
+    if (u < TRAP_F) {
+        return u * u * TRAP_ACCEL / 2.0;
+    }
+    if (u > 1.0 - TRAP_F) {
+        return 1.0 - (1.0 - u) * (1.0 - u) * TRAP_ACCEL / 2.0;
+    }
+    return (u - TRAP_F / 2.0) * TRAP_SPEED;
+}
+
+static uint32_t clamp_pulse(const servo_channel_t *c, double ns) {
+    if (ns < c->min_ns) {
+        return c->min_ns;
+    }
+    return ns > c->max_ns ? c->max_ns : (uint32_t)ns;
+}
+
+int servo_open(servo_bank_t *s, const int *pins, int count) {
+    memset(s, 0, sizeof(*s));
+    if (pwm_bank_open(&s->bank, pins, count, SERVO_FRAME_NS) != 0) {
+        return -1;
+    }
+    s->count = count;
+    s->step_ns = SERVO_STEP_NS;
+    pthread_mutex_init(&s->lock, NULL);
+    for (int i = 0; i < count; i++) {
+        servo_limits(s, i, SERVO_MIN_NS, SERVO_MAX_NS, SERVO_SPEED, SERVO_ACCEL);
+    }
+    return 0;
+}
+
+void servo_close(servo_bank_t *s) {
+    servo_stop(s);
+    pwm_bank_close(&s->bank);
+    pthread_mutex_destroy(&s->lock);
+}
+
+void servo_limits(servo_bank_t *s, int channel, uint32_t min_ns, uint32_t max_ns, uint32_t speed,
+                  uint32_t accel) {
+    if (channel < 0 || channel >= s->count || min_ns > max_ns || speed == 0 || accel == 0) {
+        return;
+    }
+
+    pthread_mutex_lock(&s->lock);
+    servo_channel_t *c = &s->ch[channel];
+    c->min_ns = min_ns;
+    c->max_ns = max_ns;
+    c->speed = speed;
+    c->accel = accel;
+    // Park it mid range until it is first moved
+    if (c->pulse_ns == 0) {
+        c->pulse_ns = min_ns + (max_ns - min_ns) / 2;
+        c->from = c->to = c->pulse_ns;
+    }
+    pthread_mutex_unlock(&s->lock);
+}
+
+uint64_t servo_move(servo_bank_t *s, const uint32_t *target_ns, servo_profile_t profile) {
+    double peak_speed = profile == SERVO_SCURVE ? SCURVE_SPEED : TRAP_SPEED;
+    double peak_accel = profile == SERVO_SCURVE ? SCURVE_ACCEL : TRAP_ACCEL;
+    double seconds = 0.0;
+
+    pthread_mutex_lock(&s->lock);
+    for (int i = 0; i < s->count; i++) {
+        servo_channel_t *c = &s->ch[i];
+        c->from = c->pulse_ns;
+        c->to = clamp_pulse(c, target_ns[i]);
+
+        // Shortest time that keeps this channel within its limits
+        double d = c->to > c->from ? c->to - c->from : c->from - c->to;
+        double by_speed = d * peak_speed / c->speed;
+        double by_accel = sqrt(d * peak_accel / c->accel);
+        double t = by_speed > by_accel ? by_speed : by_accel;
+        if (t > seconds) {
+            seconds = t;
+        }
+    }
+
+    // Whole frames, so every move ends on a frame
+    uint64_t frames = (uint64_t)(seconds * TIMING_S / SERVO_FRAME_NS) + 1;
+    s->profile = profile;
+    s->start_ns = timing_now_ns();
+    s->move_ns = frames * SERVO_FRAME_NS;
+    pthread_mutex_unlock(&s->lock);
+    return s->move_ns;
+}
+
+int servo_busy(servo_bank_t *s) {
+    pthread_mutex_lock(&s->lock);
+    int busy = timing_now_ns() < s->start_ns + s->move_ns;
+    pthread_mutex_unlock(&s->lock);
+    return busy;
+}
+
+int servo_frame(servo_bank_t *s, uint64_t deadline_ns) {
+    uint64_t t0 = timing_now_ns();
+
+    // Setpoints for the deadline, staged under the lock; the writes after it
+    pthread_mutex_lock(&s->lock);
+    double u = 1.0;
+    if (deadline_ns < s->start_ns) {
+        u = 0.0;
+    } else if (deadline_ns < s->start_ns + s->move_ns) {
+        u = (double)(deadline_ns - s->start_ns) / s->move_ns;
+    }
+    double k = u >= 1.0 ? 1.0 : shape(s->profile, u);
+
+    for (int i = 0; i < s->count; i++) {
+        servo_channel_t *c = &s->ch[i];
+        double pos = c->from + (c->to - c->from) * k;
+        uint32_t steps = (uint32_t)(pos / s->step_ns + 0.5);
+        c->pulse_ns = clamp_pulse(c, (double)steps * s->step_ns);
+        pwm_bank_stage(&s->bank, i, c->pulse_ns);    // unchanged: not written
+    }
+    pthread_mutex_unlock(&s->lock);
+
+    int written = pwm_bank_commit(&s->bank);
+    uint64_t now = timing_now_ns();
+
+    s->frames++;
+    s->writes += written > 0 ? written : 0;
+    if (now - t0 > s->max_work_ns) {
+        s->max_work_ns = now - t0;
+    }
+    if (now > deadline_ns && now - deadline_ns > s->max_late_ns) {
+        s->max_late_ns = now - deadline_ns;
+    }
+    return written;
+}
+
+static void step(void *arg) {
+    servo_bank_t *s = arg;
+    uint64_t deadline = s->tick.next_ns;
+
+    timing_period_wait(&s->tick);
+    servo_frame(s, deadline);
+}
+
+int servo_start(servo_bank_t *s) {
+    timing_period_init(&s->tick, SERVO_FRAME_NS);
+    return worker_start(&s->worker, "Servos", step, s);
+}
+
+void servo_stop(servo_bank_t *s) {
+    worker_stop(&s->worker);
+}
+
+void servo_report(const servo_bank_t *s, FILE *out) {
+    fprintf(out, "Servos: %d channels, %lu frames, %.2f writes/frame, work max %llu us, late max %llu us, "
+            "%llu frames overrun\n", s->count, s->frames, s->frames ? (double)s->writes / s->frames : 0.0,
+            (unsigned long long)(s->max_work_ns / TIMING_US), (unsigned long long)(s->max_late_ns / TIMING_US),
+            (unsigned long long)s->tick.missed);
+}
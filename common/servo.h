@@ -0,0 +1,96 @@
+#ifndef SERVO_H
+#define SERVO_H
+
+#include <stdint.h>
+#include <stdio.h>
+#include <pthread.h>
+#include "pwm_bank.h"
+#include "timing.h"
+#include "worker.h"
+
+// Hobby servos on a PWM bank, moved along motion profiles.
+//
+// A servo reads the pulse width once per 20 ms frame, so that is the rate
+// at which setpoints are worth computing: once per frame, for the time of
+// the frame's deadline, the engine evaluates each channel's profile, rounds
+// the pulse to step_ns and writes the channels whose pulse changed, in one
+// pwm_bank_commit(). The frames run on absolute deadlines (its own thread,
+// or servo_frame() from the caller's loop), and the motion is worked out
+// from the deadline rather than the wake-up time, so a late wake-up does
+// not show in the path.
+//
+// servo_move() moves all channels to new pulse widths together: each
+// channel's shortest move under its speed and acceleration limits is
+// worked out, and all of them take the longest of those, with the same
+// profile shape, so they start and arrive together in a straight line.
+//   - SERVO_TRAPEZOID: constant acceleration for the first third, constant
+//     speed, constant deceleration for the last third;
+//   - SERVO_SCURVE: minimum jerk (10u^3 - 15u^4 + 6u^5), acceleration
+//     ramps in and out, gentler on the gears and the load.
+// A move starts from where the channels are; issued while one is under
+// way, it starts from the current position but not its speed.
+
+#define SERVO_FRAME_NS     (20 * TIMING_MS)
+#define SERVO_MIN_NS       1000000    // default pulse range, 1-2 ms
+#define SERVO_MAX_NS       2000000
+#define SERVO_SPEED        2000000    // default limits: full range in 0.5 s
+#define SERVO_ACCEL        20000000   //   ns of pulse per s and per s^2
+#define SERVO_STEP_NS      1000       // pulse resolution, below the deadband
+
+typedef enum {
+    SERVO_TRAPEZOID = 0,
+    SERVO_SCURVE
+} servo_profile_t;
+
+typedef struct {
+    uint32_t min_ns, max_ns;       // pulse range
+    uint32_t speed, accel;         // limits, ns of pulse per s, per s^2
+    double from, to;               // current move, pulse ns
+    uint32_t pulse_ns;             // last written
+} servo_channel_t;
+
+typedef struct {
+    pwm_bank_t bank;
+    servo_channel_t ch[PWM_BANK_MAX_CHANNELS];
+    int count;
+    uint32_t step_ns;
+
+    pthread_mutex_t lock;          // the move, shared with servo_move()
+    servo_profile_t profile;
+    uint64_t start_ns, move_ns;
+
+    timing_period_t tick;
+    unsigned long frames, writes;
+    uint64_t max_work_ns, max_late_ns;
+    worker_t worker;
+} servo_bank_t;
+
+// Open 'count' PWM channels (see pwm_bank.h) at the 20 ms frame, all
+// centred in the default range
+int servo_open(servo_bank_t *s, const int *pins, int count);
+void servo_close(servo_bank_t *s);
+
+// Pulse range and limits of one channel; call before moving it
+void servo_limits(servo_bank_t *s, int channel, uint32_t min_ns, uint32_t max_ns, uint32_t speed,
+                  uint32_t accel);
+
+// Move every channel to target_ns[] (clamped to its range), starting now;
+// the next frame is its first. Returns the duration of the move in ns.
+uint64_t servo_move(servo_bank_t *s, const uint32_t *target_ns, servo_profile_t profile);
+
+// Nonzero while a move is under way
+int servo_busy(servo_bank_t *s);
+
+// Set up and write the frame whose deadline is deadline_ns. Returns the
+// number of channels written.
+int servo_frame(servo_bank_t *s, uint64_t deadline_ns);
+
+// Run the frames on a thread of their own, on 20 ms deadlines
+int servo_start(servo_bank_t *s);
+void servo_stop(servo_bank_t *s);
+
+// "Servos: 3 channels, 1500 frames, 0.9 writes/frame, work max 41 us,
+//  late max 130 us, 0 frames overrun"
+void servo_report(const servo_bank_t *s, FILE *out);
+
+#endif
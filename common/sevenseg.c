@@ -0,0 +1,34 @@
+#include "gpio_pool.h"
+#include "sevenseg.h"
+#include "trace.h"
+
+// Segment mapping for digits 0-9
+const int digit_map[10][NUM_SEGMENTS] = {
+    {0, 0, 0, 0, 0, 0, 1}, // 0
+    {1, 0, 0, 1, 1, 1, 1}, // 1
+    {0, 0, 1, 0, 0, 1, 0}, // 2
+    {0, 0, 0, 0, 1, 1, 0}, // 3
+    {1, 0, 0, 1, 1, 0, 0}, // 4
+    {0, 1, 0, 0, 1, 0, 0}, // 5
+    {0, 1, 0, 0, 0, 0, 0}, // 6
+    {0, 0, 0, 1, 1, 1, 1}, // 7
+    {0, 0, 0, 0, 0, 0, 0}, // 8
+    {0, 0, 0, 0, 1, 0, 0}  // 9
+};
+
+void display_digit(int digit, const int *seg_pins) {
+    if (digit >= 0 && digit <= 9) {
+        TRACE_BEGIN("display_digit");
+        for (int i = 0; i < NUM_SEGMENTS; i++) {
+            gpio_pool_write(seg_pins[i], digit_map[digit][i]);
+        }
+        TRACE_END("display_digit");
+    }
+}
+
+void turn_off_7seg(const int *seg_pins) {
+    // Turn off all 7-segment display segments (a-g)
+    for (int i = 0; i < NUM_SEGMENTS; i++) {
+        gpio_pool_write(seg_pins[i], 1);
+    }
+}
@@ -0,0 +1,15 @@
+#ifndef SEVENSEG_H
+#define SEVENSEG_H
+
+// Common-anode 7-segment display on seven GPIO pool lines (a-g).
+// A segment is lit by driving its line LOW.
+
+#define NUM_SEGMENTS 7
+
+// Segment levels for digits 0-9
+extern const int digit_map[10][NUM_SEGMENTS];
+
+void display_digit(int digit, const int *seg_pins);
+void turn_off_7seg(const int *seg_pins);
+
+#endif
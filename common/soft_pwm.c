@@ -0,0 +1,137 @@
+#include <string.h>
+#include "gpio_pool.h"
+#include "soft_pwm.h"
+
+#define SOFT_PWM_MIN_SLOT_NS TIMING_US   // shortest slot worth trying to hit
+
+int soft_pwm_init(soft_pwm_t *p, const int *lines, int count, int bits, unsigned freq_hz) {
+    if (count < 1 || count > SOFT_PWM_MAX_CHANNELS || bits < 1 || bits > SOFT_PWM_MAX_BITS || freq_hz == 0) {
+        fprintf(stderr, "soft PWM: %d channels, %d bits, %u Hz out of range\n", count, bits, freq_hz);
+        return -1;
+    }
+
+    memset(p, 0, sizeof(*p));
+    memcpy(p->lines, lines, count * sizeof(int));
+    p->count = count;
+    p->bits = bits;
+    p->period_ns = TIMING_S / freq_hz;
+
+    // Slot k is 2^k units; the last one takes the rounding so a frame is
+    // exactly one period
+    uint64_t units = (1u << bits) - 1, used = 0;
+    for (int k = 0; k < bits; k++) {
+        p->slot_ns[k] = p->period_ns * (1u << k) / units;
+        used += p->slot_ns[k];
+    }
+    p->slot_ns[bits - 1] += p->period_ns - used;
+    if (p->slot_ns[0] < SOFT_PWM_MIN_SLOT_NS) {
+        fprintf(stderr, "soft PWM: %d bits at %u Hz needs %llu ns slots\n",
+                bits, freq_hz, (unsigned long long)p->slot_ns[0]);
+        return -1;
+    }
+
+    p->steady = 1;
+    p->lat = (rt_latency_t)RT_LATENCY_INIT("soft PWM edges");
+    p->lat.period_ns = p->period_ns;
+    timing_init();
+    return gpio_pool_write_lines(p->lines, p->count, 0) < 0 ? -1 : 0;
+}
+
+void soft_pwm_set(soft_pwm_t *p, int channel, uint32_t duty) {
+    uint32_t full = (1u << p->bits) - 1;
+
+    if (channel < 0 || channel >= p->count) {
+        return;
+    }
+    __atomic_store_n(&p->duty[channel], duty < full ? duty : full, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&p->gen, 1, __ATOMIC_RELEASE);
+}
+
+// Turn the duties into one level mask per slot, if any changed
+static void latch(soft_pwm_t *p) {
+    uint32_t gen = __atomic_load_n(&p->gen, __ATOMIC_ACQUIRE);
+
+    if (gen == p->seen_gen) {
+        return;
+    }
+    p->seen_gen = gen;
+
+    memset(p->mask, 0, sizeof(p->mask));
+    for (int ch = 0; ch < p->count; ch++) {
+        uint32_t duty = __atomic_load_n(&p->duty[ch], __ATOMIC_RELAXED);
+        for (int k = 0; k < p->bits; k++) {
+            p->mask[k] |= ((duty >> k) & 1u) << ch;
+        }
+    }
+    p->steady = 1;
+    for (int k = 1; k < p->bits; k++) {
+        if (p->mask[k] != p->mask[0]) {
+            p->steady = 0;
+        }
+    }
+}
+
+uint64_t soft_pwm_frame(soft_pwm_t *p) {
+    uint64_t worst = 0;
+
+    if (p->next_ns == 0) {
+        p->next_ns = timing_now_ns();
+    }
+    latch(p);
+
+    if (p->steady) {
+        // Every output on or off for the whole frame: no edges to time
+        timing_sleep_until(p->next_ns);
+        gpio_pool_write_lines(p->lines, p->count, p->mask[0]);
+        p->wakeups++;
+    } else {
+        uint64_t edge = p->next_ns;
+        for (int k = 0; k < p->bits; k++) {
+            timing_wait_until(edge);
+            gpio_pool_write_lines(p->lines, p->count, p->mask[k]);
+            uint64_t late = timing_now_ns() - edge;
+            rt_latency_record(&p->lat, late);
+            if (late > worst) {
+                worst = late;
+            }
+            p->wakeups++;
+            edge += p->slot_ns[k];
+        }
+    }
+    p->frames++;
+
+    // Absolute deadlines; after a stall of more than a frame start afresh
+    // instead of rushing through the frames that were missed
+    uint64_t now = timing_now_ns();
+    p->next_ns += p->period_ns;
+    if (now > p->next_ns + p->period_ns) {
+        p->missed += (now - p->next_ns) / p->period_ns;
+        p->next_ns = now;
+    }
+    return worst;
+}
+
+static void step(void *arg) {
+    soft_pwm_frame(arg);
+}
+
+int soft_pwm_start(soft_pwm_t *p) {
+    p->next_ns = timing_now_ns();
+    return worker_start(&p->worker, "soft PWM", step, p);
+}
+
+void soft_pwm_stop(soft_pwm_t *p) {
+    worker_stop(&p->worker);
+    gpio_pool_write_lines(p->lines, p->count, 0);
+}
+
+void soft_pwm_report(const soft_pwm_t *p, FILE *out) {
+    fprintf(out, "soft PWM: %d ch, %d bit, %llu Hz", p->count, p->bits,
+            (unsigned long long)(TIMING_S / p->period_ns));
+    if (p->worker.run_ns > 0) {
+        fprintf(out, ", %.0f wake-ups/s, CPU %.1f%%", p->wakeups * (double)TIMING_S / p->worker.run_ns,
+                100.0 * p->worker.cpu_ns / p->worker.run_ns);
+    }
+    fprintf(out, ", %llu frames, %llu missed\n", (unsigned long long)p->frames, (unsigned long long)p->missed);
+    rt_latency_report(out, &p->lat);
+}
@@ -0,0 +1,155 @@
+#include <errno.h>
+#include <pthread.h>
+#include <time.h>
+#include "timing.h"
+
+#define CALIBRATE_ROUNDS 5
+
+static pthread_once_t once = PTHREAD_ONCE_INIT;
+static uint64_t clock_cost_ns = 0;     // one clock_gettime()
+static uint64_t loops_per_ms = 0;      // empty loop iterations per millisecond
+static uint64_t loop_limit_ns = 0;     // below this, count loops
+static uint64_t spin_limit_ns = 0;     // below this, spin on the clock
+
+uint64_t timing_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * TIMING_S + ts.tv_nsec;
+}
+
+static void spin_loops(uint64_t n) {
+    for (uint64_t i = 0; i < n; i++) {
+        __asm__ volatile("" ::: "memory");
+    }
+}
+
+static void sort(uint64_t *v, int n) {
+    for (int i = 1; i < n; i++) {
+        for (int j = i; j > 0 && v[j] < v[j - 1]; j--) {
+            uint64_t t = v[j];
+            v[j] = v[j - 1];
+            v[j - 1] = t;
+        }
+    }
+}
+
+static void calibrate(void) {
+    uint64_t samples[CALIBRATE_ROUNDS];
+
+    // Cost of reading the clock
+    uint64_t t0 = timing_now_ns();
+    for (int i = 0; i < 1000; i++) {
+        timing_now_ns();
+    }
+    clock_cost_ns = (timing_now_ns() - t0) / 1000;
+
+    // Loop speed: grow the count until a run takes about a millisecond,
+    // then keep the fastest of a few runs (the others were interrupted)
+    uint64_t n = 1024;
+    while (1) {
+        t0 = timing_now_ns();
+        spin_loops(n);
+        if (timing_now_ns() - t0 >= TIMING_MS || n >= (1ULL << 32)) {
+            break;
+        }
+        n *= 2;
+    }
+    for (int i = 0; i < CALIBRATE_ROUNDS; i++) {
+        t0 = timing_now_ns();
+        spin_loops(n);
+        samples[i] = timing_now_ns() - t0;
+    }
+    sort(samples, CALIBRATE_ROUNDS);
+    loops_per_ms = n * TIMING_MS / (samples[0] ? samples[0] : 1);
+
+    // How late a sleep wakes up, median of a few very short ones
+    for (int i = 0; i < CALIBRATE_ROUNDS; i++) {
+        uint64_t target = timing_now_ns() + TIMING_US;
+        timing_sleep_until(target);
+        samples[i] = timing_now_ns() - target;
+    }
+    sort(samples, CALIBRATE_ROUNDS);
+
+    spin_limit_ns = samples[CALIBRATE_ROUNDS / 2] + TIMING_US;
+    loop_limit_ns = 20 * clock_cost_ns;
+    if (loop_limit_ns < TIMING_US) {
+        loop_limit_ns = TIMING_US;
+    }
+}
+
+void timing_init(void) {
+    pthread_once(&once, calibrate);
+}
+
+void timing_sleep_until(uint64_t deadline_ns) {
+    struct timespec ts = {deadline_ns / TIMING_S, deadline_ns % TIMING_S};
+
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+    }
+}
+
+void timing_wait_until(uint64_t deadline_ns) {
+    timing_init();
+
+    uint64_t now = timing_now_ns();
+    if (deadline_ns > now + spin_limit_ns) {
+        timing_sleep_until(deadline_ns - spin_limit_ns);
+    }
+    while (timing_now_ns() < deadline_ns) {
+    }
+}
+
+void delay_ns(uint64_t ns) {
+    timing_init();
+
+    if (ns <= loop_limit_ns) {
+        spin_loops((ns * loops_per_ms + TIMING_MS - 1) / TIMING_MS);
+        return;
+    }
+
+    uint64_t deadline = timing_now_ns() + ns;
+    if (ns <= spin_limit_ns) {
+        while (timing_now_ns() < deadline) {
+        }
+        return;
+    }
+    timing_sleep_until(deadline);
+}
+
+void delay_us(uint64_t us) {
+    delay_ns(us * TIMING_US);
+}
+
+void delay_ms(uint64_t ms) {
+    delay_ns(ms * TIMING_MS);
+}
+
+void timing_period_init(timing_period_t *p, uint64_t period_ns) {
+    timing_init();
+    p->period_ns = period_ns;
+    p->next_ns = timing_now_ns() + period_ns;
+    p->missed = 0;
+}
+
+int timing_period_wait(timing_period_t *p) {
+    uint64_t now = timing_now_ns();
+    int missed = 0;
+
+    // Late by less than a period: run now, late, and stay on the grid.
+    // Late by whole periods: skip those instead of catching up in a burst.
+    if (now > p->next_ns && now - p->next_ns >= p->period_ns) {
+        missed = (int)((now - p->next_ns) / p->period_ns);
+        p->next_ns += (uint64_t)missed * p->period_ns;
+        p->missed += missed;
+    }
+    timing_sleep_until(p->next_ns);
+    p->next_ns += p->period_ns;
+    return missed;
+}
+
+void timing_report(FILE *out) {
+    timing_init();
+    fprintf(out, "Timing: clock read %llu ns, %llu loops/us, sleep wake-up %.1f us\n",
+            (unsigned long long)clock_cost_ns, (unsigned long long)(loops_per_ms / 1000),
+            (spin_limit_ns - TIMING_US) / 1e3);
+}
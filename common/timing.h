@@ -0,0 +1,61 @@
+#ifndef TIMING_H
+#define TIMING_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Delays and periodic loops on CLOCK_MONOTONIC.
+//
+// delay_ns()/delay_us()/delay_ms() pick the cheapest way to wait that is
+// still accurate, using numbers measured once at startup:
+//   - shorter than a few clock reads: a calibrated empty loop, no syscalls
+//     (a clock read is a syscall on the A5D2X, which has no vDSO timer);
+//   - shorter than the wake-up latency of a sleep: spin on the clock;
+//   - longer: clock_nanosleep() to an absolute deadline.
+// All of them wait at least the requested time.
+//
+// timing_period_t runs a loop on absolute deadlines, so the time spent in
+// the loop body does not add up into drift:
+//
+//     timing_period_t tick;
+//     timing_period_init(&tick, 100 * TIMING_MS);
+//     while (1) {
+//         ...
+//         timing_period_wait(&tick);
+//     }
+
+#define TIMING_US 1000ULL
+#define TIMING_MS 1000000ULL
+#define TIMING_S  1000000000ULL
+
+typedef struct {
+    uint64_t next_ns;       // absolute deadline of the next period
+    uint64_t period_ns;
+    uint64_t missed;        // periods skipped because the body overran
+} timing_period_t;
+
+// Calibrates on first use; call it early to keep that out of the hot path
+void timing_init(void);
+
+uint64_t timing_now_ns(void);
+void timing_sleep_until(uint64_t deadline_ns);
+
+// Sleep until a sleep's wake-up latency before the deadline, then spin:
+// for edges that must be on time, at the cost of some CPU
+void timing_wait_until(uint64_t deadline_ns);
+
+void delay_ns(uint64_t ns);
+void delay_us(uint64_t us);
+void delay_ms(uint64_t ms);
+
+void timing_period_init(timing_period_t *p, uint64_t period_ns);
+
+// Sleep until the next deadline, or return at once if it has passed. A
+// deadline is only skipped once the next one has passed too: those are
+// skipped rather than run back to back. Returns the number skipped.
+int timing_period_wait(timing_period_t *p);
+
+// The calibration, e.g. "clock read 25 ns, 410 loops/us, sleep wake-up 58 us"
+void timing_report(FILE *out);
+
+#endif
@@ -0,0 +1,192 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <signal.h>
+#include <pthread.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/syscall.h>
+#include "trace.h"
+#include "rt.h"
+
+typedef struct trace_ring {
+    trace_record_t rec[TRACE_RING_SIZE];
+    uint32_t head;            // total records written, only the owner stores
+    uint32_t tail;            // records already dumped, only the dumper stores
+    int tid;
+    struct trace_ring *next;  // list of all rings, for the dumper
+} trace_ring_t;
+
+volatile int trace_enabled = 0;
+
+static trace_ring_t *rings = NULL;
+static __thread trace_ring_t *my_ring = NULL;
+
+static int dump_pipe[2] = {-1, -1};
+static int dumps = 0;
+static pthread_once_t init_once = PTHREAD_ONCE_INIT;
+
+static uint64_t now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+// First record on a thread: allocate its ring and push it onto the list
+static trace_ring_t *ring_create(void) {
+    trace_ring_t *r = calloc(1, sizeof(*r));
+    if (r == NULL) {
+        return NULL;
+    }
+    r->tid = (int)syscall(SYS_gettid);
+
+    trace_ring_t *old = __atomic_load_n(&rings, __ATOMIC_ACQUIRE);
+    do {
+        r->next = old;
+    } while (!__atomic_compare_exchange_n(&rings, &old, r, 1, __ATOMIC_RELEASE, __ATOMIC_ACQUIRE));
+    return r;
+}
+
+void trace_record(const char *name, char phase, int32_t arg) {
+    trace_ring_t *r = my_ring;
+    if (r == NULL && (r = my_ring = ring_create()) == NULL) {
+        return;
+    }
+
+    uint32_t h = r->head;
+    trace_record_t *rec = &r->rec[h & (TRACE_RING_SIZE - 1)];
+    rec->ts_ns = now_ns();
+    rec->name = name;
+    rec->arg = arg;
+    rec->phase = phase;
+    __atomic_store_n(&r->head, h + 1, __ATOMIC_RELEASE);
+}
+
+// The records since the previous dump, as far as the ring still holds them
+static void write_ring(FILE *fp, trace_ring_t *r, int pid, int *first) {
+    uint32_t head = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+    uint32_t start = head > TRACE_RING_SIZE ? head - TRACE_RING_SIZE : 0;
+
+    if (head - r->tail < head - start) {
+        start = r->tail;
+    }
+    r->tail = head;
+
+    for (uint32_t i = start; i < head; i++) {
+        trace_record_t rec = r->rec[i & (TRACE_RING_SIZE - 1)];
+
+        // The owner may have lapped us while we were copying
+        uint32_t now = __atomic_load_n(&r->head, __ATOMIC_ACQUIRE);
+        if (now - i >= TRACE_RING_SIZE) {
+            continue;
+        }
+
+        fprintf(fp, "%s\n{\"name\":\"%s\",\"ph\":\"%c\",\"ts\":%.3f,\"pid\":%d,\"tid\":%d",
+                *first ? "" : ",", rec.name, rec.phase, rec.ts_ns / 1000.0, pid, r->tid);
+        if (rec.phase == 'C') {
+            fprintf(fp, ",\"args\":{\"value\":%d}", (int)rec.arg);
+        } else if (rec.phase == 'i') {
+            fprintf(fp, ",\"s\":\"t\",\"args\":{\"arg\":%d}", (int)rec.arg);
+        }
+        fputc('}', fp);
+        *first = 0;
+    }
+}
+
+int trace_dump(const char *path) {
+    char def[64];
+    int pid = getpid();
+    int first = 1;
+
+    if (path == NULL) {
+        path = getenv("TRACE_FILE");
+    }
+    if (path == NULL) {
+        snprintf(def, sizeof(def), "trace-%d-%d.json", pid, dumps + 1);
+        path = def;
+    }
+
+    FILE *fp = fopen(path, "w");
+    if (fp == NULL) {
+        return -1;
+    }
+
+    fprintf(fp, "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[");
+    for (trace_ring_t *r = __atomic_load_n(&rings, __ATOMIC_ACQUIRE); r; r = r->next) {
+        write_ring(fp, r, pid, &first);
+    }
+    fprintf(fp, "\n]}\n");
+    fclose(fp);
+    dumps++;
+
+    fprintf(stderr, "trace: wrote %s\n", path);
+    return 0;
+}
+
+void trace_set_enabled(int on) {
+    trace_enabled = on;
+}
+
+// SIGUSR1: toggle; when switching off, wake the dump thread
+static void on_sigusr1(int sig) {
+    (void)sig;
+    trace_enabled = !trace_enabled;
+    if (!trace_enabled) {
+        char c = 'd';
+        if (write(dump_pipe[1], &c, 1) < 0) {
+            // nothing useful to do in a signal handler
+        }
+    }
+}
+
+static void *dump_thread(void *arg) {
+    char c;
+    (void)arg;
+    rt_background();
+    while (read(dump_pipe[0], &c, 1) == 1) {
+        trace_dump(NULL);
+    }
+    return NULL;
+}
+
+// At exit, only if something was recorded since the last dump
+static void dump_at_exit(void) {
+    for (trace_ring_t *r = __atomic_load_n(&rings, __ATOMIC_ACQUIRE); r; r = r->next) {
+        if (__atomic_load_n(&r->head, __ATOMIC_ACQUIRE) != r->tail) {
+            trace_dump(NULL);
+            return;
+        }
+    }
+}
+
+static void do_init(void) {
+    pthread_t tid;
+    sigset_t all, old;
+    struct sigaction sa;
+
+    const char *env = getenv("TRACE");
+    trace_enabled = (env != NULL && atoi(env) != 0);
+
+    if (pipe(dump_pipe) != 0) {
+        return;
+    }
+
+    // The dump thread must not take the toggle signal itself
+    sigfillset(&all);
+    pthread_sigmask(SIG_BLOCK, &all, &old);
+    if (pthread_create(&tid, NULL, dump_thread, NULL) == 0) {
+        pthread_detach(tid);
+    }
+    pthread_sigmask(SIG_SETMASK, &old, NULL);
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_sigusr1;
+    sa.sa_flags = SA_RESTART;
+    sigaction(SIGUSR1, &sa, NULL);
+
+    atexit(dump_at_exit);
+}
+
+void trace_init(void) {
+    pthread_once(&init_once, do_init);
+}
@@ -0,0 +1,54 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <stdint.h>
+
+// Hot-path latency tracing.
+//
+// Instrumentation points write fixed-size timestamped records into a
+// per-thread ring buffer: a single producer per ring, so a record costs one
+// clock read and a few stores, no locks and no syscalls. When the ring is
+// full the oldest records are overwritten.
+//
+// Build with -DTRACE_ENABLE to compile the points in; without it every
+// TRACE_* macro expands to nothing. At runtime tracing starts disabled
+// (TRACE=1 in the environment starts it enabled); SIGUSR1 toggles it, and
+// switching it off writes the records since the previous dump to
+// $TRACE_FILE (default trace-<pid>-<n>.json for the n-th dump) in Chrome
+// trace event format, which chrome://tracing and ui.perfetto.dev both load.
+// What is left is also written at exit.
+//
+// Event names must be string literals; only the pointer is recorded.
+
+#define TRACE_RING_SIZE 8192   // records per thread, power of two
+
+typedef struct {
+    uint64_t ts_ns;
+    const char *name;
+    int32_t arg;
+    char phase;               // 'B' begin, 'E' end, 'i' instant, 'C' counter
+} trace_record_t;
+
+void trace_init(void);
+void trace_set_enabled(int on);
+int trace_dump(const char *path);
+
+// Slow path of the macros below
+void trace_record(const char *name, char phase, int32_t arg);
+
+extern volatile int trace_enabled;
+
+#ifdef TRACE_ENABLE
+#define TRACE_INIT()              trace_init()
+#define TRACE_EVENT(n, ph, a)     do { if (trace_enabled) trace_record((n), (ph), (a)); } while (0)
+#else
+#define TRACE_INIT()              ((void)0)
+#define TRACE_EVENT(n, ph, a)     ((void)0)
+#endif
+
+#define TRACE_BEGIN(name)          TRACE_EVENT(name, 'B', 0)
+#define TRACE_END(name)            TRACE_EVENT(name, 'E', 0)
+#define TRACE_INSTANT(name, arg)   TRACE_EVENT(name, 'i', (int32_t)(arg))
+#define TRACE_COUNTER(name, value) TRACE_EVENT(name, 'C', (int32_t)(value))
+
+#endif
@@ -0,0 +1,172 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <asm/termbits.h>
+#include <linux/serial.h>
+#include "uart_cfg.h"
+
+static int env_int(const char *name, int def) {
+    const char *v = getenv(name);
+    return (v != NULL && *v != '\0') ? atoi(v) : def;
+}
+
+void uart_cfg_init(uart_cfg_t *cfg, const char *dev, unsigned baud) {
+    const char *v = getenv("UART_DEV");
+
+    cfg->dev = (v != NULL && *v != '\0') ? v : dev;
+    cfg->baud = (unsigned)env_int("UART_BAUD", (int)baud);
+    cfg->vmin = env_int("UART_VMIN", -1);
+    cfg->vtime = env_int("UART_VTIME", -1);
+    cfg->low_latency = env_int("UART_LOW_LATENCY", 0) != 0;
+    cfg->rtscts = env_int("UART_RTSCTS", 0) != 0;
+}
+
+void uart_cfg_print(const uart_cfg_t *cfg, FILE *out) {
+    fprintf(out, "UART %s: %u baud 8N1", cfg->dev, cfg->baud);
+    if (cfg->vmin >= 0 || cfg->vtime >= 0) {
+        fprintf(out, ", VMIN %d VTIME %d", cfg->vmin < 0 ? 1 : cfg->vmin, cfg->vtime < 0 ? 0 : cfg->vtime);
+    }
+    fprintf(out, "%s%s\n", cfg->low_latency ? ", low latency" : "", cfg->rtscts ? ", RTS/CTS" : "");
+}
+
+// A descriptor of our own on the device. mraa keeps its descriptor to
+// itself, but the termios settings belong to the tty, not to a descriptor,
+// so what is set through this one applies to mraa's as well.
+static int open_tty(const char *dev) {
+    int fd = open(dev, O_RDWR | O_NOCTTY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0) {
+        fprintf(stderr, "Failed to open UART %s: %s\n", dev, strerror(errno));
+    }
+    return fd;
+}
+
+static int standard_rate(unsigned baud) {
+    static const unsigned rates[] = {9600, 19200, 38400, 57600, 115200, 230400, 460800, 921600};
+
+    for (unsigned i = 0; i < sizeof(rates) / sizeof(rates[0]); i++) {
+        if (rates[i] == baud) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Rate (if mraa could not), VMIN/VTIME and RTS/CTS in one termios2 update
+static int set_termios(int fd, const uart_cfg_t *cfg, int custom_rate) {
+    struct termios2 tio;
+
+    if (ioctl(fd, TCGETS2, &tio) != 0) {
+        return -1;
+    }
+    if (custom_rate) {
+        tio.c_cflag &= ~CBAUD;
+        tio.c_cflag |= BOTHER;
+        tio.c_ispeed = cfg->baud;
+        tio.c_ospeed = cfg->baud;
+    }
+    if (cfg->vmin >= 0 || cfg->vtime >= 0) {
+        tio.c_cc[VMIN] = cfg->vmin < 0 ? 1 : (cfg->vmin > 255 ? 255 : cfg->vmin);
+        tio.c_cc[VTIME] = cfg->vtime < 0 ? 0 : (cfg->vtime > 255 ? 255 : cfg->vtime);
+    }
+    if (cfg->rtscts) {
+        tio.c_cflag |= CRTSCTS;
+    }
+    return ioctl(fd, TCSETS2, &tio);
+}
+
+static int set_low_latency(int fd) {
+    struct serial_struct ss;
+
+    if (ioctl(fd, TIOCGSERIAL, &ss) != 0) {
+        return -1;
+    }
+    ss.flags |= ASYNC_LOW_LATENCY;
+    return ioctl(fd, TIOCSSERIAL, &ss);
+}
+
+int uart_open_fd(const uart_cfg_t *cfg) {
+    struct termios2 tio;
+
+    if (cfg->baud == 0 || cfg->baud > UART_MAX_BAUD) {
+        fprintf(stderr, "UART rate %u out of range (max %d)\n", cfg->baud, UART_MAX_BAUD);
+        return -1;
+    }
+    int fd = open_tty(cfg->dev);
+    if (fd < 0) {
+        return -1;
+    }
+
+    // Raw 8N1, every rate through BOTHER
+    if (ioctl(fd, TCGETS2, &tio) == 0) {
+        tio.c_iflag = 0;
+        tio.c_oflag = 0;
+        tio.c_lflag = 0;
+        tio.c_cflag = CS8 | CREAD | CLOCAL;
+        tio.c_cc[VMIN] = 1;
+        tio.c_cc[VTIME] = 0;
+        if (ioctl(fd, TCSETS2, &tio) == 0 && set_termios(fd, cfg, 1) == 0) {
+            if (cfg->low_latency && set_low_latency(fd) != 0) {
+                fprintf(stderr, "UART %s: no low latency mode (%s)\n", cfg->dev, strerror(errno));
+            }
+            return fd;
+        }
+    }
+    fprintf(stderr, "Failed to configure UART %s: %s\n", cfg->dev, strerror(errno));
+    close(fd);
+    return -1;
+}
+
+mraa_uart_context uart_open(const uart_cfg_t *cfg) {
+    int custom_rate = !standard_rate(cfg->baud);
+
+    if (cfg->baud == 0 || cfg->baud > UART_MAX_BAUD) {
+        fprintf(stderr, "UART rate %u out of range (max %d)\n", cfg->baud, UART_MAX_BAUD);
+        return NULL;
+    }
+
+    mraa_uart_context uart = mraa_uart_init_raw(cfg->dev);
+    if (uart == NULL) {
+        fprintf(stderr, "Failed to initialize UART on %s\n", cfg->dev);
+        return NULL;
+    }
+    if ((!custom_rate && mraa_uart_set_baudrate(uart, cfg->baud) != MRAA_SUCCESS) ||
+        mraa_uart_set_mode(uart, 8, MRAA_UART_PARITY_NONE, 1) != MRAA_SUCCESS ||
+        mraa_uart_set_flowcontrol(uart, 0, cfg->rtscts) != MRAA_SUCCESS) {
+        fprintf(stderr, "Failed to configure UART %s\n", cfg->dev);
+        mraa_uart_stop(uart);
+        return NULL;
+    }
+
+    int extras = custom_rate || cfg->vmin >= 0 || cfg->vtime >= 0 || cfg->rtscts;
+    if (!extras && !cfg->low_latency) {
+        return uart;
+    }
+
+    // The path mraa really opened, which is not always cfg->dev (the mock
+    // puts a pty behind a board UART)
+    const char *path = mraa_uart_get_dev_path(uart);
+    int fd = open_tty(path != NULL ? path : cfg->dev);
+    if (extras && (fd < 0 || set_termios(fd, cfg, custom_rate) != 0)) {
+        if (custom_rate) {
+            fprintf(stderr, "UART %s: cannot set %u baud\n", cfg->dev, cfg->baud);
+            if (fd >= 0) {
+                close(fd);
+            }
+            mraa_uart_stop(uart);
+            return NULL;
+        }
+        fprintf(stderr, "UART %s: termios settings not applied\n", cfg->dev);
+    }
+    if (cfg->low_latency && (fd < 0 || set_low_latency(fd) != 0)) {
+        fprintf(stderr, "UART %s: no low latency mode (%s)\n", cfg->dev,
+                fd < 0 ? "device not opened" : strerror(errno));
+    }
+    if (fd >= 0) {
+        close(fd);   // not the last one: the settings stay
+    }
+    return uart;
+}
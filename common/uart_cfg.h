@@ -0,0 +1,53 @@
+#ifndef UART_CFG_H
+#define UART_CFG_H
+
+#include <stdio.h>
+#include <stdbool.h>
+#include <mraa/uart.h>
+
+// UART setup shared by the UART exercises.
+//
+// A program gives its defaults to uart_cfg_init(); the environment can
+// override each of them without a rebuild:
+//
+//   UART_DEV          device, e.g. /dev/ttyS1
+//   UART_BAUD         any rate up to UART_MAX_BAUD; standard rates go
+//                     through mraa, others through the termios2 BOTHER call
+//   UART_VMIN         bytes a read waits for (0-255) ...
+//   UART_VTIME        ... or until the line is idle for this many 0.1 s
+//   UART_LOW_LATENCY  1: ask the serial driver to push every received byte
+//                     to the reader at once (ASYNC_LOW_LATENCY)
+//   UART_RTSCTS       1: RTS/CTS hardware flow control
+//
+// VMIN/VTIME trade latency for fewer, larger reads: VMIN 1 VTIME 0 (the
+// default) returns as soon as a byte is there, VMIN 64 VTIME 1 returns once
+// 64 bytes are in or after a 100 ms gap. The line is always 8N1.
+
+// The SAMA5D2 USARTs divide their 83 MHz peripheral clock by at least 16
+#define UART_MAX_BAUD 5187500
+
+typedef struct {
+    const char *dev;
+    unsigned baud;
+    int vmin, vtime;          // -1 leaves mraa's setting
+    bool low_latency;
+    bool rtscts;
+} uart_cfg_t;
+
+void uart_cfg_init(uart_cfg_t *cfg, const char *dev, unsigned baud);
+
+// Open and configure. Errors are reported on stderr; NULL if the device
+// cannot be opened or the rate or flow control cannot be set. VMIN/VTIME
+// and low latency are best effort: a device without them (a pty has no
+// serial driver) gets a warning.
+mraa_uart_context uart_open(const uart_cfg_t *cfg);
+
+// The same settings on a plain descriptor, opened non-blocking and raw
+// 8N1, for code that waits on it with poll or epoll (uart_link.h). All
+// settings but low latency must take; -1 with the reason on stderr.
+int uart_open_fd(const uart_cfg_t *cfg);
+
+// One line describing the settings
+void uart_cfg_print(const uart_cfg_t *cfg, FILE *out);
+
+#endif
@@ -0,0 +1,386 @@
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/uio.h>
+#include "timing.h"
+#include "uart_link.h"
+
+// Frame layout: SOF len seq type ack data... crc:u16
+#define OFF_ACK 4
+
+// Re-stamp the ack of a queued frame just before it goes out
+static void reseal(proto_tx_t *f, uint8_t ack) {
+    int n = f->frame[1];
+    uint16_t crc;
+
+    f->frame[OFF_ACK] = ack;
+    crc = proto_crc16(f->frame + 1, n + 2);
+    f->frame[3 + n] = crc & 0xFF;
+    f->frame[4 + n] = crc >> 8;
+}
+
+static void kick(uart_link_t *l) {
+    uint64_t one = 1;
+
+    if (write(l->wake, &one, sizeof(one)) < 0) {
+        // the counter is full: the thread is awake anyway
+    }
+}
+
+// An ack for everything up to (not including) seq 'ack'. Lock held.
+static void take_ack(uart_link_t *l, uint8_t ack, uint32_t top) {
+    uint32_t acked = (uint8_t)(ack - (uint8_t)l->base);
+
+    if (acked == 0 || acked > top - l->base) {
+        return;    // old or nonsense
+    }
+    l->base += acked;
+    l->recovering = 0;
+    l->deadline_ns = timing_now_ns() + l->rto_ns;
+    pthread_cond_broadcast(&l->cond);
+}
+
+static void handle_frame(uart_link_t *l, uint32_t *top) {
+    const uint8_t *p = l->rx.payload;
+    int n = l->rx.payload_len;
+
+    if (n < 2 || (p[0] != LINK_DATA && p[0] != LINK_ACK && p[0] != LINK_NAK)) {
+        return;
+    }
+    pthread_mutex_lock(&l->lock);
+    take_ack(l, p[1], *top);
+    if (p[0] == LINK_NAK && p[1] == (uint8_t)l->base && l->base != *top && !l->recovering) {
+        l->resend = 1;
+    }
+    pthread_mutex_unlock(&l->lock);
+
+    if (p[0] == LINK_DATA) {
+        if (l->rx.seq == l->expect) {
+            l->expect++;
+            l->nak_sent = 0;
+            l->rx_frames++;
+            l->rx_bytes += n - 2;
+            if (l->on_rx != NULL) {
+                l->on_rx(l->arg, p + 2, n - 2);
+            }
+        } else {
+            l->out_of_order++;
+            // A seq just behind is a resend of something we have; ahead
+            // means frames were lost
+            if ((uint8_t)(l->rx.seq - l->expect) < 128 && !l->nak_sent) {
+                l->nak_due = 1;
+                l->nak_sent = 1;
+            }
+        }
+        l->ack_due = 1;
+    }
+}
+
+// Returns -1 when the other end is gone (a pty closed, a USB adapter
+// pulled): the link stops
+static int rx_ready(uart_link_t *l, uint32_t *top) {
+    uint8_t buf[4096];
+    ssize_t n = read(l->fd, buf, sizeof(buf));
+
+    if (n == 0 || (n < 0 && errno != EAGAIN && errno != EINTR)) {
+        fprintf(stderr, "UART link: hangup\n");
+        return -1;
+    }
+    for (ssize_t i = 0; i < n; i++) {
+        for (int got = proto_rx_push(&l->rx, buf[i]); got; got = proto_rx_next(&l->rx)) {
+            handle_frame(l, top);
+        }
+    }
+    return 0;
+}
+
+// The next frame to write from 'i' on: frames acked while waiting to be
+// resent are skipped, but not one that is half written, whose rest the
+// peer's framing is waiting for. Lock held.
+static uint32_t next_frame(const uart_link_t *l, uint32_t i) {
+    if ((i != l->sent || l->off == 0) && (int32_t)(l->base - i) > 0) {
+        return l->base;
+    }
+    return i;
+}
+
+// Write what the window allows in one writev(). Lock held. Returns 1 when
+// the descriptor is full and more is waiting.
+static int tx(uart_link_t *l, uint32_t *top) {
+    struct iovec iov[LINK_WINDOW + 1];
+    size_t want = 0;
+    int cnt = 0, acked = 0;     // carries the current ack
+
+    l->sent = next_frame(l, l->sent);
+    int data = l->off > 0 || (l->sent != l->head && l->sent - l->base < LINK_WINDOW);
+
+    // A pure ack or NAK goes out between frames, never inside the rest of
+    // one cut short by the last write
+    if (l->ack_off < 0 && l->off == 0 && (l->nak_due || (l->ack_due && !data))) {
+        uint8_t hdr[2] = {l->nak_due ? LINK_NAK : LINK_ACK, l->expect};
+        proto_begin(&l->ack_frame, 0);
+        proto_payload(&l->ack_frame, hdr, sizeof(hdr));
+        proto_end(&l->ack_frame);
+        if (l->nak_due) {
+            l->naks++;
+        }
+        l->ack_off = 0;
+        l->nak_due = 0;
+        acked = 1;
+    }
+    if (l->ack_off >= 0) {
+        iov[cnt].iov_base = l->ack_frame.frame + l->ack_off;
+        iov[cnt].iov_len = l->ack_frame.len - l->ack_off;
+        want += iov[cnt++].iov_len;
+    }
+    for (uint32_t i = l->sent; i != l->head; i = next_frame(l, i + 1)) {
+        proto_tx_t *f = &l->frames[i % LINK_QUEUE];
+        int from = i == l->sent ? l->off : 0;
+        if (from == 0 && i - l->base >= LINK_WINDOW) {
+            break;
+        }
+        if (from == 0) {
+            reseal(f, l->expect);
+            acked = 1;
+        }
+        iov[cnt].iov_base = f->frame + from;
+        iov[cnt].iov_len = f->len - from;
+        want += iov[cnt++].iov_len;
+    }
+    if (cnt == 0) {
+        return 0;
+    }
+    if (acked) {
+        l->ack_due = 0;
+    }
+
+    ssize_t n = writev(l->fd, iov, cnt);
+    l->writes++;
+    if (n < 0) {
+        if (errno != EAGAIN && errno != EINTR) {
+            fprintf(stderr, "UART link: write failed: %s\n", strerror(errno));
+        }
+        return 1;
+    }
+    if ((size_t)n < want) {
+        l->short_writes++;
+    }
+
+    // Account for what went out, possibly ending inside a frame
+    if (l->ack_off >= 0) {
+        ssize_t take = l->ack_frame.len - l->ack_off;
+        if (n < take) {
+            l->ack_off += n;
+            return 1;
+        }
+        n -= take;
+        l->ack_off = -1;
+    }
+    while (n > 0) {
+        l->sent = next_frame(l, l->sent);     // the same walk as above
+        proto_tx_t *f = &l->frames[l->sent % LINK_QUEUE];
+        ssize_t rest = f->len - l->off;
+        if (n < rest) {
+            l->off += n;
+            return 1;
+        }
+        n -= rest;
+        l->off = 0;
+        if (l->sent == l->base) {
+            l->deadline_ns = timing_now_ns() + l->rto_ns;   // first in flight
+        }
+        if (l->sent == *top) {
+            (*top)++;
+            l->tx_frames++;
+            l->tx_bytes += f->len - 7;
+        } else {
+            l->retransmits++;
+        }
+        l->sent++;
+    }
+    return 0;
+}
+
+static void *link_thread(void *arg) {
+    uart_link_t *l = arg;
+    struct epoll_event ev[4];
+    uint32_t top = 0;            // frames ever sent, first time
+    int want_out = 0;
+
+    while (1) {
+        int timeout = -1;
+
+        pthread_mutex_lock(&l->lock);
+        if (l->stopping) {
+            pthread_mutex_unlock(&l->lock);
+            break;
+        }
+        // Only a whole frame in flight has a retransmit timeout; one that is
+        // half written waits for the descriptor (EPOLLOUT) instead
+        if (l->off == 0 && (int32_t)(l->sent - l->base) > 0) {
+            uint64_t now = timing_now_ns();
+            timeout = l->deadline_ns > now ? (int)((l->deadline_ns - now) / TIMING_MS) + 1 : 0;
+        }
+        pthread_mutex_unlock(&l->lock);
+
+        int n = epoll_wait(l->epfd, ev, 4, timeout);
+        for (int i = 0; i < n; i++) {
+            if (ev[i].data.fd == l->wake) {
+                uint64_t v;
+                if (read(l->wake, &v, sizeof(v)) < 0) {
+                    // nothing to drain
+                }
+            } else if ((ev[i].events & (EPOLLIN | EPOLLERR | EPOLLHUP)) && rx_ready(l, &top) != 0) {
+                pthread_mutex_lock(&l->lock);
+                l->stopping = 1;
+                pthread_cond_broadcast(&l->cond);
+                pthread_mutex_unlock(&l->lock);
+            }
+        }
+
+        pthread_mutex_lock(&l->lock);
+        if (l->off == 0 && (int32_t)(l->sent - l->base) > 0 && (l->resend || timing_now_ns() >= l->deadline_ns)) {
+            if (!l->resend) {
+                l->timeouts++;
+            }
+            l->sent = l->base;   // go back N
+            l->recovering = l->resend;
+            l->deadline_ns = timing_now_ns() + l->rto_ns;
+        }
+        if (l->off == 0) {
+            l->resend = 0;
+        }
+        int full = tx(l, &top);
+        pthread_mutex_unlock(&l->lock);
+
+        if (full != want_out) {
+            struct epoll_event e = {EPOLLIN | (full ? EPOLLOUT : 0), {.fd = l->fd}};
+            epoll_ctl(l->epfd, EPOLL_CTL_MOD, l->fd, &e);
+            want_out = full;
+        }
+    }
+    return NULL;
+}
+
+static int start_fail(uart_link_t *l, const char *what) {
+    fprintf(stderr, "UART link: %s: %s\n", what, strerror(errno));
+    if (l->wake >= 0) {
+        close(l->wake);
+    }
+    if (l->epfd >= 0) {
+        close(l->epfd);
+    }
+    close(l->fd);
+    return -1;
+}
+
+int uart_link_start(uart_link_t *l, int fd, unsigned baud, link_rx_fn on_rx, void *arg) {
+    pthread_condattr_t ca;
+
+    memset(l, 0, sizeof(*l));
+    l->fd = fd;
+    l->on_rx = on_rx;
+    l->arg = arg;
+    l->ack_off = -1;
+    proto_rx_init(&l->rx);
+
+    // Twice a full window at the line rate, plus scheduling slack
+    l->rto_ns = 2ULL * LINK_WINDOW * PROTO_MAX_FRAME * 10 * TIMING_S / (baud ? baud : 115200) + 20 * TIMING_MS;
+
+    l->wake = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    l->epfd = epoll_create1(EPOLL_CLOEXEC);
+    if (l->wake < 0 || l->epfd < 0) {
+        return start_fail(l, "cannot create the event loop");
+    }
+    struct epoll_event e = {EPOLLIN, {.fd = fd}};
+    struct epoll_event w = {EPOLLIN, {.fd = l->wake}};
+    if (epoll_ctl(l->epfd, EPOLL_CTL_ADD, fd, &e) != 0 ||
+        epoll_ctl(l->epfd, EPOLL_CTL_ADD, l->wake, &w) != 0) {
+        return start_fail(l, "cannot wait on the UART");
+    }
+
+    pthread_mutex_init(&l->lock, NULL);
+    pthread_condattr_init(&ca);
+    pthread_condattr_setclock(&ca, CLOCK_MONOTONIC);
+    pthread_cond_init(&l->cond, &ca);
+    pthread_condattr_destroy(&ca);
+    if (pthread_create(&l->thread, NULL, link_thread, l) != 0) {
+        pthread_cond_destroy(&l->cond);
+        pthread_mutex_destroy(&l->lock);
+        return start_fail(l, "cannot start the thread");
+    }
+    return 0;
+}
+
+int uart_link_send(uart_link_t *l, const void *data, int len) {
+    const uint8_t *p = data;
+    int left = len;
+
+    pthread_mutex_lock(&l->lock);
+    while (left > 0) {
+        while (!l->stopping && l->head - l->base >= LINK_QUEUE) {
+            kick(l);
+            pthread_cond_wait(&l->cond, &l->lock);
+        }
+        if (l->stopping) {
+            pthread_mutex_unlock(&l->lock);
+            return -1;
+        }
+
+        int n = left > LINK_MTU ? LINK_MTU : left;
+        uint8_t hdr[2] = {LINK_DATA, 0};   // the ack is filled in when sent
+        proto_tx_t *f = &l->frames[l->head % LINK_QUEUE];
+        proto_begin(f, (uint8_t)l->head);
+        proto_payload(f, hdr, sizeof(hdr));
+        proto_payload(f, p, n);
+        proto_end(f);
+        l->head++;
+        p += n;
+        left -= n;
+    }
+    pthread_mutex_unlock(&l->lock);
+    kick(l);
+    return len;
+}
+
+int uart_link_flush(uart_link_t *l, int timeout_ms) {
+    struct timespec ts;
+    int ret;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    ts.tv_sec += timeout_ms / 1000;
+    ts.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+    if (ts.tv_nsec >= 1000000000L) {
+        ts.tv_sec++;
+        ts.tv_nsec -= 1000000000L;
+    }
+
+    pthread_mutex_lock(&l->lock);
+    while (!l->stopping && l->base != l->head) {
+        if (pthread_cond_timedwait(&l->cond, &l->lock, &ts) != 0) {
+            break;
+        }
+    }
+    ret = l->base == l->head ? 0 : -1;
+    pthread_mutex_unlock(&l->lock);
+    return ret;
+}
+
+void uart_link_stop(uart_link_t *l) {
+    pthread_mutex_lock(&l->lock);
+    l->stopping = 1;
+    pthread_cond_broadcast(&l->cond);
+    pthread_mutex_unlock(&l->lock);
+    kick(l);
+    pthread_join(l->thread, NULL);
+
+    close(l->epfd);
+    close(l->wake);
+    close(l->fd);
+    pthread_cond_destroy(&l->cond);
+    pthread_mutex_destroy(&l->lock);
+}
@@ -0,0 +1,82 @@
+#ifndef UART_LINK_H
+#define UART_LINK_H
+
+#include <stdint.h>
+#include <pthread.h>
+#include "uart_proto.h"
+
+// Reliable full-duplex byte stream between two boards over a UART.
+//
+// One thread per link runs an epoll loop on the (non-blocking) descriptor:
+// it reads whatever has arrived, hands complete frames to the receive
+// callback, and writes queued frames with one writev() for as many as the
+// window allows. Sending and receiving never wait for each other.
+//
+// Data travels in uart_proto.h frames whose seq numbers them and whose
+// payload is
+//
+//     LINK_DATA ack:u8 data[]      LINK_ACK ack:u8      LINK_NAK ack:u8
+//
+// where ack is the seq the sender expects next from its peer: every frame
+// acknowledges everything received before it, and a pure ack goes out only
+// when there is no data to carry it. Up to LINK_WINDOW frames are in
+// flight and are sent again from the oldest unacked one (go-back-N) when
+// the peer reports a gap with a NAK, or when no ack came within the
+// retransmit timeout. Frames with a bad CRC are dropped by the framing,
+// frames after the gap are dropped too; duplicates are only acked.
+
+#define LINK_DATA   0x40
+#define LINK_ACK    0x41
+#define LINK_NAK    0x42
+#define LINK_MTU    (PROTO_MAX_PAYLOAD - 2)   // data bytes per frame
+#define LINK_WINDOW 16                        // frames in flight, < 128
+#define LINK_QUEUE  64                        // frames queued, power of two
+
+// Called from the link thread with the data of each frame, in order
+typedef void (*link_rx_fn)(void *arg, const uint8_t *data, int len);
+
+typedef struct {
+    int fd, epfd, wake;
+    pthread_t thread;
+    pthread_mutex_t lock;
+    pthread_cond_t cond;
+    int stopping;
+
+    // Frames base..sent-1 are in flight, sent..head-1 wait for the window
+    proto_tx_t frames[LINK_QUEUE];
+    uint32_t base, sent, head;
+    int off;                   // bytes of frames[sent] already written
+    proto_tx_t ack_frame;
+    int ack_off;               // -1: no pure ack pending
+    uint64_t rto_ns, deadline_ns;
+    int resend;                // a NAK asks to go back
+    int recovering;            // went back, NAKs ignored until an ack
+
+    proto_rx_t rx;
+    uint8_t expect;            // seq of the next frame to deliver
+    int ack_due;
+    int nak_due, nak_sent;     // one NAK per gap
+    link_rx_fn on_rx;
+    void *arg;
+
+    unsigned long tx_frames, tx_bytes, rx_frames, rx_bytes;
+    unsigned long retransmits, out_of_order, writes;
+    unsigned long short_writes, naks, timeouts;  // writev() cut short, NAKs sent, go-backs on timeout
+} uart_link_t;
+
+// Run a link on 'fd' (see uart_open_fd()); 'baud' sets the retransmit
+// timeout. The link owns the descriptor from now on, and closes it if
+// it cannot start.
+int uart_link_start(uart_link_t *l, int fd, unsigned baud, link_rx_fn on_rx, void *arg);
+
+// Queue 'len' bytes, split into frames. Waits while the queue is full.
+// Returns len, or -1 once the link is stopping.
+int uart_link_send(uart_link_t *l, const void *data, int len);
+
+// Wait until everything queued is acked, at most timeout_ms; 0 when it is
+int uart_link_flush(uart_link_t *l, int timeout_ms);
+
+// Stops the thread and closes the descriptor; unacked data is lost
+void uart_link_stop(uart_link_t *l);
+
+#endif
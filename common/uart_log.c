@@ -0,0 +1,171 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "timing.h"
+#include "uart_log.h"
+
+#define REC_ALIGN(n) (((n) + 7) & ~(size_t)7)
+
+static int log_fail(uart_log_t *log, const char *what, const char *path) {
+    fprintf(stderr, "UART log %s: %s: %s\n", path, what, strerror(errno));
+    if (log->map != NULL && log->map != MAP_FAILED) {
+        munmap(log->map, log->size);
+    }
+    if (log->fd >= 0) {
+        close(log->fd);
+    }
+    memset(log, 0, sizeof(*log));
+    log->fd = -1;
+    return -1;
+}
+
+int uart_log_create(uart_log_t *log, const char *path) {
+    struct timespec now;
+
+    memset(log, 0, sizeof(*log));
+    log->writable = 1;
+    log->size = UART_LOG_CHUNK;
+    log->fd = open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (log->fd < 0) {
+        return log_fail(log, "cannot create", path);
+    }
+    if (ftruncate(log->fd, log->size) != 0) {
+        return log_fail(log, "cannot size", path);
+    }
+    log->map = mmap(NULL, log->size, PROT_READ | PROT_WRITE, MAP_SHARED, log->fd, 0);
+    if (log->map == MAP_FAILED) {
+        return log_fail(log, "cannot map", path);
+    }
+
+    log->hdr = (uart_log_header_t *)log->map;
+    memcpy(log->hdr->magic, UART_LOG_MAGIC, sizeof(log->hdr->magic));
+    clock_gettime(CLOCK_REALTIME, &now);
+    log->hdr->start_ns = (uint64_t)now.tv_sec * TIMING_S + now.tv_nsec;
+    log->t0_ns = timing_now_ns();
+    return 0;
+}
+
+// Make room for 'need' more bytes: grow the file, then the mapping
+static int grow(uart_log_t *log, size_t need) {
+    size_t size = log->size;
+
+    while (size < sizeof(uart_log_header_t) + log->hdr->used + need) {
+        size += UART_LOG_CHUNK;
+    }
+    if (ftruncate(log->fd, size) != 0) {
+        return -1;
+    }
+    void *map = mremap(log->map, log->size, size, MREMAP_MAYMOVE);
+    if (map == MAP_FAILED) {
+        return -1;
+    }
+    log->map = map;
+    log->hdr = map;
+    log->size = size;
+    return 0;
+}
+
+int uart_log_append(uart_log_t *log, const void *data, uint32_t len) {
+    size_t need = REC_ALIGN(sizeof(uart_log_rec_t) + len);
+    uint64_t t = timing_now_ns() - log->t0_ns;
+
+    if (sizeof(uart_log_header_t) + log->hdr->used + need > log->size && grow(log, need) != 0) {
+        return -1;
+    }
+
+    uart_log_rec_t *rec = (uart_log_rec_t *)(log->map + sizeof(uart_log_header_t) + log->hdr->used);
+    rec->t_ns = t;
+    rec->len = len;
+    rec->flags = 0;
+    memcpy(rec->data, data, len);
+
+    // The record is complete before 'used' covers it
+    log->hdr->records++;
+    __atomic_store_n(&log->hdr->used, log->hdr->used + need, __ATOMIC_RELEASE);
+    return 0;
+}
+
+int uart_log_open(uart_log_t *log, const char *path) {
+    struct stat st;
+
+    memset(log, 0, sizeof(*log));
+    log->fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (log->fd < 0) {
+        return log_fail(log, "cannot open", path);
+    }
+    if (fstat(log->fd, &st) != 0) {
+        return log_fail(log, "cannot stat", path);
+    }
+    if ((size_t)st.st_size < sizeof(uart_log_header_t)) {
+        errno = EINVAL;
+        return log_fail(log, "not a capture", path);
+    }
+    log->size = st.st_size;
+    log->map = mmap(NULL, log->size, PROT_READ, MAP_SHARED, log->fd, 0);
+    if (log->map == MAP_FAILED) {
+        return log_fail(log, "cannot map", path);
+    }
+    log->hdr = (uart_log_header_t *)log->map;
+    if (memcmp(log->hdr->magic, UART_LOG_MAGIC, sizeof(log->hdr->magic)) != 0 ||
+        sizeof(uart_log_header_t) + log->hdr->used > log->size) {
+        errno = EINVAL;
+        return log_fail(log, "not a capture", path);
+    }
+    return 0;
+}
+
+const uart_log_rec_t *uart_log_next(uart_log_t *log) {
+    uint64_t used = __atomic_load_n(&log->hdr->used, __ATOMIC_ACQUIRE);
+
+    if (log->pos + sizeof(uart_log_rec_t) > used) {
+        return NULL;
+    }
+    const uart_log_rec_t *rec = (const uart_log_rec_t *)(log->map + sizeof(uart_log_header_t) + log->pos);
+    size_t len = REC_ALIGN(sizeof(uart_log_rec_t) + rec->len);
+    if (log->pos + len > used) {
+        return NULL;   // a damaged record ends the capture
+    }
+    log->pos += len;
+    return rec;
+}
+
+void uart_log_rewind(uart_log_t *log) {
+    log->pos = 0;
+}
+
+void uart_log_totals(const uart_log_t *log, uint64_t *bytes, uint64_t *span_ns) {
+    uart_log_t it = *log;
+    const uart_log_rec_t *rec;
+
+    *bytes = 0;
+    *span_ns = 0;
+    it.pos = 0;
+    while ((rec = uart_log_next(&it)) != NULL) {
+        *bytes += rec->len;
+        *span_ns = rec->t_ns;
+    }
+}
+
+void uart_log_close(uart_log_t *log) {
+    size_t end = sizeof(uart_log_header_t);
+
+    if (log->map == NULL) {
+        return;
+    }
+    if (log->writable) {
+        end += log->hdr->used;
+    }
+    munmap(log->map, log->size);
+    if (log->writable && ftruncate(log->fd, end) != 0) {
+        fprintf(stderr, "UART log: cannot trim: %s\n", strerror(errno));
+    }
+    close(log->fd);
+    memset(log, 0, sizeof(*log));
+    log->fd = -1;
+}
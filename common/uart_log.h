@@ -0,0 +1,70 @@
+#ifndef UART_LOG_H
+#define UART_LOG_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Timestamped capture of UART traffic, as a memory-mapped append log.
+//
+// Each read from the UART becomes one record: the time since the capture
+// started, the length and the bytes, padded to 8. Appending is a copy into
+// the mapping, no syscall; the file grows by UART_LOG_CHUNK at a time and
+// is cut to its contents on close. The header's 'used' is updated after
+// each record, so a capture that is killed instead of closed is still
+// readable up to its last record.
+//
+//     "UARTLOG1"  start_ns:u64  used:u64  records:u64   then records:
+//     t_ns:u64  len:u32  flags:u32  data[len]  pad to 8
+//
+// Values are in the byte order of the machine (little endian on the board
+// and on x86 hosts). 03_LCD_UART/08_uart_RX records to UART_CAPTURE=file,
+// 03_LCD_UART/uart_replay plays a file back through a pty.
+
+#define UART_LOG_MAGIC "UARTLOG1"
+#define UART_LOG_CHUNK (1 << 20)
+
+typedef struct {
+    char magic[8];
+    uint64_t start_ns;         // CLOCK_REALTIME when the capture started
+    uint64_t used;             // bytes of records after the header
+    uint64_t records;
+} uart_log_header_t;
+
+typedef struct {
+    uint64_t t_ns;             // since the start of the capture
+    uint32_t len;
+    uint32_t flags;            // 0, reserved
+    uint8_t data[];
+} uart_log_rec_t;
+
+typedef struct {
+    int fd;
+    int writable;
+    uint8_t *map;
+    size_t size;               // of the mapping (and the file)
+    uart_log_header_t *hdr;
+    uint64_t t0_ns;            // timing_now_ns() at the start
+    size_t pos;                // reader: offset of the next record
+} uart_log_t;
+
+// Create (or truncate) a capture. Returns 0, or -1 with the reason on stderr.
+int uart_log_create(uart_log_t *log, const char *path);
+
+// Record 'len' bytes received now
+int uart_log_append(uart_log_t *log, const void *data, uint32_t len);
+
+// Open a capture for reading
+int uart_log_open(uart_log_t *log, const char *path);
+
+// The next record, NULL at the end
+const uart_log_rec_t *uart_log_next(uart_log_t *log);
+
+// Back to the first record
+void uart_log_rewind(uart_log_t *log);
+
+// Bytes of UART data in the whole capture, and the time of its last record
+void uart_log_totals(const uart_log_t *log, uint64_t *bytes, uint64_t *span_ns);
+
+void uart_log_close(uart_log_t *log);
+
+#endif
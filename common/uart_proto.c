@@ -0,0 +1,239 @@
+#include <string.h>
+#include "uart_proto.h"
+
+#define HEADER 3               // SOF, len, seq
+
+uint16_t proto_crc16(const uint8_t *data, int len) {
+    uint16_t crc = 0xFFFF;
+
+    for (int i = 0; i < len; i++) {
+        crc ^= (uint16_t)data[i] << 8;
+        for (int b = 0; b < 8; b++) {
+            crc = (crc & 0x8000) ? (crc << 1) ^ 0x1021 : crc << 1;
+        }
+    }
+    return crc;
+}
+
+static uint32_t get32(const uint8_t *p) {
+    return p[0] | (uint32_t)p[1] << 8 | (uint32_t)p[2] << 16 | (uint32_t)p[3] << 24;
+}
+
+// ---- receiver ----
+
+void proto_rx_init(proto_rx_t *rx) {
+    memset(rx, 0, sizeof(*rx));
+}
+
+int proto_rx_busy(const proto_rx_t *rx) {
+    return rx->len > rx->done;
+}
+
+// Drop the first byte of the buffer and start over at the next SOF in it
+static void resync(proto_rx_t *rx) {
+    int i;
+
+    for (i = 1; i < rx->len && rx->buf[i] != PROTO_SOF; i++) {
+    }
+    rx->skipped += i;
+    memmove(rx->buf, rx->buf + i, rx->len - i);
+    rx->len -= i;
+}
+
+// Let go of the frame handed out last time, keeping what came after it
+static void release(proto_rx_t *rx) {
+    if (rx->done > 0) {
+        memmove(rx->buf, rx->buf + rx->done, rx->len - rx->done);
+        rx->len -= rx->done;
+        rx->done = 0;
+    }
+}
+
+// Hand out the first whole frame in the buffer, if there is one
+static int scan(proto_rx_t *rx) {
+    // The bytes kept after a frame or a resync may already hold a whole one
+    while (rx->len >= HEADER + 2 && rx->len >= HEADER + rx->buf[1] + 2) {
+        int n = rx->buf[1];
+        uint16_t crc = rx->buf[HEADER + n] | rx->buf[HEADER + n + 1] << 8;
+
+        if (proto_crc16(rx->buf + 1, n + 2) == crc) {
+            rx->seq = rx->buf[2];
+            rx->payload = rx->buf + HEADER;
+            rx->payload_len = n;
+            rx->done = HEADER + n + 2;
+            rx->frames++;
+            return 1;
+        }
+        rx->bad_crc++;
+        resync(rx);
+    }
+    return 0;
+}
+
+int proto_rx_push(proto_rx_t *rx, uint8_t byte) {
+    release(rx);
+    if (rx->len == 0 && byte != PROTO_SOF) {
+        rx->skipped++;
+        return 0;
+    }
+    rx->buf[rx->len++] = byte;
+    return scan(rx);
+}
+
+int proto_rx_next(proto_rx_t *rx) {
+    release(rx);
+    return scan(rx);
+}
+
+int proto_parse(const uint8_t *p, int len, proto_cmd_t *cmds, int max, int *bad) {
+    int count = 0, pos = 0;
+
+    while (pos < len) {
+        proto_cmd_t *c = &cmds[count];
+        int need;
+
+        *bad = count;
+        if (count == max) {
+            return -PROTO_ERR_BUSY;
+        }
+        memset(c, 0, sizeof(*c));
+        c->op = p[pos];
+
+        switch (c->op) {
+        case PROTO_SET:    need = 9; break;
+        case PROTO_TOGGLE: need = 5; break;
+        case PROTO_PWM:    need = 4; break;
+        case PROTO_LCD:    need = pos + 4 <= len ? 4 + p[pos + 3] : 4; break;
+        case PROTO_CLEAR:
+        case PROTO_QUERY:  need = 1; break;
+        default:
+            return -PROTO_ERR_OP;
+        }
+        if (pos + need > len) {
+            return -PROTO_ERR_SHORT;
+        }
+
+        const uint8_t *a = p + pos + 1;
+        switch (c->op) {
+        case PROTO_SET:
+            c->mask = get32(a);
+            c->levels = get32(a + 4);
+            break;
+        case PROTO_TOGGLE:
+            c->mask = get32(a);
+            break;
+        case PROTO_PWM:
+            c->channel = a[0];
+            c->permille = a[1] | a[2] << 8;
+            if (c->permille > 1000) {
+                return -PROTO_ERR_ARG;
+            }
+            break;
+        case PROTO_LCD:
+            c->row = a[0];
+            c->col = a[1];
+            c->n = a[2];
+            c->text = (const char *)a + 3;
+            break;
+        }
+        pos += need;
+        count++;
+    }
+    return count;
+}
+
+// ---- sender ----
+
+static void put(proto_tx_t *tx, const void *data, int n) {
+    if (tx->len + n > HEADER + PROTO_MAX_PAYLOAD) {
+        tx->overflow = 1;
+        return;
+    }
+    memcpy(tx->frame + tx->len, data, n);
+    tx->len += n;
+}
+
+static void put8(proto_tx_t *tx, uint8_t v) {
+    put(tx, &v, 1);
+}
+
+static void put32(proto_tx_t *tx, uint32_t v) {
+    uint8_t b[4] = {v, v >> 8, v >> 16, v >> 24};
+    put(tx, b, 4);
+}
+
+void proto_begin(proto_tx_t *tx, uint8_t seq) {
+    tx->frame[0] = PROTO_SOF;
+    tx->frame[1] = 0;
+    tx->frame[2] = seq;
+    tx->len = HEADER;
+    tx->overflow = 0;
+}
+
+void proto_set(proto_tx_t *tx, uint32_t mask, uint32_t levels) {
+    put8(tx, PROTO_SET);
+    put32(tx, mask);
+    put32(tx, levels);
+}
+
+void proto_toggle(proto_tx_t *tx, uint32_t mask) {
+    put8(tx, PROTO_TOGGLE);
+    put32(tx, mask);
+}
+
+void proto_pwm(proto_tx_t *tx, int channel, int permille) {
+    uint8_t b[4] = {PROTO_PWM, channel, permille, permille >> 8};
+    put(tx, b, 4);
+}
+
+void proto_lcd(proto_tx_t *tx, int row, int col, const char *text) {
+    int n = strlen(text);
+    uint8_t b[4] = {PROTO_LCD, row, col, n > 255 ? 255 : n};
+
+    put(tx, b, 4);
+    put(tx, text, b[3]);
+}
+
+void proto_clear(proto_tx_t *tx) {
+    put8(tx, PROTO_CLEAR);
+}
+
+void proto_query(proto_tx_t *tx) {
+    put8(tx, PROTO_QUERY);
+}
+
+void proto_payload(proto_tx_t *tx, const void *data, int n) {
+    put(tx, data, n);
+}
+
+int proto_end(proto_tx_t *tx) {
+    if (tx->overflow) {
+        return -1;
+    }
+    int n = tx->len - HEADER;
+    tx->frame[1] = n;
+
+    uint16_t crc = proto_crc16(tx->frame + 1, n + 2);
+    tx->frame[tx->len++] = crc & 0xFF;
+    tx->frame[tx->len++] = crc >> 8;
+    return tx->len;
+}
+
+int proto_ack(proto_tx_t *tx, uint8_t seq, proto_status_t status, int index, uint32_t outputs) {
+    proto_begin(tx, seq);
+    put8(tx, PROTO_ACK);
+    put8(tx, status);
+    put8(tx, index);
+    put32(tx, outputs);
+    return proto_end(tx);
+}
+
+int proto_parse_ack(const uint8_t *p, int len, proto_status_t *status, int *index, uint32_t *outputs) {
+    if (len != 7 || p[0] != PROTO_ACK) {
+        return -1;
+    }
+    *status = p[1];
+    *index = p[2];
+    *outputs = get32(p + 3);
+    return 0;
+}
@@ -0,0 +1,118 @@
+#ifndef UART_PROTO_H
+#define UART_PROTO_H
+
+#include <stdint.h>
+
+// Binary command frames for driving a panel of outputs over a UART.
+//
+// A frame carries a batch of commands; the receiver checks all of them
+// before applying any, then answers with a single ack frame, so a whole
+// panel changes in one round trip:
+//
+//     0xA5  len  seq  payload[len]  crc:u16
+//
+// len counts the payload only, crc is CRC-16/CCITT (0x1021, start 0xFFFF)
+// over len, seq and the payload, and values are little endian. A frame
+// whose CRC does not match is dropped without an ack and the receiver
+// looks for the next 0xA5 after its start. The payload is a list of:
+//
+//     PROTO_SET     mask:u32 levels:u32     set the masked outputs
+//     PROTO_TOGGLE  mask:u32                invert the masked outputs
+//     PROTO_PWM     channel:u8 permille:u16
+//     PROTO_LCD     row:u8 col:u8 n:u8 text[n]
+//     PROTO_CLEAR                           blank the LCD
+//     PROTO_QUERY                           nothing, the ack says it all
+//
+// The ack has the same seq and the payload PROTO_ACK status:u8 index:u8
+// outputs:u32, where index is the first command that failed and outputs
+// the levels after the batch.
+
+#define PROTO_SOF         0xA5
+#define PROTO_MAX_PAYLOAD 255
+#define PROTO_MAX_FRAME   (PROTO_MAX_PAYLOAD + 5)
+#define PROTO_MAX_CMDS    64
+#define PROTO_MAX_OUTPUTS 32
+
+typedef enum {
+    PROTO_SET = 0x01,
+    PROTO_TOGGLE,
+    PROTO_PWM,
+    PROTO_LCD,
+    PROTO_CLEAR,
+    PROTO_QUERY,
+    PROTO_ACK = 0x80
+} proto_op_t;
+
+typedef enum {
+    PROTO_OK = 0,
+    PROTO_ERR_OP,          // unknown command
+    PROTO_ERR_SHORT,       // command cut off by the end of the payload
+    PROTO_ERR_ARG,         // no such output, channel or LCD cell
+    PROTO_ERR_BUSY         // too many commands, or the device failed
+} proto_status_t;
+
+typedef struct {
+    uint8_t op;
+    uint8_t channel, row, col, n;
+    uint16_t permille;
+    uint32_t mask, levels;
+    const char *text;      // PROTO_LCD: points into the payload
+} proto_cmd_t;
+
+// Receiver: bytes in, whole checked frames out
+typedef struct {
+    uint8_t buf[PROTO_MAX_FRAME];
+    int len;
+    int done;              // length of the frame handed out, still in buf
+    uint8_t seq;
+    const uint8_t *payload;
+    int payload_len;
+    unsigned long frames, bad_crc, skipped;
+} proto_rx_t;
+
+// Sender side: a frame being built
+typedef struct {
+    uint8_t frame[PROTO_MAX_FRAME];
+    int len;
+    int overflow;
+} proto_tx_t;
+
+uint16_t proto_crc16(const uint8_t *data, int len);
+
+void proto_rx_init(proto_rx_t *rx);
+
+// Feed one received byte. Returns 1 when it completes a frame with a good
+// CRC, which is then in rx->seq/payload/payload_len until the next call.
+// Bytes outside any frame are counted in rx->skipped.
+int proto_rx_push(proto_rx_t *rx, uint8_t byte);
+
+// The next frame already in the buffer, without a new byte: after a bad
+// CRC the bytes kept may hold one or more whole frames. Call it after each
+// frame from proto_rx_push() until it returns 0.
+int proto_rx_next(proto_rx_t *rx);
+
+// 1 while the receiver is inside a frame
+int proto_rx_busy(const proto_rx_t *rx);
+
+// Split a payload into cmds[]. Returns the number of commands, or
+// -(proto_status_t) with *bad set to the index of the offending command.
+int proto_parse(const uint8_t *payload, int len, proto_cmd_t *cmds, int max, int *bad);
+
+// Build a frame: begin, add commands, end. proto_end() returns the frame
+// length to send, or -1 if the commands did not fit in one frame.
+void proto_begin(proto_tx_t *tx, uint8_t seq);
+void proto_set(proto_tx_t *tx, uint32_t mask, uint32_t levels);
+void proto_toggle(proto_tx_t *tx, uint32_t mask);
+void proto_pwm(proto_tx_t *tx, int channel, int permille);
+void proto_lcd(proto_tx_t *tx, int row, int col, const char *text);
+void proto_clear(proto_tx_t *tx);
+void proto_query(proto_tx_t *tx);
+// Raw bytes, for other payloads carried in the same frames (uart_link.h)
+void proto_payload(proto_tx_t *tx, const void *data, int n);
+int proto_end(proto_tx_t *tx);
+
+// The ack frame, and reading one back
+int proto_ack(proto_tx_t *tx, uint8_t seq, proto_status_t status, int index, uint32_t outputs);
+int proto_parse_ack(const uint8_t *payload, int len, proto_status_t *status, int *index, uint32_t *outputs);
+
+#endif
@@ -0,0 +1,241 @@
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "timing.h"
+#include "uart_sink.h"
+
+#define SINK_CHUNK (64 * 1024)
+
+static long env_long(const char *name, long def) {
+    const char *v = getenv(name);
+    return (v != NULL && *v != '\0') ? atol(v) : def;
+}
+
+void uart_sink_cfg_init(uart_sink_cfg_t *cfg, const char *path) {
+    const char *sock = getenv("UART_SINK_SOCKET");
+
+    cfg->path = path;
+    cfg->rotate_bytes = env_long("UART_SINK_ROTATE", 16L << 20);
+    cfg->keep = env_long("UART_SINK_KEEP", 4);
+    cfg->socket_path = (sock != NULL && *sock != '\0') ? sock : NULL;
+    cfg->batch_ms = env_long("UART_SINK_BATCH_MS", 10);
+    cfg->copy = env_long("UART_SINK_COPY", 0) != 0;
+}
+
+static int open_file(uart_sink_t *s) {
+    // Not O_APPEND: splice() refuses append-only files
+    s->out = open(s->cfg.path, O_WRONLY | O_CREAT | O_CLOEXEC, 0644);
+    if (s->out < 0) {
+        fprintf(stderr, "UART sink: cannot open %s: %s\n", s->cfg.path, strerror(errno));
+        return -1;
+    }
+    off_t end = lseek(s->out, 0, SEEK_END);
+    s->file_bytes = end > 0 ? end : 0;
+    return 0;
+}
+
+static int rotate(uart_sink_t *s) {
+    char from[512], to[512];
+
+    close(s->out);
+    for (int i = s->cfg.keep; i > 1; i--) {
+        snprintf(from, sizeof(from), "%s.%d", s->cfg.path, i - 1);
+        snprintf(to, sizeof(to), "%s.%d", s->cfg.path, i);
+        rename(from, to);
+    }
+    if (s->cfg.keep > 0) {
+        snprintf(to, sizeof(to), "%s.1", s->cfg.path);
+        rename(s->cfg.path, to);
+    } else {
+        unlink(s->cfg.path);
+    }
+    s->rotations++;
+    return open_file(s);
+}
+
+static void drop_socket(uart_sink_t *s) {
+    close(s->sock);
+    s->sock = -1;
+    // Whatever the socket did not take is stale for the next one
+    if (s->pipe_sock[0] >= 0) {
+        close(s->pipe_sock[0]);
+        close(s->pipe_sock[1]);
+        if (pipe2(s->pipe_sock, O_NONBLOCK | O_CLOEXEC) != 0) {
+            s->pipe_sock[0] = s->pipe_sock[1] = -1;
+        }
+    }
+}
+
+// At most once a second while nobody listens
+static void try_connect(uart_sink_t *s) {
+    struct sockaddr_un addr;
+    unsigned long long now = timing_now_ns();
+
+    if (s->cfg.socket_path == NULL || s->sock >= 0 || now < s->next_connect_ns) {
+        return;
+    }
+    s->next_connect_ns = now + TIMING_S;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    snprintf(addr.sun_path, sizeof(addr.sun_path), "%s", s->cfg.socket_path);
+
+    s->sock = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (s->sock >= 0 && connect(s->sock, (struct sockaddr *)&addr, sizeof(addr)) != 0) {
+        close(s->sock);
+        s->sock = -1;
+    }
+}
+
+int uart_sink_open(uart_sink_t *s, int in, const uart_sink_cfg_t *cfg) {
+    memset(s, 0, sizeof(*s));
+    s->cfg = *cfg;
+    s->in = in;
+    s->sock = -1;
+    s->pipe_file[0] = s->pipe_file[1] = -1;
+    s->pipe_sock[0] = s->pipe_sock[1] = -1;
+
+    if (open_file(s) != 0) {
+        return -1;
+    }
+    if (!s->cfg.copy && (pipe2(s->pipe_file, O_NONBLOCK | O_CLOEXEC) != 0 ||
+                         pipe2(s->pipe_sock, O_NONBLOCK | O_CLOEXEC) != 0)) {
+        s->cfg.copy = true;
+    }
+    s->buf = malloc(SINK_CHUNK);
+    if (s->buf == NULL) {
+        uart_sink_close(s);
+        return -1;
+    }
+    try_connect(s);
+    return 0;
+}
+
+static int write_all(int fd, const char *p, size_t n) {
+    while (n > 0) {
+        ssize_t w = write(fd, p, n);
+        if (w < 0) {
+            return -1;
+        }
+        p += w;
+        n -= w;
+    }
+    return 0;
+}
+
+// One bite by read()/write(): returns bytes moved, 0 when the tty is empty
+static long copy_once(uart_sink_t *s) {
+    ssize_t n = read(s->in, s->buf, SINK_CHUNK);
+
+    if (n <= 0) {
+        return n < 0 && errno != EAGAIN ? -1 : 0;
+    }
+    if (write_all(s->out, s->buf, n) != 0) {
+        return -2;
+    }
+    if (s->sock >= 0) {
+        ssize_t w = send(s->sock, s->buf, n, MSG_DONTWAIT | MSG_NOSIGNAL);
+        if (w < 0 && errno != EAGAIN) {
+            drop_socket(s);
+        }
+        w = w < 0 ? 0 : w;
+        s->sock_bytes += w;
+        s->sock_dropped += n - w;
+    }
+    return n;
+}
+
+// The same through the pipes, without the bytes passing through us
+static long splice_once(uart_sink_t *s) {
+    ssize_t n = splice(s->in, NULL, s->pipe_file[1], NULL, SINK_CHUNK, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+
+    if (n <= 0) {
+        if (n < 0 && errno == EINVAL) {
+            // This tty cannot splice: fall back for good (nothing was moved)
+            fprintf(stderr, "UART sink: no splice on this device, copying\n");
+            s->cfg.copy = true;
+            return copy_once(s);
+        }
+        return n < 0 && errno != EAGAIN ? -1 : 0;
+    }
+
+    if (s->sock >= 0 && s->pipe_sock[1] >= 0) {
+        ssize_t t = tee(s->pipe_file[0], s->pipe_sock[1], n, SPLICE_F_NONBLOCK);
+        t = t < 0 ? 0 : t;
+        s->sock_dropped += n - t;
+        ssize_t w = splice(s->pipe_sock[0], NULL, s->sock, NULL, SINK_CHUNK, SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+        if (w < 0 && errno != EAGAIN) {
+            drop_socket(s);
+        } else if (w > 0) {
+            s->sock_bytes += w;
+        }
+    }
+
+    for (ssize_t left = n; left > 0;) {
+        ssize_t w = splice(s->pipe_file[0], NULL, s->out, NULL, left, SPLICE_F_MOVE);
+        if (w <= 0) {
+            return -2;
+        }
+        left -= w;
+    }
+    return n;
+}
+
+long uart_sink_pump(uart_sink_t *s, int timeout_ms) {
+    struct pollfd pfd = {s->in, POLLIN, 0};
+    long total = 0;
+
+    try_connect(s);
+    if (poll(&pfd, 1, timeout_ms) <= 0) {
+        return 0;
+    }
+    if (!(pfd.revents & POLLIN)) {
+        fprintf(stderr, "UART sink: hangup\n");
+        return -1;
+    }
+    s->wakeups++;
+    if (s->cfg.batch_ms > 0) {
+        delay_ms(s->cfg.batch_ms);
+    }
+
+    while (1) {
+        long n = s->cfg.copy ? copy_once(s) : splice_once(s);
+        if (n == -2) {
+            fprintf(stderr, "UART sink: cannot write %s: %s\n", s->cfg.path, strerror(errno));
+            return -1;
+        }
+        if (n == -1) {
+            fprintf(stderr, "UART sink: cannot read the UART: %s\n", strerror(errno));
+            return -1;
+        }
+        if (n <= 0) {
+            break;
+        }
+        total += n;
+        s->bytes += n;
+        s->file_bytes += n;
+        if (s->cfg.rotate_bytes > 0 && s->file_bytes >= s->cfg.rotate_bytes && rotate(s) != 0) {
+            return -1;
+        }
+    }
+    return total;
+}
+
+void uart_sink_close(uart_sink_t *s) {
+    int fds[] = {s->out, s->sock, s->pipe_file[0], s->pipe_file[1], s->pipe_sock[0], s->pipe_sock[1]};
+
+    for (unsigned i = 0; i < sizeof(fds) / sizeof(fds[0]); i++) {
+        if (fds[i] >= 0) {
+            close(fds[i]);
+        }
+    }
+    free(s->buf);
+    s->buf = NULL;
+    s->out = s->sock = -1;
+}
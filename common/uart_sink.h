@@ -0,0 +1,62 @@
+#ifndef UART_SINK_H
+#define UART_SINK_H
+
+#include <stdbool.h>
+#include <stddef.h>
+
+// Passthrough from a UART to a log file and a local socket, for data
+// logging.
+//
+// The bytes never come up to the program: splice() moves them from the tty
+// into a pipe, tee() duplicates the pipe for the socket, and splice() moves
+// them on into the file and the socket. The file is rotated like logrotate
+// does (path, path.1, ... path.<keep>) once it reaches rotate_bytes. The
+// socket is a Unix stream socket someone listens on; when it is missing or
+// too slow the file still gets everything, and what the socket missed is
+// counted. Where the tty cannot splice, or with copy set, the same happens
+// with large read()s and write()s.
+//
+// Waking up for every few bytes is what costs CPU on a UART, so after data
+// arrives the sink waits batch_ms for more before moving it: at 921600
+// baud and 10 ms that is about 900 bytes a wake-up, 100 wake-ups a second.
+// The tty buffers a few KB; keep batch_ms well under that at the line rate.
+//
+// uart_sink_cfg_init() takes the environment:
+//   UART_SINK_ROTATE    bytes per file (default 16 MB, 0 never rotates)
+//   UART_SINK_KEEP      rotated files kept (default 4)
+//   UART_SINK_SOCKET    socket path
+//   UART_SINK_BATCH_MS  (default 10)
+//   UART_SINK_COPY      1: read/write instead of splice
+
+typedef struct {
+    const char *path;
+    size_t rotate_bytes;
+    int keep;
+    const char *socket_path;
+    int batch_ms;
+    bool copy;
+} uart_sink_cfg_t;
+
+typedef struct {
+    uart_sink_cfg_t cfg;
+    int in, out, sock;
+    int pipe_file[2], pipe_sock[2];
+    char *buf;                 // copy mode
+    size_t file_bytes;
+    unsigned long long next_connect_ns;
+    unsigned long long bytes, sock_bytes, sock_dropped;
+    unsigned long wakeups, rotations;
+} uart_sink_t;
+
+void uart_sink_cfg_init(uart_sink_cfg_t *cfg, const char *path);
+
+// 'in' is a non-blocking tty, see uart_open_fd(); it stays the caller's
+int uart_sink_open(uart_sink_t *s, int in, const uart_sink_cfg_t *cfg);
+
+// Wait up to timeout_ms for data and move all there is. Returns the bytes
+// moved, -1 when the file cannot be written or the UART read (hangup).
+long uart_sink_pump(uart_sink_t *s, int timeout_ms);
+
+void uart_sink_close(uart_sink_t *s);
+
+#endif
@@ -0,0 +1,42 @@
+#include <stdio.h>
+#include <time.h>
+#include "timing.h"
+#include "worker.h"
+
+static void *run(void *arg) {
+    worker_t *w = arg;
+    uint64_t start = timing_now_ns();
+    struct timespec cpu;
+
+    while (!__atomic_load_n(&w->stopping, __ATOMIC_ACQUIRE)) {
+        w->step(w->arg);
+    }
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &cpu);
+    w->cpu_ns = (uint64_t)cpu.tv_sec * TIMING_S + cpu.tv_nsec;
+    w->run_ns = timing_now_ns() - start;
+    return NULL;
+}
+
+int worker_start(worker_t *w, const char *name, worker_fn step, void *arg) {
+    w->name = name;
+    w->step = step;
+    w->arg = arg;
+    w->stopping = 0;
+    w->cpu_ns = 0;
+    w->run_ns = 0;
+    if (pthread_create(&w->thread, NULL, run, w) != 0) {
+        fprintf(stderr, "%s: cannot start the thread\n", name);
+        return -1;
+    }
+    w->running = 1;
+    return 0;
+}
+
+void worker_stop(worker_t *w) {
+    if (w->running) {
+        __atomic_store_n(&w->stopping, 1, __ATOMIC_RELEASE);
+        pthread_join(w->thread, NULL);
+        w->running = 0;
+    }
+}
@@ -0,0 +1,34 @@
+#ifndef WORKER_H
+#define WORKER_H
+
+#include <stdint.h>
+#include <pthread.h>
+
+// A loop on a thread of its own, for the engines that run on deadlines
+// (soft_pwm.h, pwm_dither.h, servo.h): worker_start() calls step(arg) over
+// and over until worker_stop(), the step doing its own waiting. Once
+// stopped, cpu_ns and run_ns hold the CPU time the thread used and how
+// long it ran, for the engines' reports.
+//
+// The thread takes the scheduling policy of the one that starts it: call
+// rt_setup() first for a real-time loop.
+
+typedef void (*worker_fn)(void *arg);
+
+typedef struct {
+    const char *name;
+    worker_fn step;
+    void *arg;
+    pthread_t thread;
+    int stopping;
+    int running;
+    uint64_t cpu_ns, run_ns;      // of the thread, once stopped
+} worker_t;
+
+// -1, with a message naming it on stderr, if the thread cannot start
+int worker_start(worker_t *w, const char *name, worker_fn step, void *arg);
+
+// Let the step under way finish and join the thread; nothing if not running
+void worker_stop(worker_t *w);
+
+#endif
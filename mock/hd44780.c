@@ -0,0 +1,199 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "mock_internal.h"
+
+// DDRAM address of the first column of each row
+static const uint8_t row_base[MOCK_LCD_ROWS] = {0x00, 0x40};
+
+hd44780_t mock_lcd[2];
+
+void hd44780_reset(hd44780_t *lcd) {
+    memset(lcd, 0, sizeof(*lcd));
+    lcd->eight_bit = 1;   // the controller powers up in 8-bit mode
+    lcd->increment = 1;
+    memset(lcd->ddram, ' ', sizeof(lcd->ddram));
+}
+
+// Step the address counter the way the controller does: in 2-line mode
+// the lines are 0x00-0x27 and 0x40-0x67 and wrap into each other
+static void step(hd44780_t *lcd, int dir) {
+    int ac = lcd->ac + dir;
+
+    if (!lcd->two_lines) {
+        lcd->ac = (ac + 80) % 80;
+        return;
+    }
+    if (ac == 0x28) {
+        ac = 0x40;
+    } else if (ac == 0x68) {
+        ac = 0x00;
+    } else if (ac == -1) {
+        ac = 0x67;
+    } else if (ac == 0x3F) {
+        ac = 0x27;
+    }
+    lcd->ac = ac;
+}
+
+// Mirror the screen into $MOCK_LCD_FILE, e.g. for 'watch cat'
+static void publish(mock_lcd_t which) {
+    static const char *path = NULL;
+    static int checked = 0;
+
+    if (!checked) {
+        path = getenv("MOCK_LCD_FILE");
+        checked = 1;
+    }
+    if (path == NULL) {
+        return;
+    }
+
+    FILE *f = fopen(path, "w");
+    if (f != NULL) {
+        hd44780_print(&mock_lcd[which], f);
+        fclose(f);
+    }
+}
+
+// Write each strobe to $MOCK_LCD_CAPTURE
+static void capture(const char *name, int rs, int nibble, uint8_t value) {
+    static FILE *f = NULL;
+    static int checked = 0;
+
+    if (!checked) {
+        const char *path = getenv("MOCK_LCD_CAPTURE");
+        if (path != NULL && (f = fopen(path, "w")) == NULL) {
+            fprintf(stderr, "mock: cannot write %s\n", path);
+        }
+        checked = 1;
+    }
+    if (f != NULL) {
+        fprintf(f, "%12.3f %s %d %s 0x%0*X\n", mock_elapsed_ns() / 1e3, name, rs,
+                nibble ? "nibble" : "byte", nibble ? 1 : 2, value);
+        fflush(f);
+    }
+}
+
+// Execution times at the nominal 270 kHz clock
+static uint64_t exec_ns(int rs, uint8_t value) {
+    return !rs && (value == 0x01 || (value & 0xFE) == 0x02) ? 1520000 : 37000;
+}
+
+static void command(hd44780_t *lcd, const char *name, uint8_t cmd) {
+    mock_event("%s cmd 0x%02X", name, cmd);
+
+    if (cmd & 0x80) {
+        lcd->ac = cmd & 0x7F;          // set DDRAM address
+        lcd->cgram = 0;
+    } else if (cmd & 0x40) {
+        lcd->ac = cmd & 0x3F;          // set CGRAM address
+        lcd->cgram = 1;
+    } else if (cmd & 0x20) {
+        lcd->eight_bit = (cmd & 0x10) != 0;  // function set
+        lcd->two_lines = (cmd & 0x08) != 0;
+        lcd->half = 0;
+    } else if (cmd & 0x10) {
+        int right = (cmd & 0x04) != 0;
+        if (cmd & 0x08) {
+            lcd->shift += right ? -1 : 1;    // display shift
+        } else {
+            step(lcd, right ? 1 : -1);       // cursor move
+        }
+    } else if (cmd & 0x08) {
+        lcd->display_on = (cmd & 0x04) != 0;
+    } else if (cmd & 0x04) {
+        lcd->increment = (cmd & 0x02) != 0;
+    } else if (cmd & 0x02) {
+        lcd->ac = 0;                   // return home
+        lcd->shift = 0;
+        lcd->cgram = 0;
+    } else if (cmd & 0x01) {
+        memset(lcd->ddram, ' ', sizeof(lcd->ddram));  // clear display
+        lcd->ac = 0;
+        lcd->shift = 0;
+        lcd->increment = 1;
+        lcd->cgram = 0;
+    }
+}
+
+static void data(hd44780_t *lcd, const char *name, uint8_t value) {
+    if (value >= 0x20 && value < 0x7F) {
+        mock_event("%s data '%c'", name, value);
+    } else {
+        mock_event("%s data 0x%02X", name, value);
+    }
+
+    if (lcd->cgram) {
+        lcd->cgram_data[lcd->ac & 0x3F] = value & 0x1F;
+        lcd->ac = (lcd->ac + (lcd->increment ? 1 : -1)) & 0x3F;
+        return;
+    }
+    lcd->ddram[lcd->ac & 0x7F] = value;
+    step(lcd, lcd->increment ? 1 : -1);
+}
+
+void hd44780_strobe(hd44780_t *lcd, mock_lcd_t which, int rs, uint8_t bus) {
+    const char *name = which == MOCK_LCD_I2C ? "lcd_i2c" : "lcd";
+    uint8_t value = bus;
+
+    uint64_t now = mock_now_ns();
+
+    lcd->strobes++;
+    lcd->used = 1;
+    if (now < lcd->busy_until_ns) {
+        lcd->early++;
+    }
+
+    // In 4-bit mode only D7..D4 are wired; two strobes make one byte
+    if (!lcd->eight_bit) {
+        capture(name, rs, 1, bus >> 4);
+        if (!lcd->half) {
+            lcd->high = bus & 0xF0;
+            lcd->half = 1;
+            return;
+        }
+        lcd->half = 0;
+        value = lcd->high | (bus >> 4);
+    } else {
+        capture(name, rs, 0, value);
+    }
+    lcd->busy_until_ns = now + exec_ns(rs, value);
+
+    if (rs) {
+        data(lcd, name, value);
+    } else {
+        command(lcd, name, value);
+    }
+    publish(which);
+}
+
+unsigned long hd44780_bus_errors(const hd44780_t *lcd) {
+    return lcd->early + lcd->short_pulse + lcd->unstable;
+}
+
+void hd44780_print(const hd44780_t *lcd, FILE *out) {
+    char text[MOCK_LCD_COLS + 1];
+
+    fprintf(out, "+----------------+\n");
+    for (int r = 0; r < MOCK_LCD_ROWS; r++) {
+        hd44780_row(lcd, r, text);
+        fprintf(out, "|%s|\n", text);
+    }
+    fprintf(out, "+----------------+\n");
+}
+
+void hd44780_row(const hd44780_t *lcd, int row, char *out) {
+    for (int c = 0; c < MOCK_LCD_COLS; c++) {
+        int col = ((c + lcd->shift) % 40 + 40) % 40;
+        uint8_t ch = lcd->ddram[row_base[row] + col];
+
+        if (!lcd->display_on) {
+            ch = ' ';
+        } else if (ch < 0x20 || ch >= 0x7F) {
+            ch = '#';
+        }
+        out[c] = ch;
+    }
+    out[MOCK_LCD_COLS] = '\0';
+}
@@ -0,0 +1,13 @@
+#ifndef MRAA_H
+#define MRAA_H
+
+// Host mock of the libmraa API used by the exercises, see mock/mock.h
+
+#include "mraa/common.h"
+#include "mraa/gpio.h"
+#include "mraa/aio.h"
+#include "mraa/pwm.h"
+#include "mraa/uart.h"
+#include "mraa/i2c.h"
+
+#endif
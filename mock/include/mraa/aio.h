@@ -0,0 +1,15 @@
+#ifndef MRAA_AIO_H
+#define MRAA_AIO_H
+
+#include "common.h"
+
+typedef struct _aio *mraa_aio_context;
+
+mraa_aio_context mraa_aio_init(unsigned int pin);
+int mraa_aio_read(mraa_aio_context dev);
+float mraa_aio_read_float(mraa_aio_context dev);
+mraa_result_t mraa_aio_set_bit(mraa_aio_context dev, int bits);
+int mraa_aio_get_bit(mraa_aio_context dev);
+mraa_result_t mraa_aio_close(mraa_aio_context dev);
+
+#endif
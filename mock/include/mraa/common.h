@@ -0,0 +1,34 @@
+#ifndef MRAA_COMMON_H
+#define MRAA_COMMON_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Same values as libmraa, so the mock is a drop-in replacement
+
+// Lets common code tell the simulated board from the real one
+#define MRAA_MOCK 1
+
+typedef unsigned int mraa_boolean_t;
+
+typedef enum {
+    MRAA_SUCCESS = 0,
+    MRAA_ERROR_FEATURE_NOT_IMPLEMENTED = 1,
+    MRAA_ERROR_FEATURE_NOT_SUPPORTED = 2,
+    MRAA_ERROR_INVALID_VERBOSITY_LEVEL = 3,
+    MRAA_ERROR_INVALID_PARAMETER = 4,
+    MRAA_ERROR_INVALID_HANDLE = 5,
+    MRAA_ERROR_NO_RESOURCES = 6,
+    MRAA_ERROR_INVALID_RESOURCE = 7,
+    MRAA_ERROR_INVALID_QUEUE_TYPE = 8,
+    MRAA_ERROR_NO_DATA_AVAILABLE = 9,
+    MRAA_ERROR_INVALID_PLATFORM = 10,
+    MRAA_ERROR_PLATFORM_NOT_INITIALISED = 11,
+    MRAA_ERROR_UNSPECIFIED = 99
+} mraa_result_t;
+
+mraa_result_t mraa_init(void);
+void mraa_deinit(void);
+const char *mraa_get_version(void);
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef MRAA_GPIO_H
+#define MRAA_GPIO_H
+
+#include "common.h"
+
+typedef struct _gpio *mraa_gpio_context;
+
+typedef enum {
+    MRAA_GPIO_OUT = 0,
+    MRAA_GPIO_IN = 1,
+    MRAA_GPIO_OUT_HIGH = 2,
+    MRAA_GPIO_OUT_LOW = 3
+} mraa_gpio_dir_t;
+
+typedef enum {
+    MRAA_GPIO_STRONG = 0,
+    MRAA_GPIO_PULLUP = 1,
+    MRAA_GPIO_PULLDOWN = 2,
+    MRAA_GPIO_HIZ = 3
+} mraa_gpio_mode_t;
+
+mraa_gpio_context mraa_gpio_init(int pin);
+mraa_result_t mraa_gpio_dir(mraa_gpio_context dev, mraa_gpio_dir_t dir);
+mraa_result_t mraa_gpio_mode(mraa_gpio_context dev, mraa_gpio_mode_t mode);
+int mraa_gpio_read(mraa_gpio_context dev);
+mraa_result_t mraa_gpio_write(mraa_gpio_context dev, int value);
+int mraa_gpio_get_pin(mraa_gpio_context dev);
+mraa_result_t mraa_gpio_close(mraa_gpio_context dev);
+
+#endif
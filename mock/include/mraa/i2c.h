@@ -0,0 +1,15 @@
+#ifndef MRAA_I2C_H
+#define MRAA_I2C_H
+
+#include "common.h"
+
+typedef struct _i2c *mraa_i2c_context;
+
+mraa_i2c_context mraa_i2c_init(int bus);
+mraa_result_t mraa_i2c_address(mraa_i2c_context dev, uint8_t address);
+mraa_result_t mraa_i2c_write_byte(mraa_i2c_context dev, uint8_t data);
+mraa_result_t mraa_i2c_write(mraa_i2c_context dev, const uint8_t *data, int length);
+int mraa_i2c_read_byte(mraa_i2c_context dev);
+mraa_result_t mraa_i2c_stop(mraa_i2c_context dev);
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef MRAA_PWM_H
+#define MRAA_PWM_H
+
+#include "common.h"
+
+typedef struct _pwm *mraa_pwm_context;
+
+mraa_pwm_context mraa_pwm_init(int pin);
+mraa_result_t mraa_pwm_write(mraa_pwm_context dev, float percentage);
+float mraa_pwm_read(mraa_pwm_context dev);
+mraa_result_t mraa_pwm_period(mraa_pwm_context dev, float seconds);
+mraa_result_t mraa_pwm_period_ms(mraa_pwm_context dev, int ms);
+mraa_result_t mraa_pwm_period_us(mraa_pwm_context dev, int us);
+mraa_result_t mraa_pwm_pulsewidth(mraa_pwm_context dev, float seconds);
+mraa_result_t mraa_pwm_pulsewidth_ms(mraa_pwm_context dev, int ms);
+mraa_result_t mraa_pwm_pulsewidth_us(mraa_pwm_context dev, int us);
+mraa_result_t mraa_pwm_enable(mraa_pwm_context dev, int enable);
+mraa_result_t mraa_pwm_close(mraa_pwm_context dev);
+
+#endif
@@ -0,0 +1,30 @@
+#ifndef MRAA_UART_H
+#define MRAA_UART_H
+
+#include "common.h"
+
+typedef struct _uart *mraa_uart_context;
+
+typedef enum {
+    MRAA_UART_PARITY_NONE = 0,
+    MRAA_UART_PARITY_EVEN = 1,
+    MRAA_UART_PARITY_ODD = 2,
+    MRAA_UART_PARITY_MARK = 3,
+    MRAA_UART_PARITY_SPACE = 4
+} mraa_uart_parity_t;
+
+mraa_uart_context mraa_uart_init(int uart);
+mraa_uart_context mraa_uart_init_raw(const char *path);
+mraa_result_t mraa_uart_set_baudrate(mraa_uart_context dev, unsigned int baud);
+mraa_result_t mraa_uart_set_mode(mraa_uart_context dev, int bytesize, mraa_uart_parity_t parity, int stopbits);
+mraa_result_t mraa_uart_set_flowcontrol(mraa_uart_context dev, mraa_boolean_t xonxoff, mraa_boolean_t rtscts);
+mraa_result_t mraa_uart_set_timeout(mraa_uart_context dev, int read, int write, int interchar);
+mraa_result_t mraa_uart_set_non_blocking(mraa_uart_context dev, mraa_boolean_t nonblock);
+const char *mraa_uart_get_dev_path(mraa_uart_context dev);
+int mraa_uart_read(mraa_uart_context dev, char *buf, size_t length);
+int mraa_uart_write(mraa_uart_context dev, const char *buf, size_t length);
+mraa_boolean_t mraa_uart_data_available(mraa_uart_context dev, unsigned int millis);
+mraa_result_t mraa_uart_flush(mraa_uart_context dev);
+mraa_result_t mraa_uart_stop(mraa_uart_context dev);
+
+#endif
@@ -0,0 +1,68 @@
+#ifndef MOCK_H
+#define MOCK_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+// Simulated RuggedBoard peripherals behind the mraa API, for running and
+// benchmarking the exercises on a Linux host.
+//
+// Link with libmock (mock/*.c) and put mock/include on the include path
+// instead of libmraa. The mock wires the same header pins as pins.conf:
+//   lcd     HD44780 on rs 12, rw 48, en 13, d0-d7 36 37 40 39 43 53 52 51;
+//           it decodes every EN strobe, 8-bit or 4-bit as the function set
+//           command selects, and a second one sits behind a PCF8574 I2C
+//           backpack at 0x27 (or 0x3F).
+//   keypad  4x3 matrix, rows 12 13 36 37 driven, columns 40 39 43 read.
+//   seg7    common anode 7-segment display on 53 52 51 48 47 46 45.
+//   led     every other output pin is an LED.
+// Several of these share pins, as the exercises do; $MOCK_DEVICES
+// (default "lcd,keypad,seg7,led") picks the ones plugged in.
+//
+// UARTs opened under /dev/tty* become ptys; the other end is linked at
+// $MOCK_UART_DIR/mock-<name> (default /tmp) for a terminal program, or
+// echoes everything back with MOCK_UART_LOOPBACK=1. Other paths, such as
+// an existing pty, are opened as they are.
+//
+// Inputs are scripted with $MOCK_SCRIPT, one event per line:
+//   <ms> key <1-9,0,*,#>   press a key (<ms> key - releases it)
+//   <ms> pin <n> <0|1>      drive an input pin (<ms> pin <n> - releases)
+//   <ms> adc <n> <value>    set an analog input (default 512 of 1023)
+// with <ms> counted from program start. Input pins nobody drives read 1,
+// like the pulled-up buttons on the board.
+//
+// The HD44780 models also check the bus timing: a strobe sent while the
+// previous instruction is still executing (37 us, 1.52 ms for clear and
+// home), an EN pulse under 450 ns, or RS/RW/data changing while EN is high
+// counts as a bus error, reported with the screen at exit. With
+// $MOCK_LCD_CAPTURE set, every strobe is written there as it happens:
+//   <us since start> <lcd|lcd_i2c> <rs> <nibble|byte> <hex value>
+//
+// With $MOCK_TIMELINE set, every LED, 7-segment, LCD, PWM and key event is
+// recorded with its time and written there at exit; MOCK_VERBOSE=1 also
+// prints them as they happen. The final LCD screen is printed to stderr at
+// exit, and rewritten to $MOCK_LCD_FILE on every change if that is set.
+
+typedef enum {
+    MOCK_LCD_GPIO = 0,
+    MOCK_LCD_I2C
+} mock_lcd_t;
+
+// Inputs, the same as the script events
+void mock_key_press(char key);          // '\0' releases
+void mock_pin_input(int pin, int level); // -1 releases
+void mock_adc_set(int pin, int value);
+
+// Outputs
+int mock_pin_level(int pin);            // -1 if never driven
+int mock_seg7_digit(void);              // -1 if blank or not a digit
+int mock_pwm_duty_permille(int pin);    // -1 if not enabled
+int mock_lcd_row(mock_lcd_t which, int row, char *buf, int size);
+uint64_t mock_lcd_strobes(mock_lcd_t which);
+unsigned long mock_lcd_bus_errors(mock_lcd_t which);
+void mock_lcd_print(mock_lcd_t which, FILE *out);
+
+// Timeline, also written automatically at exit
+int mock_timeline_write(const char *path);
+
+#endif
@@ -0,0 +1,198 @@
+#include <stdlib.h>
+#include "mock_internal.h"
+
+#define MOCK_ADC_DEFAULT 512
+
+struct _aio {
+    int pin;
+    int bits;
+};
+
+struct _pwm {
+    int pin;
+    int period_us;
+    float duty;
+    int enabled;
+};
+
+static int adc_values[MOCK_MAX_PINS];
+static int adc_set[MOCK_MAX_PINS];
+static int pwm_permille[MOCK_MAX_PINS];
+static int pwm_enabled[MOCK_MAX_PINS];
+
+int mock_adc_value(int pin) {
+    return adc_set[pin] ? adc_values[pin] : MOCK_ADC_DEFAULT;
+}
+
+void mock_adc_set(int pin, int value) {
+    if (pin < 0 || pin >= MOCK_MAX_PINS) {
+        return;
+    }
+    pthread_mutex_lock(&mock_lock);
+    adc_values[pin] = value;
+    adc_set[pin] = 1;
+    mock_event("adc %d %d", pin, value);
+    pthread_mutex_unlock(&mock_lock);
+}
+
+int mock_pwm_duty_permille(int pin) {
+    if (pin < 0 || pin >= MOCK_MAX_PINS) {
+        return -1;
+    }
+    pthread_mutex_lock(&mock_lock);
+    int permille = pwm_enabled[pin] ? pwm_permille[pin] : -1;
+    pthread_mutex_unlock(&mock_lock);
+    return permille;
+}
+
+// ---- aio ----
+
+mraa_aio_context mraa_aio_init(unsigned int pin) {
+    if (pin >= MOCK_MAX_PINS) {
+        return NULL;
+    }
+    mraa_aio_context dev = malloc(sizeof(*dev));
+    if (dev != NULL) {
+        dev->pin = pin;
+        dev->bits = 10;
+    }
+    return dev;
+}
+
+int mraa_aio_read(mraa_aio_context dev) {
+    if (dev == NULL) {
+        return -1;
+    }
+    pthread_mutex_lock(&mock_lock);
+    int value = mock_adc_value(dev->pin);
+    pthread_mutex_unlock(&mock_lock);
+
+    // Values are scripted for 10 bits
+    if (dev->bits > 10) {
+        value <<= dev->bits - 10;
+    } else {
+        value >>= 10 - dev->bits;
+    }
+    return value;
+}
+
+float mraa_aio_read_float(mraa_aio_context dev) {
+    if (dev == NULL) {
+        return -1.0f;
+    }
+    return (float)mraa_aio_read(dev) / ((1 << dev->bits) - 1);
+}
+
+mraa_result_t mraa_aio_set_bit(mraa_aio_context dev, int bits) {
+    if (dev == NULL || bits < 1 || bits > 16) {
+        return MRAA_ERROR_INVALID_PARAMETER;
+    }
+    dev->bits = bits;
+    return MRAA_SUCCESS;
+}
+
+int mraa_aio_get_bit(mraa_aio_context dev) {
+    return dev ? dev->bits : 0;
+}
+
+mraa_result_t mraa_aio_close(mraa_aio_context dev) {
+    free(dev);
+    return MRAA_SUCCESS;
+}
+
+// ---- pwm ----
+
+static void pwm_update(mraa_pwm_context dev) {
+    int permille = (int)(dev->duty * 1000.0f + 0.5f);
+
+    pthread_mutex_lock(&mock_lock);
+    if (pwm_enabled[dev->pin] != dev->enabled) {
+        mock_event("pwm %d %s", dev->pin, dev->enabled ? "enabled" : "disabled");
+        pwm_enabled[dev->pin] = dev->enabled;
+    }
+    if (pwm_permille[dev->pin] != permille) {
+        mock_event("pwm %d duty %d.%d%%", dev->pin, permille / 10, permille % 10);
+        pwm_permille[dev->pin] = permille;
+    }
+    pthread_mutex_unlock(&mock_lock);
+}
+
+mraa_pwm_context mraa_pwm_init(int pin) {
+    if (pin < 0 || pin >= MOCK_MAX_PINS) {
+        return NULL;
+    }
+    mraa_pwm_context dev = calloc(1, sizeof(*dev));
+    if (dev != NULL) {
+        dev->pin = pin;
+        dev->period_us = 20000;
+    }
+    return dev;
+}
+
+mraa_result_t mraa_pwm_write(mraa_pwm_context dev, float percentage) {
+    if (dev == NULL) {
+        return MRAA_ERROR_INVALID_HANDLE;
+    }
+    if (percentage < 0.0f) {
+        percentage = 0.0f;
+    } else if (percentage > 1.0f) {
+        percentage = 1.0f;
+    }
+    dev->duty = percentage;
+    pwm_update(dev);
+    return MRAA_SUCCESS;
+}
+
+float mraa_pwm_read(mraa_pwm_context dev) {
+    return dev ? dev->duty : 0.0f;
+}
+
+mraa_result_t mraa_pwm_period_us(mraa_pwm_context dev, int us) {
+    if (dev == NULL || us <= 0) {
+        return MRAA_ERROR_INVALID_PARAMETER;
+    }
+    if (dev->period_us != us) {
+        pthread_mutex_lock(&mock_lock);
+        mock_event("pwm %d period %d us", dev->pin, us);
+        pthread_mutex_unlock(&mock_lock);
+    }
+    dev->period_us = us;
+    return MRAA_SUCCESS;
+}
+
+mraa_result_t mraa_pwm_period_ms(mraa_pwm_context dev, int ms) {
+    return mraa_pwm_period_us(dev, ms * 1000);
+}
+
+mraa_result_t mraa_pwm_period(mraa_pwm_context dev, float seconds) {
+    return mraa_pwm_period_us(dev, (int)(seconds * 1e6f));
+}
+
+mraa_result_t mraa_pwm_pulsewidth_us(mraa_pwm_context dev, int us) {
+    if (dev == NULL) {
+        return MRAA_ERROR_INVALID_HANDLE;
+    }
+    return mraa_pwm_write(dev, (float)us / dev->period_us);
+}
+
+mraa_result_t mraa_pwm_pulsewidth_ms(mraa_pwm_context dev, int ms) {
+    return mraa_pwm_pulsewidth_us(dev, ms * 1000);
+}
+
+mraa_result_t mraa_pwm_pulsewidth(mraa_pwm_context dev, float seconds) {
+    return mraa_pwm_pulsewidth_us(dev, (int)(seconds * 1e6f));
+}
+
+mraa_result_t mraa_pwm_enable(mraa_pwm_context dev, int enable) {
+    if (dev == NULL) {
+        return MRAA_ERROR_INVALID_HANDLE;
+    }
+    dev->enabled = enable != 0;
+    pwm_update(dev);
+    return MRAA_SUCCESS;
+}
+
+mraa_result_t mraa_pwm_close(mraa_pwm_context dev) {
+    free(dev);
+    return MRAA_SUCCESS;
+}
@@ -0,0 +1,624 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <errno.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include "mock_internal.h"
+
+#define MOCK_MAX_EVENTS  200000
+#define MOCK_EVENT_TEXT  40
+#define MOCK_MAX_SCRIPT  1024
+
+typedef struct {
+    int out;
+    int level;    // last driven output level, -1 never driven
+    int input;    // level forced by the script, -1 none
+    int mode;
+} pin_t;
+
+typedef struct {
+    uint64_t t_ns;
+    char text[MOCK_EVENT_TEXT];
+} event_t;
+
+typedef struct {
+    uint64_t at_ns;
+    char kind;     // 'k' key, 'p' pin, 'a' adc
+    int pin;
+    int value;
+} script_t;
+
+struct _gpio {
+    int pin;
+};
+
+// Board wiring, the same as pins.conf
+static const int lcd_rs = 12, lcd_rw = 48, lcd_en = 13;
+static const int lcd_d[8] = {36, 37, 40, 39, 43, 53, 52, 51};
+static const int key_rows[4] = {12, 13, 36, 37};
+static const int key_cols[3] = {40, 39, 43};
+static const char key_map[4][3] = {
+    {'1', '2', '3'},
+    {'4', '5', '6'},
+    {'7', '8', '9'},
+    {'*', '0', '#'}
+};
+static const int seg_pins[7] = {53, 52, 51, 48, 47, 46, 45};
+
+// Lit segments (bit 0 = a) of the digits 0-9
+static const uint8_t seg_digits[10] = {0x3F, 0x06, 0x5B, 0x4F, 0x66, 0x6D, 0x7D, 0x07, 0x7F, 0x6F};
+
+pthread_mutex_t mock_lock = PTHREAD_MUTEX_INITIALIZER;
+int mock_devices = MOCK_DEV_LCD | MOCK_DEV_KEYPAD | MOCK_DEV_SEG7 | MOCK_DEV_LED;
+
+static pin_t pins[MOCK_MAX_PINS];
+static int key_row = -1, key_col = -1;
+static uint8_t seg_shown = 0;
+static uint64_t start_ns = 0;
+static uint64_t en_rise_ns = 0;
+static int verbose = 0;
+
+static event_t *events = NULL;
+static int num_events = 0;
+static long dropped_events = 0;
+static const char *timeline_path = NULL;
+
+static script_t script[MOCK_MAX_SCRIPT];
+static int num_script = 0;
+
+uint64_t mock_now_ns(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + ts.tv_nsec;
+}
+
+uint64_t mock_elapsed_ns(void) {
+    return mock_now_ns() - start_ns;
+}
+
+void mock_event(const char *fmt, ...) {
+    if (!verbose && events == NULL) {
+        return;
+    }
+
+    uint64_t t = mock_now_ns() - start_ns;
+    char text[MOCK_EVENT_TEXT];
+    va_list ap;
+
+    va_start(ap, fmt);
+    vsnprintf(text, sizeof(text), fmt, ap);
+    va_end(ap);
+
+    if (verbose) {
+        fprintf(stderr, "[mock %10.3f ms] %s\n", t / 1e6, text);
+    }
+    if (events == NULL) {
+        return;
+    }
+    if (num_events == MOCK_MAX_EVENTS) {
+        dropped_events++;
+        return;
+    }
+    events[num_events].t_ns = t;
+    memcpy(events[num_events].text, text, sizeof(text));
+    num_events++;
+}
+
+static int in_list(int pin, const int *list, int count) {
+    for (int i = 0; i < count; i++) {
+        if (list[i] == pin) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// 1 if an attached device other than the LED bank uses the pin
+static int claimed(int pin) {
+    if ((mock_devices & MOCK_DEV_LCD) &&
+        (pin == lcd_rs || pin == lcd_rw || pin == lcd_en || in_list(pin, lcd_d, 8) >= 0)) {
+        return 1;
+    }
+    if ((mock_devices & MOCK_DEV_KEYPAD) &&
+        (in_list(pin, key_rows, 4) >= 0 || in_list(pin, key_cols, 3) >= 0)) {
+        return 1;
+    }
+    if ((mock_devices & MOCK_DEV_SEG7) && in_list(pin, seg_pins, 7) >= 0) {
+        return 1;
+    }
+    return 0;
+}
+
+static uint8_t seg7_lit(void) {
+    uint8_t lit = 0;
+
+    // Common anode: a segment is lit while its pin is low
+    for (int i = 0; i < 7; i++) {
+        if (pins[seg_pins[i]].level == 0) {
+            lit |= 1 << i;
+        }
+    }
+    return lit;
+}
+
+static int seg7_digit(uint8_t lit) {
+    for (int d = 0; d < 10; d++) {
+        if (seg_digits[d] == lit) {
+            return d;
+        }
+    }
+    return -1;
+}
+
+static void lcd_edge(void) {
+    uint8_t bus = 0;
+
+    if (pins[lcd_rw].level == 1) {
+        return;  // read cycle, nothing to latch
+    }
+    for (int i = 0; i < 8; i++) {
+        if (pins[lcd_d[i]].level > 0) {
+            bus |= 1 << i;
+        }
+    }
+    hd44780_strobe(&mock_lcd[MOCK_LCD_GPIO], MOCK_LCD_GPIO, pins[lcd_rs].level > 0, bus);
+}
+
+// The controller samples RS/RW on the rising edge of EN and the data on
+// the falling edge: nothing may change in between, and the pulse has to
+// last 450 ns
+static void lcd_check(int pin, int level) {
+    hd44780_t *lcd = &mock_lcd[MOCK_LCD_GPIO];
+
+    if (pin == lcd_en) {
+        if (level == 1) {
+            en_rise_ns = mock_now_ns();
+        } else if (mock_now_ns() - en_rise_ns < 450) {
+            lcd->short_pulse++;
+        }
+    } else if (pins[lcd_en].level == 1 &&
+               (pin == lcd_rs || pin == lcd_rw || in_list(pin, lcd_d, 8) >= 0)) {
+        lcd->unstable++;
+    }
+}
+
+// An output changed level: let every attached device see it
+static void pin_changed(int pin, int prev, int level) {
+    if (mock_devices & MOCK_DEV_LCD) {
+        lcd_check(pin, level);
+        if (pin == lcd_en && prev == 1 && level == 0) {
+            lcd_edge();
+        }
+    }
+    if ((mock_devices & MOCK_DEV_SEG7) && in_list(pin, seg_pins, 7) >= 0) {
+        uint8_t lit = seg7_lit();
+        if (lit != seg_shown) {
+            int d = seg7_digit(lit);
+            if (d >= 0) {
+                mock_event("seg7 %d", d);
+            } else {
+                mock_event("seg7 segments 0x%02X", lit);
+            }
+            seg_shown = lit;
+        }
+    }
+    if ((mock_devices & MOCK_DEV_LED) && !claimed(pin)) {
+        mock_event("led %d %s", pin, level ? "on" : "off");
+    }
+}
+
+static void drive(int pin, int level) {
+    int prev = pins[pin].level;
+
+    pins[pin].level = level;
+    if (prev != level) {
+        pin_changed(pin, prev, level);
+    }
+}
+
+static int sample(int pin) {
+    const pin_t *p = &pins[pin];
+
+    if (p->out) {
+        return p->level > 0;
+    }
+    if (p->input >= 0) {
+        return p->input;
+    }
+
+    // A pressed key connects its row to its column
+    int c = in_list(pin, key_cols, 3);
+    if ((mock_devices & MOCK_DEV_KEYPAD) && c >= 0 && c == key_col) {
+        const pin_t *row = &pins[key_rows[key_row]];
+        if (row->out && row->level == 0) {
+            return 0;
+        }
+    }
+    return p->mode == MRAA_GPIO_PULLDOWN ? 0 : 1;
+}
+
+// ---- inputs ----
+
+static void key_set(char key) {
+    key_row = key_col = -1;
+    for (int r = 0; r < 4; r++) {
+        for (int c = 0; c < 3; c++) {
+            if (key_map[r][c] == key) {
+                key_row = r;
+                key_col = c;
+            }
+        }
+    }
+    if (key_row >= 0) {
+        mock_event("key %c down", key);
+    } else {
+        mock_event("key up");
+    }
+}
+
+void mock_key_press(char key) {
+    pthread_mutex_lock(&mock_lock);
+    key_set(key);
+    pthread_mutex_unlock(&mock_lock);
+}
+
+void mock_pin_input(int pin, int level) {
+    if (pin < 0 || pin >= MOCK_MAX_PINS) {
+        return;
+    }
+    pthread_mutex_lock(&mock_lock);
+    pins[pin].input = level < 0 ? -1 : level != 0;
+    mock_event("pin %d input %d", pin, pins[pin].input);
+    pthread_mutex_unlock(&mock_lock);
+}
+
+// ---- outputs ----
+
+int mock_pin_level(int pin) {
+    if (pin < 0 || pin >= MOCK_MAX_PINS) {
+        return -1;
+    }
+    pthread_mutex_lock(&mock_lock);
+    int level = pins[pin].level;
+    pthread_mutex_unlock(&mock_lock);
+    return level;
+}
+
+int mock_seg7_digit(void) {
+    pthread_mutex_lock(&mock_lock);
+    int d = seg7_digit(seg7_lit());
+    pthread_mutex_unlock(&mock_lock);
+    return d;
+}
+
+int mock_lcd_row(mock_lcd_t which, int row, char *buf, int size) {
+    char text[MOCK_LCD_COLS + 1];
+
+    if (row < 0 || row >= MOCK_LCD_ROWS || size <= 0) {
+        return -1;
+    }
+    pthread_mutex_lock(&mock_lock);
+    hd44780_row(&mock_lcd[which], row, text);
+    pthread_mutex_unlock(&mock_lock);
+    snprintf(buf, size, "%s", text);
+    return 0;
+}
+
+uint64_t mock_lcd_strobes(mock_lcd_t which) {
+    pthread_mutex_lock(&mock_lock);
+    uint64_t n = mock_lcd[which].strobes;
+    pthread_mutex_unlock(&mock_lock);
+    return n;
+}
+
+unsigned long mock_lcd_bus_errors(mock_lcd_t which) {
+    pthread_mutex_lock(&mock_lock);
+    unsigned long n = hd44780_bus_errors(&mock_lcd[which]);
+    pthread_mutex_unlock(&mock_lock);
+    return n;
+}
+
+void mock_lcd_print(mock_lcd_t which, FILE *out) {
+    pthread_mutex_lock(&mock_lock);
+    hd44780_print(&mock_lcd[which], out);
+    pthread_mutex_unlock(&mock_lock);
+}
+
+int mock_timeline_write(const char *path) {
+    FILE *f = fopen(path, "w");
+
+    if (f == NULL) {
+        fprintf(stderr, "mock: cannot write %s: %s\n", path, strerror(errno));
+        return -1;
+    }
+    pthread_mutex_lock(&mock_lock);
+    for (int i = 0; i < num_events; i++) {
+        fprintf(f, "%10.3f %s\n", events[i].t_ns / 1e6, events[i].text);
+    }
+    if (dropped_events > 0) {
+        fprintf(f, "# %ld more events not recorded\n", dropped_events);
+    }
+    pthread_mutex_unlock(&mock_lock);
+    fclose(f);
+    return 0;
+}
+
+// ---- script ----
+
+static int script_cmp(const void *a, const void *b) {
+    const script_t *x = a, *y = b;
+    return (x->at_ns > y->at_ns) - (x->at_ns < y->at_ns);
+}
+
+static void load_script(const char *path) {
+    FILE *f = fopen(path, "r");
+    char line[128];
+    int lineno = 0;
+
+    if (f == NULL) {
+        fprintf(stderr, "mock: cannot open script %s: %s\n", path, strerror(errno));
+        return;
+    }
+
+    while (fgets(line, sizeof(line), f) != NULL && num_script < MOCK_MAX_SCRIPT) {
+        char kind[8], arg[8], val[8] = "";
+        unsigned long ms;
+        script_t *s = &script[num_script];
+
+        lineno++;
+        if (line[0] == '#' || sscanf(line, "%lu %7s %7s %7s", &ms, kind, arg, val) < 3) {
+            continue;
+        }
+        s->at_ns = ms * 1000000ULL;
+        if (strcmp(kind, "key") == 0) {
+            s->kind = 'k';
+            s->value = arg[0] == '-' ? '\0' : arg[0];
+        } else if (strcmp(kind, "pin") == 0 || strcmp(kind, "adc") == 0) {
+            s->kind = kind[0];
+            s->pin = atoi(arg);
+            s->value = val[0] == '-' ? -1 : atoi(val);
+        } else {
+            fprintf(stderr, "mock: %s:%d: unknown event '%s'\n", path, lineno, kind);
+            continue;
+        }
+        num_script++;
+    }
+    fclose(f);
+    qsort(script, num_script, sizeof(script[0]), script_cmp);
+}
+
+static void *script_thread(void *arg) {
+    (void)arg;
+
+    for (int i = 0; i < num_script; i++) {
+        uint64_t at = start_ns + script[i].at_ns;
+        struct timespec ts = {at / 1000000000ULL, at % 1000000000ULL};
+
+        while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &ts, NULL) == EINTR) {
+        }
+        if (script[i].kind == 'k') {
+            mock_key_press((char)script[i].value);
+        } else if (script[i].kind == 'p') {
+            mock_pin_input(script[i].pin, script[i].value);
+        } else {
+            mock_adc_set(script[i].pin, script[i].value);
+        }
+    }
+    return NULL;
+}
+
+// ---- startup and exit ----
+
+static void mock_exit(void) {
+    struct timespec deadline;
+
+    if (timeline_path != NULL) {
+        mock_timeline_write(timeline_path);
+    }
+
+    // Called on Ctrl-C too, from the signal thread while the interrupted
+    // code may hold the lock: the screen is worth printing either way
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_nsec += 100000000;
+    if (deadline.tv_nsec >= 1000000000) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+    }
+    int locked = pthread_mutex_timedlock(&mock_lock, &deadline) == 0;
+
+    for (int i = 0; i < 2; i++) {
+        if (mock_lcd[i].used) {
+            const hd44780_t *lcd = &mock_lcd[i];
+            fprintf(stderr, "mock: %s LCD after %llu strobes, %lu bus errors", i == MOCK_LCD_I2C ? "I2C" : "GPIO",
+                    (unsigned long long)lcd->strobes, hd44780_bus_errors(lcd));
+            if (hd44780_bus_errors(lcd) > 0) {
+                fprintf(stderr, " (%lu while busy, %lu short EN, %lu changed under EN)",
+                        lcd->early, lcd->short_pulse, lcd->unstable);
+            }
+            fprintf(stderr, "\n");
+            hd44780_print(&mock_lcd[i], stderr);
+        }
+    }
+    if (locked) {
+        pthread_mutex_unlock(&mock_lock);
+    }
+}
+
+static int signal_pipe[2] = {-1, -1};
+
+// The exercises loop until Ctrl-C; still write the timeline and the screen.
+// mock_exit() is no work for a signal handler, so the handler only wakes a
+// thread that exits on its behalf.
+static void mock_signal(int sig) {
+    unsigned char c = sig;
+    int saved = errno;
+
+    if (write(signal_pipe[1], &c, 1) != 1) {
+        _exit(128 + sig);
+    }
+    errno = saved;
+}
+
+static void *signal_thread(void *arg) {
+    unsigned char c;
+    ssize_t n;
+
+    (void)arg;
+    while ((n = read(signal_pipe[0], &c, 1)) < 0 && errno == EINTR) {
+    }
+    exit(n == 1 ? 128 + c : 1);
+    return NULL;
+}
+
+static void catch_signals(void) {
+    struct sigaction sa;
+    pthread_t tid;
+
+    if (pipe(signal_pipe) != 0) {
+        return;
+    }
+    if (pthread_create(&tid, NULL, signal_thread, NULL) != 0) {
+        close(signal_pipe[0]);
+        close(signal_pipe[1]);
+        return;
+    }
+    pthread_detach(tid);
+
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = mock_signal;
+    sa.sa_flags = SA_RESTART;
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+}
+
+static void parse_devices(const char *list) {
+    static const struct {
+        const char *name;
+        int bit;
+    } names[] = {
+        {"lcd", MOCK_DEV_LCD}, {"keypad", MOCK_DEV_KEYPAD}, {"seg7", MOCK_DEV_SEG7}, {"led", MOCK_DEV_LED}
+    };
+
+    mock_devices = 0;
+    for (unsigned i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        if (strstr(list, names[i].name) != NULL) {
+            mock_devices |= names[i].bit;
+        }
+    }
+}
+
+void __attribute__((constructor)) mock_board_init(void) {
+    const char *devices = getenv("MOCK_DEVICES");
+    const char *script_path = getenv("MOCK_SCRIPT");
+    const char *v = getenv("MOCK_VERBOSE");
+
+    start_ns = mock_now_ns();
+    verbose = v != NULL && *v != '0';
+    if (devices != NULL) {
+        parse_devices(devices);
+    }
+
+    for (int i = 0; i < MOCK_MAX_PINS; i++) {
+        pins[i].level = -1;
+        pins[i].input = -1;
+        pins[i].mode = -1;
+    }
+    hd44780_reset(&mock_lcd[MOCK_LCD_GPIO]);
+    hd44780_reset(&mock_lcd[MOCK_LCD_I2C]);
+
+    timeline_path = getenv("MOCK_TIMELINE");
+    if (timeline_path != NULL) {
+        events = malloc(MOCK_MAX_EVENTS * sizeof(event_t));
+    }
+
+    if (script_path != NULL) {
+        pthread_t tid;
+        load_script(script_path);
+        if (num_script > 0 && pthread_create(&tid, NULL, script_thread, NULL) == 0) {
+            pthread_detach(tid);
+        }
+    }
+    atexit(mock_exit);
+    catch_signals();
+}
+
+// ---- mraa ----
+
+mraa_result_t mraa_init(void) {
+    return MRAA_SUCCESS;
+}
+
+void mraa_deinit(void) {
+}
+
+const char *mraa_get_version(void) {
+    return "mock";
+}
+
+mraa_gpio_context mraa_gpio_init(int pin) {
+    if (pin < 0 || pin >= MOCK_MAX_PINS) {
+        return NULL;
+    }
+    mraa_gpio_context dev = malloc(sizeof(*dev));
+    if (dev != NULL) {
+        dev->pin = pin;
+    }
+    return dev;
+}
+
+mraa_result_t mraa_gpio_dir(mraa_gpio_context dev, mraa_gpio_dir_t dir) {
+    if (dev == NULL) {
+        return MRAA_ERROR_INVALID_HANDLE;
+    }
+    pthread_mutex_lock(&mock_lock);
+    pins[dev->pin].out = dir != MRAA_GPIO_IN;
+    if (dir == MRAA_GPIO_OUT_HIGH || dir == MRAA_GPIO_OUT_LOW) {
+        drive(dev->pin, dir == MRAA_GPIO_OUT_HIGH);
+    } else if (dir == MRAA_GPIO_OUT && pins[dev->pin].level < 0) {
+        drive(dev->pin, 0);
+    }
+    pthread_mutex_unlock(&mock_lock);
+    return MRAA_SUCCESS;
+}
+
+mraa_result_t mraa_gpio_mode(mraa_gpio_context dev, mraa_gpio_mode_t mode) {
+    if (dev == NULL) {
+        return MRAA_ERROR_INVALID_HANDLE;
+    }
+    pthread_mutex_lock(&mock_lock);
+    pins[dev->pin].mode = mode;
+    pthread_mutex_unlock(&mock_lock);
+    return MRAA_SUCCESS;
+}
+
+int mraa_gpio_read(mraa_gpio_context dev) {
+    if (dev == NULL) {
+        return -1;
+    }
+    pthread_mutex_lock(&mock_lock);
+    int value = sample(dev->pin);
+    pthread_mutex_unlock(&mock_lock);
+    return value;
+}
+
+mraa_result_t mraa_gpio_write(mraa_gpio_context dev, int value) {
+    if (dev == NULL) {
+        return MRAA_ERROR_INVALID_HANDLE;
+    }
+    pthread_mutex_lock(&mock_lock);
+    drive(dev->pin, value != 0);
+    pthread_mutex_unlock(&mock_lock);
+    return MRAA_SUCCESS;
+}
+
+int mraa_gpio_get_pin(mraa_gpio_context dev) {
+    return dev ? dev->pin : -1;
+}
+
+mraa_result_t mraa_gpio_close(mraa_gpio_context dev) {
+    free(dev);
+    return MRAA_SUCCESS;
+}
@@ -0,0 +1,73 @@
+#ifndef MOCK_INTERNAL_H
+#define MOCK_INTERNAL_H
+
+#include <pthread.h>
+#include <stdint.h>
+#include <stdio.h>
+#include "mraa.h"
+#include "mock.h"
+
+#define MOCK_MAX_PINS 256
+#define MOCK_LCD_ROWS 2
+#define MOCK_LCD_COLS 16
+
+// Devices selected with $MOCK_DEVICES
+#define MOCK_DEV_LCD    0x01
+#define MOCK_DEV_KEYPAD 0x02
+#define MOCK_DEV_SEG7   0x04
+#define MOCK_DEV_LED    0x08
+
+// Everything below is guarded by mock_lock
+extern pthread_mutex_t mock_lock;
+extern int mock_devices;
+
+uint64_t mock_now_ns(void);
+uint64_t mock_elapsed_ns(void);   // since program start
+void mock_board_init(void);
+
+// Record a timeline event (caller holds mock_lock)
+void mock_event(const char *fmt, ...) __attribute__((format(printf, 1, 2)));
+
+// ---- HD44780 controller model (hd44780.c) ----
+
+typedef struct {
+    int eight_bit;            // interface width, changed by function set
+    int two_lines;
+    int half;                 // 4-bit mode: 1 after the high nibble
+    uint8_t high;             // the high nibble latched so far
+    int display_on;
+    int increment;
+    int shift;                // display shift, in columns
+    int cgram;                // 1 when data goes to CGRAM
+    uint8_t ac;               // address counter
+    uint8_t ddram[128];
+    uint8_t cgram_data[64];
+    uint64_t strobes;
+    int used;
+
+    // Bus checks: strobes while the last instruction still ran, EN pulses
+    // shorter than 450 ns, RS/RW/data changing while EN was high
+    uint64_t busy_until_ns;
+    unsigned long early, short_pulse, unstable;
+} hd44780_t;
+
+extern hd44780_t mock_lcd[2];   // indexed by mock_lcd_t
+
+void hd44780_reset(hd44780_t *lcd);
+
+// One falling edge of EN: 'bus' holds D7..D0 (only D7..D4 in 4-bit mode)
+void hd44780_strobe(hd44780_t *lcd, mock_lcd_t which, int rs, uint8_t bus);
+
+unsigned long hd44780_bus_errors(const hd44780_t *lcd);
+
+// Visible text of a row, non-ASCII (e.g. CGRAM glyphs) shown as '#'
+void hd44780_row(const hd44780_t *lcd, int row, char *out);
+
+// The screen in a box
+void hd44780_print(const hd44780_t *lcd, FILE *out);
+
+// ---- analog (mock_analog.c) ----
+
+int mock_adc_value(int pin);
+
+#endif
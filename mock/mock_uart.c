@@ -0,0 +1,248 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <pty.h>
+#include <termios.h>
+#include <unistd.h>
+#include "mock_internal.h"
+
+struct _uart {
+    int fd;
+    int peer;              // far end of the pty, held until a terminal attaches
+    char path[64];         // what the program asked for
+    char tty[64];          // the pty behind it, for mraa_uart_get_dev_path()
+    char link[128];
+};
+
+static void make_raw(int fd) {
+    struct termios tio;
+
+    if (tcgetattr(fd, &tio) == 0) {
+        cfmakeraw(&tio);
+        tcsetattr(fd, TCSANOW, &tio);
+    }
+}
+
+// Wire TX back to RX, like a jumper on the header
+static void *loopback_thread(void *arg) {
+    int fd = (int)(intptr_t)arg;
+    char buf[256];
+
+    while (1) {
+        ssize_t n = read(fd, buf, sizeof(buf));
+        if (n <= 0) {
+            if (n < 0 && errno == EINTR) {
+                continue;
+            }
+            break;
+        }
+        for (ssize_t off = 0; off < n;) {
+            ssize_t w = write(fd, buf + off, n - off);
+            if (w <= 0) {
+                return NULL;
+            }
+            off += w;
+        }
+    }
+    return NULL;
+}
+
+// A board UART: the program gets the master side of a pty, the slave side
+// is what a terminal program (or the loopback) talks to
+static int open_virtual(mraa_uart_context dev) {
+    const char *dir = getenv("MOCK_UART_DIR");
+    const char *loop = getenv("MOCK_UART_LOOPBACK");
+    const char *base = strrchr(dev->path, '/');
+    char slave[64];
+    int master, peer;
+
+    if (openpty(&master, &peer, slave, NULL, NULL) != 0) {
+        fprintf(stderr, "mock: openpty failed: %s\n", strerror(errno));
+        return -1;
+    }
+    make_raw(master);
+    make_raw(peer);
+    dev->fd = master;
+    snprintf(dev->tty, sizeof(dev->tty), "%s", slave);
+
+    if (loop != NULL && *loop != '0') {
+        pthread_t tid;
+        if (pthread_create(&tid, NULL, loopback_thread, (void *)(intptr_t)peer) != 0) {
+            close(peer);
+            return -1;
+        }
+        pthread_detach(tid);
+        fprintf(stderr, "mock: %s is looped back\n", dev->path);
+        return 0;
+    }
+
+    // Keep the slave open so reads see no hangup before a terminal attaches
+    dev->peer = peer;
+    snprintf(dev->link, sizeof(dev->link), "%s/mock-%s", dir ? dir : "/tmp", base ? base + 1 : dev->path);
+    unlink(dev->link);
+    if (symlink(slave, dev->link) != 0) {
+        dev->link[0] = '\0';
+        fprintf(stderr, "mock: %s is %s\n", dev->path, slave);
+    } else {
+        fprintf(stderr, "mock: %s is %s (%s)\n", dev->path, slave, dev->link);
+    }
+    return 0;
+}
+
+mraa_uart_context mraa_uart_init_raw(const char *path) {
+    mraa_uart_context dev = calloc(1, sizeof(*dev));
+
+    if (dev == NULL || path == NULL) {
+        free(dev);
+        return NULL;
+    }
+    dev->fd = -1;
+    dev->peer = -1;
+    snprintf(dev->path, sizeof(dev->path), "%s", path);
+
+    if (strncmp(path, "/dev/tty", 8) == 0) {
+        if (open_virtual(dev) != 0) {
+            mraa_uart_stop(dev);
+            return NULL;
+        }
+        return dev;
+    }
+
+    dev->fd = open(path, O_RDWR | O_NOCTTY | O_CLOEXEC);
+    if (dev->fd < 0) {
+        free(dev);
+        return NULL;
+    }
+    make_raw(dev->fd);
+    return dev;
+}
+
+mraa_uart_context mraa_uart_init(int uart) {
+    char path[32];
+
+    snprintf(path, sizeof(path), "/dev/ttyS%d", uart);
+    return mraa_uart_init_raw(path);
+}
+
+mraa_result_t mraa_uart_set_baudrate(mraa_uart_context dev, unsigned int baud) {
+    struct termios tio;
+    speed_t speed;
+
+    if (dev == NULL) {
+        return MRAA_ERROR_INVALID_HANDLE;
+    }
+    switch (baud) {
+    case 9600: speed = B9600; break;
+    case 19200: speed = B19200; break;
+    case 38400: speed = B38400; break;
+    case 57600: speed = B57600; break;
+    case 115200: speed = B115200; break;
+    case 230400: speed = B230400; break;
+    case 460800: speed = B460800; break;
+    case 921600: speed = B921600; break;
+    default: return MRAA_ERROR_INVALID_PARAMETER;
+    }
+
+    // A pty ignores the speed, but keep it visible to tcgetattr()
+    if (tcgetattr(dev->fd, &tio) == 0) {
+        cfsetispeed(&tio, speed);
+        cfsetospeed(&tio, speed);
+        tcsetattr(dev->fd, TCSANOW, &tio);
+    }
+    return MRAA_SUCCESS;
+}
+
+mraa_result_t mraa_uart_set_mode(mraa_uart_context dev, int bytesize, mraa_uart_parity_t parity, int stopbits) {
+    if (dev == NULL) {
+        return MRAA_ERROR_INVALID_HANDLE;
+    }
+    if (bytesize < 5 || bytesize > 8 || parity > MRAA_UART_PARITY_SPACE || stopbits < 1 || stopbits > 2) {
+        return MRAA_ERROR_INVALID_PARAMETER;
+    }
+    return MRAA_SUCCESS;
+}
+
+mraa_result_t mraa_uart_set_flowcontrol(mraa_uart_context dev, mraa_boolean_t xonxoff, mraa_boolean_t rtscts) {
+    (void)xonxoff;
+    (void)rtscts;
+    return dev ? MRAA_SUCCESS : MRAA_ERROR_INVALID_HANDLE;
+}
+
+mraa_result_t mraa_uart_set_timeout(mraa_uart_context dev, int read, int write, int interchar) {
+    (void)read;
+    (void)write;
+    (void)interchar;
+    return dev ? MRAA_SUCCESS : MRAA_ERROR_INVALID_HANDLE;
+}
+
+mraa_result_t mraa_uart_set_non_blocking(mraa_uart_context dev, mraa_boolean_t nonblock) {
+    if (dev == NULL) {
+        return MRAA_ERROR_INVALID_HANDLE;
+    }
+    int flags = fcntl(dev->fd, F_GETFL);
+    flags = nonblock ? (flags | O_NONBLOCK) : (flags & ~O_NONBLOCK);
+    return fcntl(dev->fd, F_SETFL, flags) == 0 ? MRAA_SUCCESS : MRAA_ERROR_UNSPECIFIED;
+}
+
+const char *mraa_uart_get_dev_path(mraa_uart_context dev) {
+    if (dev == NULL) {
+        return NULL;
+    }
+    // The pty that is really open, so that settings made through the path
+    // reach it (both ends share one termios)
+    return dev->tty[0] != '\0' ? dev->tty : dev->path;
+}
+
+int mraa_uart_read(mraa_uart_context dev, char *buf, size_t length) {
+    if (dev == NULL) {
+        return -1;
+    }
+    return (int)read(dev->fd, buf, length);
+}
+
+int mraa_uart_write(mraa_uart_context dev, const char *buf, size_t length) {
+    if (dev == NULL) {
+        return -1;
+    }
+    return (int)write(dev->fd, buf, length);
+}
+
+mraa_boolean_t mraa_uart_data_available(mraa_uart_context dev, unsigned int millis) {
+    struct pollfd pfd;
+
+    if (dev == NULL) {
+        return 0;
+    }
+    pfd.fd = dev->fd;
+    pfd.events = POLLIN;
+    return poll(&pfd, 1, millis) > 0 && (pfd.revents & POLLIN);
+}
+
+mraa_result_t mraa_uart_flush(mraa_uart_context dev) {
+    if (dev == NULL) {
+        return MRAA_ERROR_INVALID_HANDLE;
+    }
+    return tcdrain(dev->fd) == 0 ? MRAA_SUCCESS : MRAA_ERROR_UNSPECIFIED;
+}
+
+mraa_result_t mraa_uart_stop(mraa_uart_context dev) {
+    if (dev == NULL) {
+        return MRAA_ERROR_INVALID_HANDLE;
+    }
+    if (dev->link[0] != '\0') {
+        unlink(dev->link);
+    }
+    if (dev->fd >= 0) {
+        close(dev->fd);
+    }
+    // A loopback thread owns its end and sees the hangup instead
+    if (dev->peer >= 0) {
+        close(dev->peer);
+    }
+    free(dev);
+    return MRAA_SUCCESS;
+}